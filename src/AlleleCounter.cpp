@@ -0,0 +1,115 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AlleleCounter.h"
+#include "VcfRecord.h"
+
+AlleleCounter::AlleleCounter()
+    : myCounts(),
+      myTotal(0),
+      myFastAlt(0),
+      myFastCalled(0)
+{
+}
+
+
+void AlleleCounter::reset(int numAlleles)
+{
+    myCounts.assign(numAlleles, 0);
+    myTotal = 0;
+    myFastAlt = 0;
+    myFastCalled = 0;
+}
+
+
+int AlleleCounter::count(VcfRecord& record)
+{
+    static const std::string GT_FIELD = "GT";
+
+    reset(record.getNumAlts() + 1);
+    VcfRecordGenotype& genotypes = record.getGenotypeInfo();
+    int numSamples = record.getNumSamples();
+    for(int i = 0; i < numSamples; i++)
+    {
+        const std::string* gt = genotypes.getString(GT_FIELD, i);
+        if(gt != NULL)
+        {
+            add(gt->c_str(), gt->length());
+        }
+    }
+    return(getTotal());
+}
+
+
+int AlleleCounter::getMinCount() const
+{
+    int numAlleles = myCounts.size();
+    if((numAlleles < 2) && (myFastAlt != 0))
+    {
+        // The fast path counted alt alleles at a site without alts.
+        numAlleles = 2;
+    }
+    int minCount = -1;
+    for(int i = 0; i < numAlleles; i++)
+    {
+        int count = getCount(i);
+        if((minCount == -1) || (count < minCount))
+        {
+            minCount = count;
+        }
+    }
+    return(minCount);
+}
+
+
+void AlleleCounter::addSlow(const char* gt, int len)
+{
+    // Alleles are separated by '/' or '|'; '.' is a missing allele.
+    const char* end = gt + len;
+    while(gt < end)
+    {
+        if(*gt == '.')
+        {
+            ++gt;
+        }
+        else if((*gt >= '0') && (*gt <= '9'))
+        {
+            int allele = 0;
+            while((gt < end) && (*gt >= '0') && (*gt <= '9'))
+            {
+                allele = (allele * 10) + (*gt - '0');
+                ++gt;
+            }
+            addAllele(allele);
+        }
+        else
+        {
+            // Not a GT allele, so stop.
+            return;
+        }
+
+        if((gt < end) && ((*gt == '/') || (*gt == '|')))
+        {
+            ++gt;
+        }
+        else
+        {
+            // Past the last allele.
+            return;
+        }
+    }
+}
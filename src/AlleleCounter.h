@@ -0,0 +1,108 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __ALLELE_COUNTER_H__
+#define __ALLELE_COUNTER_H__
+
+#include <vector>
+
+class VcfRecord;
+
+/// Counts every allele of a site in a single pass over the GTs, rather
+/// than rescanning all of the GTs for each allele.
+/// Diploid GTs with 0/1 alleles ("0/0", "0|1", ...) are counted with a
+/// branch free fast path that only tracks the number of alt alleles and
+/// called alleles; all other GTs (multi-allelic, missing, haploid, or
+/// more than diploid) are parsed into the per allele histogram.
+class AlleleCounter
+{
+public:
+    AlleleCounter();
+
+    /// Clear the counts for a site with the specified number of alleles
+    /// (including the reference).
+    void reset(int numAlleles);
+
+    /// Count the alleles of all of the record's samples.
+    /// Returns the total number of called alleles (AN).
+    int count(VcfRecord& record);
+
+    /// Add the alleles of the specified GT text (need not be terminated).
+    inline void add(const char* gt, int len)
+    {
+        if(len == 3)
+        {
+            unsigned int allele1 = (unsigned char)gt[0] - '0';
+            unsigned int allele2 = (unsigned char)gt[2] - '0';
+            if(((allele1 | allele2) <= 1) && ((gt[1] == '/') || (gt[1] == '|')))
+            {
+                myFastAlt += allele1 + allele2;
+                myFastCalled += 2;
+                return;
+            }
+        }
+        addSlow(gt, len);
+    }
+
+    /// Add 1 called allele.
+    inline void addAllele(int allele)
+    {
+        if(allele >= (int)myCounts.size())
+        {
+            myCounts.resize(allele + 1, 0);
+        }
+        ++myCounts[allele];
+        ++myTotal;
+    }
+
+    /// Get the number of alleles counts are kept for.
+    int getNumAlleles() const { return(myCounts.size()); }
+
+    /// Get the count of the specified allele (0 is the reference).
+    int getCount(int allele) const
+    {
+        int count = (allele < (int)myCounts.size()) ? myCounts[allele] : 0;
+        if(allele == 0)
+        {
+            count += myFastCalled - myFastAlt;
+        }
+        else if(allele == 1)
+        {
+            count += myFastAlt;
+        }
+        return(count);
+    }
+
+    /// Get the total number of called alleles (AN).
+    int getTotal() const { return(myTotal + myFastCalled); }
+
+    /// Get the smallest count of any allele, including the reference.
+    int getMinCount() const;
+
+private:
+    void addSlow(const char* gt, int len);
+
+    std::vector<int> myCounts;
+    int myTotal;
+    // Counts from the diploid 0/1 fast path.
+    int myFastAlt;
+    int myFastCalled;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __BOUNDED_QUEUE_H__
+#define __BOUNDED_QUEUE_H__
+
+#include <pthread.h>
+#include <deque>
+
+/// Fixed capacity FIFO for handing items between threads.
+/// push blocks while the queue is full and pop blocks while it is empty
+/// until the queue is closed.
+template <class T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(unsigned int capacity)
+        : myItems(),
+          myCapacity(capacity),
+          myClosed(false)
+    {
+        pthread_mutex_init(&myLock, NULL);
+        pthread_cond_init(&myNotEmpty, NULL);
+        pthread_cond_init(&myNotFull, NULL);
+    }
+
+    ~BoundedQueue()
+    {
+        pthread_cond_destroy(&myNotFull);
+        pthread_cond_destroy(&myNotEmpty);
+        pthread_mutex_destroy(&myLock);
+    }
+
+    /// Add an item, waiting for room if the queue is full.
+    /// Returns false (without adding) if the queue has been closed.
+    bool push(const T& item)
+    {
+        pthread_mutex_lock(&myLock);
+        while(!myClosed && (myItems.size() >= myCapacity))
+        {
+            pthread_cond_wait(&myNotFull, &myLock);
+        }
+        if(myClosed)
+        {
+            pthread_mutex_unlock(&myLock);
+            return(false);
+        }
+        myItems.push_back(item);
+        pthread_cond_signal(&myNotEmpty);
+        pthread_mutex_unlock(&myLock);
+        return(true);
+    }
+
+    /// Remove the oldest item, waiting for one if the queue is empty.
+    /// Returns false once the queue is closed and empty.
+    bool pop(T& item)
+    {
+        pthread_mutex_lock(&myLock);
+        while(!myClosed && myItems.empty())
+        {
+            pthread_cond_wait(&myNotEmpty, &myLock);
+        }
+        if(myItems.empty())
+        {
+            pthread_mutex_unlock(&myLock);
+            return(false);
+        }
+        item = myItems.front();
+        myItems.pop_front();
+        pthread_cond_signal(&myNotFull);
+        pthread_mutex_unlock(&myLock);
+        return(true);
+    }
+
+    /// No more items will be pushed; wakes up all waiting threads.
+    /// Items already in the queue can still be popped.
+    void close()
+    {
+        pthread_mutex_lock(&myLock);
+        myClosed = true;
+        pthread_cond_broadcast(&myNotEmpty);
+        pthread_cond_broadcast(&myNotFull);
+        pthread_mutex_unlock(&myLock);
+    }
+
+private:
+    BoundedQueue();
+    BoundedQueue(const BoundedQueue&);
+    BoundedQueue& operator=(const BoundedQueue&);
+
+    std::deque<T> myItems;
+    unsigned int myCapacity;
+    bool myClosed;
+    pthread_mutex_t myLock;
+    pthread_cond_t myNotEmpty;
+    pthread_cond_t myNotFull;
+};
+
+#endif
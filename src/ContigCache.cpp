@@ -0,0 +1,52 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ContigCache.h"
+
+ContigCache::ContigCache(const GenomeSequence& reference)
+    : myReference(&reference),
+      myChrom(),
+      myStart(0),
+      myLength(0),
+      myFound(false)
+{
+}
+
+
+bool ContigCache::setContig(const char* chrom, int chromLen)
+{
+    if(!myChrom.empty() && (myChrom.size() == (unsigned int)chromLen) &&
+       (myChrom.compare(0, chromLen, chrom, chromLen) == 0))
+    {
+        // Same contig as the previous lookup.
+        return(myFound);
+    }
+    myChrom.assign(chrom, chromLen);
+    int chromIndex = myReference->getChromosome(myChrom.c_str());
+    myFound = (chromIndex >= 0);
+    if(myFound)
+    {
+        myStart = myReference->getGenomePosition(myChrom.c_str());
+        myLength = myReference->getChromosomeSize(chromIndex);
+    }
+    else
+    {
+        myStart = 0;
+        myLength = 0;
+    }
+    return(myFound);
+}
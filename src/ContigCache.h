@@ -0,0 +1,72 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __CONTIG_CACHE_H__
+#define __CONTIG_CACHE_H__
+
+#include <string>
+
+#include "GenomeSequence.h"
+
+/// Caches the reference location of the last contig that was looked up,
+/// so sorted VCF records only look up each contig when it changes.
+class ContigCache
+{
+public:
+    ContigCache(const GenomeSequence& reference);
+
+    /// Point the cache at the specified contig name (need not be
+    /// terminated), only looking it up if it differs from the current one.
+    /// Returns false if the contig is not in the reference.
+    bool setContig(const char* chrom, int chromLen);
+
+    /// Get the name of the current contig.
+    const std::string& getContig() const { return(myChrom); }
+
+    /// Get the length of the current contig, 0 if it is not in the
+    /// reference.
+    genomeIndex_t getLength() const { return(myLength); }
+
+    /// Return whether the len bases starting at the 1-based position are
+    /// all within the current contig.
+    bool contains(unsigned long pos, unsigned long len) const
+    {
+        return((pos >= 1) && ((pos - 1 + len) <= myLength));
+    }
+
+    /// Get the base at the 1-based position of the current contig, which
+    /// must be within the contig.
+    char getBase(unsigned long pos) const
+    {
+        return((*myReference)[myStart + pos - 1]);
+    }
+
+private:
+    ContigCache();
+
+    const GenomeSequence* myReference;
+    std::string myChrom;
+    // Genome index of the contig's first base.
+    genomeIndex_t myStart;
+    genomeIndex_t myLength;
+    // false if the contig is not in the reference.
+    bool myFound;
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FrozenIntervalTree.h"
+
+/* Copies the intervals of provided tree. The tree can be changed or deleted afterwards. */
+template <class T>
+FrozenIntervalTree<T>::FrozenIntervalTree(IntervalTree<T>& tree) {
+	vector<Interval<T>*> intervals;
+	tree.get_inordered(tree.get_intervals_count(), intervals);
+
+	int n = intervals.size();
+	deviations.resize(n);
+	first_values.resize(n + 1);
+
+	for (int i = 0; i < n; i++) {
+		index.add(intervals[i]->start, intervals[i]->end, i);
+		deviations[i] = intervals[i]->deviation;
+		first_values[i] = values.size();
+		tree.append_values(intervals[i], values);
+	}
+	first_values[n] = values.size();
+
+	index.build();
+}
+
+template <class T>
+FrozenIntervalTree<T>::~FrozenIntervalTree() {
+
+}
+
+template <class T>
+void FrozenIntervalTree<T>::append_values(int interval, vector<T>& result) const {
+	result.insert(result.end(), values.begin() + first_values[interval], values.begin() + first_values[interval + 1]);
+}
+
+/* Returns values of all intervals that intersect with provided position. */
+template <class T>
+void FrozenIntervalTree<T>::get_intersecting_intervals(int position, vector<T>& result) const {
+	get_intersecting_intervals(position, position, result);
+}
+
+/*
+ *	Returns values of all intervals that intersect with provided interval.
+ *	Note:	It is assumed that provided start point is equal to or less than provided end point.
+ */
+template <class T>
+void FrozenIntervalTree<T>::get_intersecting_intervals(int start, int end, vector<T>& result) const {
+	vector<int> intervals;
+	index.getIntersecting(start, end, intervals);
+
+	for (unsigned int i = 0; i < intervals.size(); i++) {
+		append_values(intervals[i], result);
+	}
+}
+
+/* Marks all intervals that intersect with provided position. */
+template <class T>
+void FrozenIntervalTree<T>::mark_intersecting_intervals(int position, int deviation, Marks& marks) const {
+	mark_intersecting_intervals(position, position, deviation, marks);
+}
+
+/*
+ *	Marks all intervals that intersect with provided interval.
+ *	Note:	It is assumed that provided start point is equal to or less than provided end point.
+ */
+template <class T>
+void FrozenIntervalTree<T>::mark_intersecting_intervals(int start, int end, int deviation, Marks& marks) const {
+	vector<int> intervals;
+	index.getIntersecting(start, end, intervals);
+
+	for (unsigned int i = 0; i < intervals.size(); i++) {
+		marks.deviations[intervals[i]] = deviation;
+	}
+}
+
+/* Get all values with respect to their deviations in provided marks. */
+template <class T>
+void FrozenIntervalTree<T>::get_marked_values(const Marks& marks, map<int, vector<T>* >& values) const {
+	typename map<int, vector<T>* >::iterator values_it;
+
+	for (unsigned int i = 0; i < deviations.size(); i++) {
+		values_it = values.find(marks.deviations[i]);
+
+		if (values_it == values.end()) {
+			values_it = values.insert(pair<int, vector<T>* >(marks.deviations[i], new vector<T>())).first;
+		}
+
+		append_values(i, *((*values_it).second));
+	}
+}
+
+/* Returns the number of values stored in the snapshot. */
+template <class T>
+int FrozenIntervalTree<T>::get_values_count() const {
+	return values.size();
+}
+
+/* Returns the number of distinct intervals in the snapshot. */
+template <class T>
+int FrozenIntervalTree<T>::get_intervals_count() const {
+	return deviations.size();
+}
+
+template <class T>
+FrozenIntervalTree<T>::Marks::Marks(const FrozenIntervalTree<T>& tree):deviations(tree.deviations) {
+
+}
+
+template <class T>
+void FrozenIntervalTree<T>::Marks::reset(const FrozenIntervalTree<T>& tree) {
+	deviations = tree.deviations;
+}
+
+template class FrozenIntervalTree<int>;
+template class FrozenIntervalTree<char*>;
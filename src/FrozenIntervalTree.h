@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FROZENINTERVALTREE_H_
+#define FROZENINTERVALTREE_H_
+
+#include <map>
+#include <vector>
+#include "IntervalTree.h"
+#include "IntervalIndex.h"
+
+using namespace std;
+
+/*
+ *	Immutable snapshot of an IntervalTree that can be queried by any number of threads at once without locks.
+ *	All queries are const, and marking is done in a Marks object owned by the caller (one per thread)
+ *	instead of in the tree's nodes.
+ *	The intervals are searched with an IntervalIndex of their numbers, and all values are kept in one shared array.
+ *	Note:	Values are copied as is, so for IntervalTree<char*> the snapshot must not outlive the tree.
+ */
+template <class T>
+class FrozenIntervalTree {
+public:
+	/* Per query marking state: the deviation of each interval of one snapshot. */
+	class Marks {
+	private:
+		friend class FrozenIntervalTree<T>;
+		vector<int> deviations;
+
+	public:
+		Marks(const FrozenIntervalTree<T>& tree);
+
+		/* Restores the deviations the intervals had in the tree. */
+		void reset(const FrozenIntervalTree<T>& tree);
+	};
+
+private:
+	/* Index of the number of each interval. */
+	IntervalIndex<int> index;
+	vector<int> deviations;
+	/* Values of interval i are values[first_values[i]] to values[first_values[i + 1] - 1]. */
+	vector<int> first_values;
+	vector<T> values;
+
+	void append_values(int interval, vector<T>& result) const;
+
+public:
+	FrozenIntervalTree(IntervalTree<T>& tree);
+	virtual ~FrozenIntervalTree();
+
+	/* Queries */
+	void get_intersecting_intervals(int position, vector<T>& result) const;
+	void get_intersecting_intervals(int start, int end, vector<T>& result) const;
+	void mark_intersecting_intervals(int position, int deviation, Marks& marks) const;
+	void mark_intersecting_intervals(int start, int end, int deviation, Marks& marks) const;
+
+	void get_marked_values(const Marks& marks, map<int, vector<T>* >& values) const;
+
+	/* Properties */
+	int get_values_count() const;
+	int get_intervals_count() const;
+};
+
+#endif
@@ -1,7 +1,10 @@
 #include <math.h>
 #include <limits.h>
+#include <stdexcept>
 
 #include "HyunVcfFile.h"
+#include "ReferenceManager.h"
+#include "AlleleCounter.h"
 
 std::vector<double> VcfHelper::vPhred2Err;
 StringArray VcfHelper::asChromNames;
@@ -347,6 +350,7 @@ BedFile::BedFile() {
   bRefIsAllele1 = true;
   pBedBuffer = NULL;
   nBytes = 0;
+  pGenomeSequence = NULL;
 }
 
 BedFile::~BedFile() {
@@ -434,17 +438,12 @@ void BedFile::openForRead(const char* bedFile, const char* bimFile, const char*
     }
   }
 
-  genomeSequence.setReferenceName(sRefFile.c_str());
-  genomeSequence.useMemoryMap(true);
-
-  if ( genomeSequence.open() ) {
-    // write a message that new index file is being created
-    if ( genomeSequence.create(false) ) {
-      throw HyunVcfFileException("Failed creating index file of the reference. Please check the file permission");
-    }
-    if ( genomeSequence.open() ) {
-      throw HyunVcfFileException("Failed opening index file of the reference.");
-    }
+  // the packed index of the reference is built once & shared by all jobs
+  try {
+    pGenomeSequence = &ReferenceManager::getReference(sRefFile.c_str());
+  }
+  catch ( std::runtime_error& e ) {
+    throw HyunVcfFileException("%s. Please check the file permission", e.what());
   }
 }
 
@@ -969,14 +968,14 @@ bool BedFile::iterateMarker() {
     
     pMarker->setPos(lineTokens[3]);
 
-    genomeIndex_t markerIndex = genomeSequence.getGenomePosition( lineTokens[0].c_str(), pMarker->nPos );
+    genomeIndex_t markerIndex = pGenomeSequence->getGenomePosition( lineTokens[0].c_str(), pMarker->nPos );
     if ( markerIndex == INVALID_GENOME_INDEX ) {
       // routines specific to BED file format
-      markerIndex = genomeSequence.getGenomePosition( strChr.c_str(), pMarker->nPos );
+      markerIndex = pGenomeSequence->getGenomePosition( strChr.c_str(), pMarker->nPos );
 
       if ( markerIndex == INVALID_GENOME_INDEX ) {
 	strChr = String("chr") + strChr;
-	markerIndex = genomeSequence.getGenomePosition( strChr.c_str(), pMarker->nPos );
+	markerIndex = pGenomeSequence->getGenomePosition( strChr.c_str(), pMarker->nPos );
 	if ( markerIndex == INVALID_GENOME_INDEX ) {
 	  throw HyunVcfFileException("Cannot parse chromosome name "+lineTokens[0]+" in BIM file");
 	}
@@ -990,7 +989,7 @@ bool BedFile::iterateMarker() {
     // if refBase matches a1 or a2, use it
     // if none matches and either is zero
     // do not allow for triallelic sites
-    char refBase = genomeSequence[markerIndex];
+    char refBase = (*pGenomeSequence)[markerIndex];
     char a1 = lineTokens[4][0];
     char a2 = lineTokens[5][0];
     char altBase = determineAltBase(refBase, a1,a2);
@@ -1324,17 +1323,21 @@ void VcfMarker::printVCFMarkerSubset(IFILE oFile, std::vector<int>& subsetIndice
   ANindex = asInfoKeys.Find("AN");
 
   int AN = 0; 
-  int ACs[3] = {0,0,0};
+  // Count the alleles of the subset in 1 pass, growing the counts
+  // for any allele past the 2nd ALT rather than overrunning them.
+  AlleleCounter alleleCounter;
+  alleleCounter.reset(3);
   for(int j=0; j < (int)subsetIndices.size(); ++j) {
     int i = subsetIndices[j];
     if ( vnSampleGenotypes[i] != 0xffff ) {
       AN += 2;
-      ++ACs[(vnSampleGenotypes[i] & 0xff00) >> 8];
+      alleleCounter.addAllele((vnSampleGenotypes[i] & 0xff00) >> 8);
       if ( (vnSampleGenotypes[i] & 0x00ff) != 0x00ff ) {
-	++ACs[(vnSampleGenotypes[i] & 0x00ff)];
+	alleleCounter.addAllele(vnSampleGenotypes[i] & 0x00ff);
       }
     }
   }
+  int ACs[3] = {alleleCounter.getCount(0), alleleCounter.getCount(1), alleleCounter.getCount(2)};
 
   if ( ( ACs[1] == 0 ) && ( ACs[2] == 0 ) ) {
     return;
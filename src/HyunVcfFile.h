@@ -259,7 +259,7 @@ class BedFile : public HyunVcfFile {
   bool bRefIsAllele1;
   char* pBedBuffer;
   int nBytes;
-  GenomeSequence genomeSequence;
+  const GenomeSequence* pGenomeSequence;
 
   void openForRead(const char* bfile, const char* reffile, int nbuf = 1);
   void openForRead(const char* bedFile, const char* bimFile, const char* famFile, const char* reffile, int nbuf = 1);
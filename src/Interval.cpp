@@ -26,7 +26,7 @@ const int Interval<T>::RED = 1;
 
 template <class T>
 Interval<T>::Interval(int start, int end, int max, T& value, int deviation, int color, Interval<T>* left, Interval<T>* right):
-	start(start), end(end), max(max), deviation(deviation), color(color), parent(NULL) {
+	start(start), end(end), max(max), first_value(-1), values_count(0), deviation(deviation), color(color), parent(NULL) {
 	values.push_back(value);
 
 	if (left != NULL) {
@@ -48,7 +48,7 @@ Interval<T>::Interval(int start, int end, int max, T& value, int deviation, int
 
 template<class T>
 Interval<T>::Interval(int start, int end, int max, vector<T>& values, int deviation, int color, Interval<T>* left, Interval<T>* right):
-	start(start), end(end), max(max), deviation(deviation), color(color), parent(NULL) {
+	start(start), end(end), max(max), first_value(-1), values_count(0), deviation(deviation), color(color), parent(NULL) {
 	this->values.insert(this->values.end(), values.begin(), values.end());
 
 	if (left != NULL) {
@@ -68,6 +68,13 @@ Interval<T>::Interval(int start, int end, int max, vector<T>& values, int deviat
 	}
 }
 
+/* Creates a bulk loaded interval whose values are stored by the tree. */
+template <class T>
+Interval<T>::Interval(int start, int end, int first_value, int values_count):
+	start(start), end(end), max(end), first_value(first_value), values_count(values_count), deviation(0), color(BLACK), parent(NULL), left(NULL), right(NULL) {
+
+}
+
 template <class T>
 Interval<T>::~Interval() {
 	parent = NULL;
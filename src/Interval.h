@@ -37,6 +37,9 @@ public:
 	int max;
 
 	vector<T> values;
+	/* Range of values shared in the tree's value array (bulk loaded nodes only), -1 otherwise */
+	int first_value;
+	int values_count;
 	int deviation;
 
 	int color;
@@ -46,6 +49,7 @@ public:
 
 	Interval(int start, int end, int max, T& value, int deviation, int color, Interval<T>* left, Interval<T>* right);
 	Interval(int start, int end, int max, vector<T>& values, int deviation, int color, Interval<T>* left, Interval<T>* right);
+	Interval(int start, int end, int first_value, int values_count);
 	virtual ~Interval();
 	Interval<T>* grandparent();
 	Interval<T>* sibling();
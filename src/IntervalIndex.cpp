@@ -0,0 +1,362 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "IntervalIndex.h"
+
+// Orders interval indices by start, then end, then the order added.
+class IntervalStartLess
+{
+public:
+    IntervalStartLess(const std::vector<int>& starts,
+                      const std::vector<int>& ends)
+        : myStarts(starts),
+          myEnds(ends)
+    {
+    }
+    bool operator()(int a, int b) const
+    {
+        if(myStarts[a] != myStarts[b])
+        {
+            return(myStarts[a] < myStarts[b]);
+        }
+        if(myEnds[a] != myEnds[b])
+        {
+            return(myEnds[a] < myEnds[b]);
+        }
+        return(a < b);
+    }
+private:
+    const std::vector<int>& myStarts;
+    const std::vector<int>& myEnds;
+};
+
+
+template <class T>
+IntervalIndex<T>::IntervalIndex()
+    : myStarts(),
+      myEnds(),
+      myValues(),
+      myMaxEnds(),
+      myMaxLevel(-1),
+      myBuilt(true)
+{
+}
+
+
+template <class T>
+IntervalIndex<T>::~IntervalIndex()
+{
+}
+
+
+template <class T>
+void IntervalIndex<T>::add(int start, int end, const T& value)
+{
+    myStarts.push_back(start);
+    myEnds.push_back(end);
+    myValues.push_back(value);
+    myBuilt = false;
+}
+
+
+template <class T>
+void IntervalIndex<T>::build()
+{
+    if(myBuilt)
+    {
+        return;
+    }
+    int n = myStarts.size();
+
+    // Sort the intervals by start.
+    std::vector<int> order(n);
+    for(int i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), IntervalStartLess(myStarts, myEnds));
+    std::vector<int> starts(n);
+    std::vector<int> ends(n);
+    std::vector<T> values;
+    values.reserve(n);
+    for(int i = 0; i < n; i++)
+    {
+        starts[i] = myStarts[order[i]];
+        ends[i] = myEnds[order[i]];
+        values.push_back(myValues[order[i]]);
+    }
+    myStarts.swap(starts);
+    myEnds.swap(ends);
+    myValues.swap(values);
+
+    // Build the implicit tree: the nodes at level k are the indices
+    // whose lowest k+1 bits are k 1s followed by a 0, so even indices
+    // are leaves and the children of node i at level k are i -/+ 2^(k-1).
+    myMaxEnds.assign(n, 0);
+    myMaxLevel = -1;
+    if(n > 0)
+    {
+        int lastIndex = 0;
+        int lastMax = 0;
+        for(int i = 0; i < n; i += 2)
+        {
+            lastIndex = i;
+            lastMax = myMaxEnds[i] = myEnds[i];
+        }
+        int k;
+        for(k = 1; (1 << k) <= n; k++)
+        {
+            int childOffset = 1 << (k - 1);
+            int step = childOffset << 2;
+            for(int i = (childOffset << 1) - 1; i < n; i += step)
+            {
+                // A right child past the end of the array stands in for
+                // the subtree holding the last interval.
+                int leftMax = myMaxEnds[i - childOffset];
+                int rightMax = (i + childOffset < n) ?
+                    myMaxEnds[i + childOffset] : lastMax;
+                myMaxEnds[i] = std::max(myEnds[i], std::max(leftMax, rightMax));
+            }
+            // Move to the ancestor of the last interval at this level.
+            lastIndex = ((lastIndex >> k) & 1) ?
+                lastIndex - childOffset : lastIndex + childOffset;
+            if((lastIndex < n) && (myMaxEnds[lastIndex] > lastMax))
+            {
+                lastMax = myMaxEnds[lastIndex];
+            }
+        }
+        myMaxLevel = k - 1;
+    }
+    myBuilt = true;
+}
+
+
+template <class T>
+void IntervalIndex<T>::clear()
+{
+    myStarts.clear();
+    myEnds.clear();
+    myValues.clear();
+    myMaxEnds.clear();
+    myMaxLevel = -1;
+    myBuilt = true;
+}
+
+
+template <class T>
+bool IntervalIndex<T>::overlaps(int position) const
+{
+    std::vector<int> indices;
+    findOverlaps(position, position, indices, true);
+    return(!indices.empty());
+}
+
+
+template <class T>
+void IntervalIndex<T>::getIntersecting(int position, std::vector<T>& result) const
+{
+    getIntersecting(position, position, result);
+}
+
+
+template <class T>
+void IntervalIndex<T>::getIntersecting(int start, int end, std::vector<T>& result) const
+{
+    std::vector<int> indices;
+    findOverlaps(start, end, indices, false);
+    for(unsigned int i = 0; i < indices.size(); i++)
+    {
+        result.push_back(myValues[indices[i]]);
+    }
+}
+
+
+template <class T>
+void IntervalIndex<T>::findOverlaps(int start, int end,
+                                    std::vector<int>& indices,
+                                    bool firstOnly) const
+{
+    // Subtrees at or below this level are scanned rather than searched.
+    static const int SCAN_LEVEL = 3;
+    struct StackEntry
+    {
+        int level;
+        int index;
+        // Whether the left subtree has been handled.
+        bool leftDone;
+    };
+
+    if(myMaxLevel < 0)
+    {
+        return;
+    }
+    int n = myStarts.size();
+    const int* starts = &(myStarts[0]);
+    const int* ends = &(myEnds[0]);
+    const int* maxEnds = &(myMaxEnds[0]);
+
+    // The tree is at most 32 levels deep, with 2 entries per level.
+    StackEntry stack[64];
+    int top = 0;
+    stack[top].level = myMaxLevel;
+    stack[top].index = (1 << myMaxLevel) - 1;
+    stack[top].leftDone = false;
+    ++top;
+    while(top > 0)
+    {
+        StackEntry node = stack[--top];
+        if(node.level <= SCAN_LEVEL)
+        {
+            // Small subtree, so check each interval in order.
+            int first = (node.index >> node.level) << node.level;
+            int last = first + (1 << (node.level + 1)) - 1;
+            if(last > n)
+            {
+                last = n;
+            }
+            for(int i = first; (i < last) && (starts[i] <= end); i++)
+            {
+                if(ends[i] >= start)
+                {
+                    indices.push_back(i);
+                    if(firstOnly)
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+        else if(!node.leftDone)
+        {
+            // Come back to this node after its left subtree.
+            int left = node.index - (1 << (node.level - 1));
+            stack[top] = node;
+            stack[top].leftDone = true;
+            ++top;
+            if((left >= n) || (maxEnds[left] >= start))
+            {
+                stack[top].level = node.level - 1;
+                stack[top].index = left;
+                stack[top].leftDone = false;
+                ++top;
+            }
+        }
+        else if((node.index < n) && (starts[node.index] <= end))
+        {
+            // Check this node, then its right subtree, which only
+            // has intervals starting at or after this one.
+            if(ends[node.index] >= start)
+            {
+                indices.push_back(node.index);
+                if(firstOnly)
+                {
+                    return;
+                }
+            }
+            stack[top].level = node.level - 1;
+            stack[top].index = node.index + (1 << (node.level - 1));
+            stack[top].leftDone = false;
+            ++top;
+        }
+    }
+}
+
+
+template <class T>
+IntervalIndex<T>::Cursor::Cursor(const IntervalIndex<T>& index)
+    : myIndex(&index),
+      myStarted(false),
+      myPosition(0),
+      myNext(0),
+      myActive()
+{
+}
+
+
+template <class T>
+bool IntervalIndex<T>::Cursor::overlaps(int position)
+{
+    moveTo(position);
+    return(!myActive.empty());
+}
+
+
+template <class T>
+void IntervalIndex<T>::Cursor::getIntersecting(int position, std::vector<T>& result)
+{
+    moveTo(position);
+    for(unsigned int i = 0; i < myActive.size(); i++)
+    {
+        result.push_back(myIndex->myValues[myActive[i]]);
+    }
+}
+
+
+template <class T>
+void IntervalIndex<T>::Cursor::reset()
+{
+    myStarted = false;
+    myPosition = 0;
+    myNext = 0;
+    myActive.clear();
+}
+
+
+template <class T>
+void IntervalIndex<T>::Cursor::moveTo(int position)
+{
+    const std::vector<int>& starts = myIndex->myStarts;
+    const std::vector<int>& ends = myIndex->myEnds;
+    int n = starts.size();
+
+    if(!myStarted || (position < myPosition))
+    {
+        // Search the index for the starting point.
+        myActive.clear();
+        myIndex->findOverlaps(position, position, myActive, false);
+        myNext = std::upper_bound(starts.begin(), starts.end(), position) - starts.begin();
+        myStarted = true;
+        myPosition = position;
+        return;
+    }
+    myPosition = position;
+
+    // Drop the intervals that ended before this position.
+    unsigned int numKept = 0;
+    for(unsigned int i = 0; i < myActive.size(); i++)
+    {
+        if(ends[myActive[i]] >= position)
+        {
+            myActive[numKept++] = myActive[i];
+        }
+    }
+    myActive.resize(numKept);
+
+    // Add the intervals that start at or before this position.
+    for(; (myNext < n) && (starts[myNext] <= position); myNext++)
+    {
+        if(ends[myNext] >= position)
+        {
+            myActive.push_back(myNext);
+        }
+    }
+}
+
+
+template class IntervalIndex<int>;
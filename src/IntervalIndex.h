@@ -0,0 +1,116 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __INTERVAL_INDEX_H__
+#define __INTERVAL_INDEX_H__
+
+#include <vector>
+
+/// Static index of 1-based inclusive intervals for fast overlap queries.
+/// Intervals are added, then build() is called once before querying.
+/// The intervals are kept in flat arrays sorted by start, with the
+/// maximum end of each subtree stored in an implicit binary tree laid
+/// out over the same array (as in cgranges), so there are no per node
+/// allocations or pointers to follow.
+/// A Cursor answers a series of increasing position queries, such as
+/// for the records of a sorted VCF, in amortized constant time.
+template <class T>
+class IntervalIndex
+{
+public:
+    /// Answers position queries in increasing order by walking the
+    /// intervals instead of searching the index for each position.
+    /// Moving to a smaller position falls back to searching the index.
+    /// The index must not be changed while a cursor is in use.
+    class Cursor
+    {
+    public:
+        Cursor(const IntervalIndex<T>& index);
+
+        /// Returns whether any interval contains the position.
+        bool overlaps(int position);
+
+        /// Append the values of the intervals containing the position.
+        void getIntersecting(int position, std::vector<T>& result);
+
+        /// Start over as if no positions have been queried.
+        void reset();
+
+    private:
+        Cursor();
+        void moveTo(int position);
+
+        const IntervalIndex<T>* myIndex;
+        bool myStarted;
+        int myPosition;
+        // Index of the first interval that starts after myPosition.
+        int myNext;
+        // Intervals that started at or before myPosition and end at or after it.
+        std::vector<int> myActive;
+    };
+
+    IntervalIndex();
+    ~IntervalIndex();
+
+    /// Add a 1-based inclusive interval.  Invalidates the index until
+    /// build() is called.
+    void add(int start, int end, const T& value);
+
+    /// Sort the intervals and build the index.
+    void build();
+
+    /// Remove all intervals.
+    void clear();
+
+    /// Returns the number of intervals.
+    int size() const { return(myStarts.size()); }
+
+    /// Get interval i, in order of start once built.
+    int getStart(int i) const { return(myStarts[i]); }
+    int getEnd(int i) const { return(myEnds[i]); }
+    const T& getValue(int i) const { return(myValues[i]); }
+
+    /// Returns whether any interval contains the position.
+    bool overlaps(int position) const;
+
+    /// Append the values of the intervals containing the position.
+    void getIntersecting(int position, std::vector<T>& result) const;
+
+    /// Append the values of the intervals overlapping start to end
+    /// (1-based inclusive).
+    void getIntersecting(int start, int end, std::vector<T>& result) const;
+
+private:
+    // Append the indices of the intervals overlapping start to end.
+    // Stops after the first if firstOnly is set.
+    void findOverlaps(int start, int end, std::vector<int>& indices,
+                      bool firstOnly) const;
+
+    // Interval i is myStarts[i] to myEnds[i], sorted by start.
+    std::vector<int> myStarts;
+    std::vector<int> myEnds;
+    std::vector<T> myValues;
+    // Maximum end of the subtree rooted at each index.
+    std::vector<int> myMaxEnds;
+    // Level of the root of the implicit tree, -1 if empty.
+    int myMaxLevel;
+    bool myBuilt;
+};
+
+#endif
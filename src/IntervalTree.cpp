@@ -17,10 +17,30 @@
  * along with GWAtoolbox.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include "IntervalTree.h"
 
+/* Orders interval indices by start and end points, used to sort input of bulk loading. */
+class IntervalOrder {
+private:
+	vector<int>& starts;
+	vector<int>& ends;
+
+public:
+	IntervalOrder(vector<int>& starts, vector<int>& ends):starts(starts), ends(ends) {
+
+	}
+
+	bool operator()(int a, int b) const {
+		if (starts[a] != starts[b]) {
+			return starts[a] < starts[b];
+		}
+		return ends[a] < ends[b];
+	}
+};
+
 template <class T>
-IntervalTree<T>::IntervalTree():root(NULL) {
+IntervalTree<T>::IntervalTree():root(NULL), sweep_cached(false) {
 
 }
 
@@ -37,6 +57,8 @@ void IntervalTree<T>::add(int start, int end, T& value) {
 
 template <class T>
 void IntervalTree<T>::add(int start, int end, T& value, int deviation) {
+	sweep_cached = false;
+
 	Interval<T>* new_interval = new Interval<T>(start, end, end, value, deviation, Interval<T>::RED, NULL, NULL);
 
 	if (root == NULL) {
@@ -91,6 +113,8 @@ void IntervalTree<T>::add_all(int start, int end, vector<T>& values) {
 
 template <class T>
 void IntervalTree<T>::add_all(int start, int end, vector<T>& values, int deviation) {
+	sweep_cached = false;
+
 	Interval<T>* new_interval = new Interval<T>(start, end, end, values, deviation, Interval<T>::RED, NULL, NULL);
 
 	if (root == NULL) {
@@ -138,6 +162,117 @@ void IntervalTree<T>::add_all(int start, int end, vector<T>& values, int deviati
 	balance(new_interval);
 }
 
+/*
+ *	Replaces the tree with provided intervals, building a balanced tree in O(n).
+ *	Intervals are expected to be sorted by start and end points (otherwise they are sorted first).
+ *	All nodes are allocated in one block and all values are stored in one shared array.
+ *	More intervals can still be added afterwards.
+ */
+template <class T>
+void IntervalTree<T>::build(vector<int>& starts, vector<int>& ends, vector<T>& values) {
+	erase_interval(root);
+	root = NULL;
+	arena.clear();
+	arena_values.clear();
+
+	int n = starts.size();
+	vector<int> order(n);
+	bool sorted = true;
+
+	for (int i = 0; i < n; i++) {
+		order[i] = i;
+		if ((i > 0) && ((starts[i] < starts[i - 1]) || ((starts[i] == starts[i - 1]) && (ends[i] < ends[i - 1])))) {
+			sorted = false;
+		}
+	}
+
+	if (!sorted) {
+		stable_sort(order.begin(), order.end(), IntervalOrder(starts, ends));
+	}
+
+	/* Count distinct intervals, so that nodes are never reallocated */
+	int distinct = 0;
+	for (int i = 0; i < n; i++) {
+		if ((i == 0) || (starts[order[i]] != starts[order[i - 1]]) || (ends[order[i]] != ends[order[i - 1]])) {
+			distinct += 1;
+		}
+	}
+
+	arena.reserve(distinct);
+	arena_values.reserve(n);
+
+	/* Equal intervals share one node */
+	for (int i = 0; i < n; i++) {
+		int k = order[i];
+
+		if (arena.empty() || (arena.back().start != starts[k]) || (arena.back().end != ends[k])) {
+			arena.push_back(Interval<T>(starts[k], ends[k], arena_values.size(), 0));
+		}
+
+		arena.back().values_count += 1;
+		arena_values.push_back(values[k]);
+	}
+
+	/*
+	 *	Only the last level can be incomplete (at depth floor(log2(distinct + 1))).
+	 *	Its nodes are red, so that all paths have the same number of black nodes.
+	 */
+	int red_depth = 0;
+	while ((1 << (red_depth + 1)) <= distinct + 1) {
+		red_depth += 1;
+	}
+
+	root = build_balanced(0, distinct - 1, 0, red_depth, NULL);
+
+	build_sweep_cache();
+}
+
+/* Links bulk loaded intervals from first to last into a balanced subtree and returns its root. */
+template <class T>
+Interval<T>* IntervalTree<T>::build_balanced(int first, int last, int depth, int red_depth, Interval<T>* parent) {
+	if (first > last) {
+		return NULL;
+	}
+
+	int middle = first + (last - first) / 2;
+	Interval<T>* interval = &arena[middle];
+
+	interval->parent = parent;
+	interval->color = (depth == red_depth) ? Interval<T>::RED : Interval<T>::BLACK;
+	interval->left = build_balanced(first, middle - 1, depth + 1, red_depth, interval);
+	interval->right = build_balanced(middle + 1, last, depth + 1, red_depth, interval);
+
+	calculate_max_end(interval);
+
+	return interval;
+}
+
+/* Appends all values of provided interval to result. */
+template <class T>
+void IntervalTree<T>::append_values(Interval<T>* interval, vector<T>& result) {
+	if (interval->first_value >= 0) {
+		result.insert(result.end(), arena_values.begin() + interval->first_value, arena_values.begin() + interval->first_value + interval->values_count);
+	}
+
+	result.insert(result.end(), interval->values.begin(), interval->values.end());
+}
+
+/*
+ *	Returns all values of provided interval.
+ *	Note:	Values of bulk loaded intervals are copied into scratch.
+ */
+template <class T>
+vector<T>& IntervalTree<T>::get_values(Interval<T>* interval, vector<T>& scratch) {
+	if (interval->first_value < 0) {
+		return interval->values;
+	}
+
+	scratch.clear();
+	append_values(interval, scratch);
+
+	return scratch;
+}
+
 /* Ensures correctness and balansing of a tree. */
 template <class T>
 void IntervalTree<T>::balance(Interval<T>* interval) {
@@ -280,7 +415,7 @@ template <class T>
 void IntervalTree<T>::get_intersecting_intervals(Interval<T>* interval, int position, vector<T>& result) {
 	if (interval != NULL) {
 		if ((interval->start <= position) && (position <= interval->end)) {
-			result.insert(result.end(), interval->values.begin(), interval->values.end());
+			append_values(interval, result);
 		}
 
 		if ((interval->left != NULL) && (interval->left->max >= position)) {
@@ -336,7 +471,7 @@ template <class T>
 void IntervalTree<T>::get_intersecting_intervals(Interval<T>* interval, int start, int end, vector<T>& result) {
 	if (interval != NULL) {
 		if ((start <= interval->end) && (end >= interval->start)) {
-			result.insert(result.end(), interval->values.begin(), interval->values.end());
+			append_values(interval, result);
 		}
 
 		if ((interval->left != NULL) && (interval->left->max >= start)) {
@@ -396,7 +531,8 @@ template <class T>
 void IntervalTree<T>::get_intersecting_intervals(Interval<T>* interval, int start, int end, IntervalTree<T>& tree) {
 	if (interval != NULL) {
 		if ((start <= interval->end) && (end >= interval->start)) {
-			tree.add_all(interval->start, interval->end, interval->values);
+			vector<T> scratch;
+			tree.add_all(interval->start, interval->end, get_values(interval, scratch));
 		}
 
 		if ((interval->left != NULL) && (interval->left->max >= start)) {
@@ -428,7 +564,8 @@ template <class T>
 void IntervalTree<T>::get_intersecting_intervals(Interval<T>* interval, int start, int end, int deviation, IntervalTree<T>& tree) {
 	if (interval != NULL) {
 		if ((start <= interval->end) && (end >= interval->start)) {
-			tree.add_all(interval->start, interval->end, interval->values, deviation);
+			vector<T> scratch;
+			tree.add_all(interval->start, interval->end, get_values(interval, scratch), deviation);
 
 		}
 
@@ -442,6 +579,175 @@ void IntervalTree<T>::get_intersecting_intervals(Interval<T>* interval, int star
 	}
 }
 
+/* Orders intervals by end point, used as a min-heap of active intervals. */
+template <class T>
+class IntervalEndGreater {
+public:
+	bool operator()(const Interval<T>* a, const Interval<T>* b) const {
+		return a->end > b->end;
+	}
+};
+
+/*
+ *	Returns values of all intervals that intersect with each of provided positions.
+ *	Values for position i are result[offsets[i]] to result[offsets[i + 1] - 1].
+ *	Note:	Positions are expected to be in ascending order, so that all of them are answered in one sweep
+ *			through the tree. Otherwise each position is queried separately.
+ */
+template <class T>
+void IntervalTree<T>::get_intersecting_intervals(vector<int>& positions, vector<T>& result, vector<int>& offsets) {
+	sweep_intersecting_intervals(positions, positions, &result, &offsets, NULL);
+}
+
+/*
+ *	Returns values of all intervals that intersect with each of provided intervals.
+ *	Values for interval i are result[offsets[i]] to result[offsets[i + 1] - 1].
+ *	Note:	Intervals are expected to be in ascending order of start points, so that all of them are answered
+ *			in one sweep through the tree. Otherwise each interval is queried separately.
+ */
+template <class T>
+void IntervalTree<T>::get_intersecting_intervals(vector<int>& starts, vector<int>& ends, vector<T>& result, vector<int>& offsets) {
+	sweep_intersecting_intervals(starts, ends, &result, &offsets, NULL);
+}
+
+/* Returns the number of values of all intervals that intersect with each of provided positions (in ascending order). */
+template <class T>
+void IntervalTree<T>::count_intersecting_intervals(vector<int>& positions, vector<int>& counts) {
+	sweep_intersecting_intervals(positions, positions, NULL, NULL, &counts);
+}
+
+/* Returns the number of values of all intervals that intersect with each of provided intervals (in ascending order of start points). */
+template <class T>
+void IntervalTree<T>::count_intersecting_intervals(vector<int>& starts, vector<int>& ends, vector<int>& counts) {
+	sweep_intersecting_intervals(starts, ends, NULL, NULL, &counts);
+}
+
+/* Lists the intervals in order of start points with the number of values before each and the running maximum end point. */
+template <class T>
+void IntervalTree<T>::build_sweep_cache() {
+	sweep_intervals.clear();
+	if (root != NULL) {
+		get_inordered(root, get_intervals_count(), sweep_intervals);
+	}
+
+	int n = sweep_intervals.size();
+	sweep_values_before.assign(n + 1, 0);
+	sweep_max_ends.resize(n);
+	for (int i = 0; i < n; i++) {
+		sweep_values_before[i + 1] = sweep_values_before[i] + sweep_intervals[i]->values.size() + sweep_intervals[i]->values_count;
+		sweep_max_ends[i] = (i > 0) ? max(sweep_max_ends[i - 1], sweep_intervals[i]->end) : sweep_intervals[i]->end;
+	}
+
+	sweep_cached = true;
+}
+
+/*
+ *	Answers sorted queries by merging them with the intervals in order of start points.
+ *	Intervals that started before the query start and have not ended are kept in a min-heap of end points,
+ *	the rest of the intersecting intervals are the ones starting between the query start and end.
+ *	Either result and offsets or counts are filled.
+ */
+template <class T>
+void IntervalTree<T>::sweep_intersecting_intervals(vector<int>& starts, vector<int>& ends, vector<T>* result, vector<int>* offsets, vector<int>* counts) {
+	int queries = starts.size();
+	bool sorted = true;
+
+	for (int i = 1; i < queries; i++) {
+		if (starts[i] < starts[i - 1]) {
+			sorted = false;
+			break;
+		}
+	}
+
+	if (offsets != NULL) {
+		offsets->clear();
+		offsets->reserve(queries + 1);
+		offsets->push_back(result->size());
+	}
+	if (counts != NULL) {
+		counts->assign(queries, 0);
+	}
+
+	if (!sorted) {
+		vector<T> values;
+		for (int i = 0; i < queries; i++) {
+			values.clear();
+			get_intersecting_intervals(root, starts[i], ends[i], values);
+			if (counts != NULL) {
+				(*counts)[i] = values.size();
+			}
+			else {
+				result->insert(result->end(), values.begin(), values.end());
+				offsets->push_back(result->size());
+			}
+		}
+		return;
+	}
+
+	if (!sweep_cached) {
+		build_sweep_cache();
+	}
+	vector<Interval<T>*>& intervals = sweep_intervals;
+	vector<int>& values_before = sweep_values_before;
+	int n = intervals.size();
+
+	vector<Interval<T>*> active;
+	int active_values = 0;
+	int next = 0;
+
+	for (int i = 0; i < queries; i++) {
+		int start = starts[i];
+		int end = ends[i];
+
+		/* Skip intervals that all end before the query start, e.g. up to the first query */
+		if ((next < n) && (sweep_max_ends[next] < start)) {
+			next = lower_bound(sweep_max_ends.begin() + next, sweep_max_ends.end(), start) - sweep_max_ends.begin();
+		}
+
+		/* Add intervals that start at or before the query start */
+		while ((next < n) && (intervals[next]->start <= start)) {
+			if (intervals[next]->end >= start) {
+				active.push_back(intervals[next]);
+				push_heap(active.begin(), active.end(), IntervalEndGreater<T>());
+				active_values += values_before[next + 1] - values_before[next];
+			}
+			next += 1;
+		}
+
+		/* Remove intervals that end before the query start */
+		while (!active.empty() && (active.front()->end < start)) {
+			active_values -= active.front()->values.size() + active.front()->values_count;
+			pop_heap(active.begin(), active.end(), IntervalEndGreater<T>());
+			active.pop_back();
+		}
+
+		if (counts != NULL) {
+			/* Intervals starting after the query start and at or before the query end */
+			int low = next;
+			int high = n;
+			while (low < high) {
+				int middle = low + (high - low) / 2;
+				if (intervals[middle]->start <= end) {
+					low = middle + 1;
+				}
+				else {
+					high = middle;
+				}
+			}
+			(*counts)[i] = active_values + values_before[low] - values_before[next];
+		}
+		else {
+			for (unsigned int j = 0; j < active.size(); j++) {
+				append_values(active[j], *result);
+			}
+			for (int j = next; (j < n) && (intervals[j]->start <= end); j++) {
+				append_values(intervals[j], *result);
+			}
+			offsets->push_back(result->size());
+		}
+	}
+}
+
 /* Get all values stored in a tree with respect to their deviations (marked values). */
 template <class T>
 void IntervalTree<T>::get_marked_values(map<int, vector<T>* >& values) {
@@ -457,11 +763,11 @@ void IntervalTree<T>::get_marked_values(Interval<T>* interval, map<int, vector<T
 		values_it = values.find(interval->deviation);
 
 		if (values_it != values.end()) {
-			(*values_it).second->insert((*values_it).second->end(), interval->values.begin(), interval->values.end());
+			append_values(interval, *((*values_it).second));
 		}
 		else {
 			vector<T>* new_values = new vector<T>();
-			new_values->insert(new_values->end(), interval->values.begin(), interval->values.end());
+			append_values(interval, *new_values);
 			values.insert(pair<int, vector<T>* >(interval->deviation, new_values));
 		}
 
@@ -672,7 +978,7 @@ int IntervalTree<T>::get_values_count() {
 template <class T>
 int IntervalTree<T>::get_values_count(Interval<T>* interval, int count) {
 	if (interval != NULL) {
-		count += interval->values.size();
+		count += interval->values.size() + interval->values_count;
 	}
 	else {
 		return count;
@@ -744,11 +1050,13 @@ void IntervalTree<T>::print(ostream& stream, Interval<T>* interval, int intend)
 		stream << "\t";
 	}
 
+	T& value = (interval->first_value >= 0) ? arena_values[interval->first_value] : interval->values.front();
+
 	if (interval->color == Interval<T>::BLACK) {
-		stream << "[" << interval->start << ", " << interval->end << "]:" << interval->values.front() << ", " << interval->max << endl;
+		stream << "[" << interval->start << ", " << interval->end << "]:" << value << ", " << interval->max << endl;
 	}
 	else {
-		stream << "<[" << interval->start << ", " << interval->end << "]:" << interval->values.front() << "," << interval->max << ">" << endl;
+		stream << "<[" << interval->start << ", " << interval->end << "]:" << value << "," << interval->max << ">" << endl;
 	}
 
 	if (interval->left != NULL) {
@@ -760,6 +1068,9 @@ template <class T>
 void IntervalTree<T>::clear() {
 	remove_interval(root);
 	root = NULL;
+	arena.clear();
+	arena_values.clear();
+	sweep_cached = false;
 }
 
 /*
@@ -772,7 +1083,10 @@ void IntervalTree<T>::remove_interval(Interval<T>* interval) {
 		remove_interval(interval->right);
 		remove_interval(interval->left);
 
-		delete interval;
+		/* Bulk loaded intervals are freed with the arena */
+		if (interval->first_value < 0) {
+			delete interval;
+		}
 	}
 }
 
@@ -786,7 +1100,10 @@ void IntervalTree<T>::erase_interval(Interval<T>* interval) {
 		erase_interval(interval->right);
 		erase_interval(interval->left);
 
-		delete interval;
+		/* Bulk loaded intervals are freed with the arena */
+		if (interval->first_value < 0) {
+			delete interval;
+		}
 	}
 }
 
@@ -803,10 +1120,18 @@ void IntervalTree<char*>::erase_interval(Interval<char*>* interval) {
 		}
 		interval->values.clear();
 
+		for (int i = 0; i < interval->values_count; i++) {
+			free(arena_values.at(interval->first_value + i));
+		}
+		interval->values_count = 0;
+
 		erase_interval(interval->right);
 		erase_interval(interval->left);
 
-		delete interval;
+		/* Bulk loaded intervals are freed with the arena */
+		if (interval->first_value < 0) {
+			delete interval;
+		}
 	}
 }
 
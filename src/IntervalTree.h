@@ -27,11 +27,27 @@
 
 using namespace std;
 
+template <class T>
+class FrozenIntervalTree;
+
 template <class T>
 class IntervalTree {
 private:
+	friend class FrozenIntervalTree<T>;
+
 	Interval<T>* root;
 
+	/* Bulk loaded intervals and their values */
+	vector<Interval<T> > arena;
+	vector<T> arena_values;
+
+	/* Intervals in order of start points for sorted batched queries, rebuilt after the tree changes */
+	bool sweep_cached;
+	vector<Interval<T>*> sweep_intervals;
+	/* Number of values before each interval, and maximum end point up to and including each interval */
+	vector<int> sweep_values_before;
+	vector<int> sweep_max_ends;
+
 	/* Balancing */
 	void balance(Interval<T>* interval);
 	void rotate_left(Interval<T>* interval);
@@ -40,6 +56,11 @@ private:
 	void calculate_max_end(Interval<T>* interval);
 	void remove_interval(Interval<T>* interval);
 	void erase_interval(Interval<T>* interval);
+	Interval<T>* build_balanced(int first, int last, int depth, int red_depth, Interval<T>* parent);
+
+	/* Values */
+	void append_values(Interval<T>* interval, vector<T>& result);
+	vector<T>& get_values(Interval<T>* interval, vector<T>& scratch);
 
 	/* Queries */
 	void get_intersecting_intervals(Interval<T>* interval, int position, vector<T>& result);
@@ -56,6 +77,8 @@ private:
 	int get_knearest_from_left(Interval<T>* interval, int k, vector<Interval<T>*>& result);
 
 	void get_marked_values(Interval<T>* interval, map<int, vector<T>* >& values);
+	void build_sweep_cache();
+	void sweep_intersecting_intervals(vector<int>& starts, vector<int>& ends, vector<T>* result, vector<int>* offsets, vector<int>* counts);
 
 	/* Properties */
 	int get_values_count(Interval<T>* interval, int count);
@@ -75,6 +98,9 @@ public:
 	void add_all(int start, int end, vector<T>& values);
 	void add_all(int start, int end, vector<T>& values, int deviation);
 
+	/* Bulk loading */
+	void build(vector<int>& starts, vector<int>& ends, vector<T>& values);
+
 	void clear();
 
 	/* Queries */
@@ -91,6 +117,12 @@ public:
 	void get_knearest_from_right(int position, int k, vector<Interval<T>*>& result);
 	void get_knearest_from_left(int position, int k, vector<Interval<T>*>& result);
 
+	/* Batched queries */
+	void get_intersecting_intervals(vector<int>& positions, vector<T>& result, vector<int>& offsets);
+	void get_intersecting_intervals(vector<int>& starts, vector<int>& ends, vector<T>& result, vector<int>& offsets);
+	void count_intersecting_intervals(vector<int>& positions, vector<int>& counts);
+	void count_intersecting_intervals(vector<int>& starts, vector<int>& ends, vector<int>& counts);
+
 	void get_marked_values(map<int, vector<T>* >& values);
 
 	/* Properties */
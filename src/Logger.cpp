@@ -0,0 +1,297 @@
+#include <sched.h>
+#include <time.h>
+#include <string>
+
+#include "Logger.h"
+
+Logger* Logger::gLogger = NULL;
+
+// how long the writer thread sleeps when there is nothing to write
+static const long WRITER_SLEEP_NS = 20000000;
+
+static void timedWait(pthread_cond_t* cond, pthread_mutex_t* lock, long ns) {
+  struct timespec until;
+  clock_gettime(CLOCK_REALTIME, &until);
+  until.tv_nsec += ns;
+  if ( until.tv_nsec >= 1000000000 ) {
+    until.tv_sec += until.tv_nsec / 1000000000;
+    until.tv_nsec %= 1000000000;
+  }
+  pthread_cond_timedwait(cond, lock, &until);
+}
+
+Logger::Logger(const char* filename, bool verbose) {
+  b_verbose = verbose;
+  max_repeats = -1;
+  if ( strlen(filename) > 0 ) {
+    //strcmp(filename,"__NONE__") != 0 ) {
+    fp_log = ifopen(filename, "wb");
+    if ( fp_log == NULL ) {
+      fprintf(stderr,"ERROR: Cannot open the log file %s. Check if the directory exists and you have the permission to create a file", filename);
+      abort();
+    }
+  }
+  else {
+    fp_log = NULL;
+  }
+  fp_err = stderr;
+
+  p_ring = new LogEntry[RING_SIZE];
+  for(int i=0; i < RING_SIZE; ++i) {
+    p_ring[i].seq = i;
+    p_ring[i].long_text = NULL;
+  }
+  n_enqueue_pos = 0;
+  n_dequeue_pos = 0;
+  n_written_pos = 0;
+  p_rates = new RateEntry[RATE_TABLE_SIZE];
+  for(int i=0; i < RATE_TABLE_SIZE; ++i) {
+    p_rates[i].format = NULL;
+    p_rates[i].count = 0;
+  }
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&wake_cond, NULL);
+  pthread_cond_init(&written_cond, NULL);
+  b_stopping = false;
+  // without the writer thread, messages are written as they are logged
+  b_started = ( pthread_create(&writer_thread, NULL, runWriter, this) == 0 );
+}
+
+Logger::~Logger() {
+  stopWriter();
+  writeSuppressed();
+  if ( fp_log != NULL ) {
+    ifclose(fp_log);
+  }
+  delete [] p_ring;
+  delete [] p_rates;
+  pthread_cond_destroy(&written_cond);
+  pthread_cond_destroy(&wake_cond);
+  pthread_mutex_destroy(&lock);
+}
+
+// write everything logged so far & stop the writer thread, after which
+// messages are written as they are logged.
+void Logger::stopWriter() {
+  flush();
+  if ( b_started ) {
+    pthread_mutex_lock(&lock);
+    b_stopping = true;
+    pthread_cond_signal(&wake_cond);
+    pthread_mutex_unlock(&lock);
+    pthread_join(writer_thread, NULL);
+    b_started = false;
+  }
+}
+
+// count a message with the format string, returning false if it has been
+// repeated too many times.  formats are identified by their address, so
+// each call site is limited separately.
+bool Logger::allowRepeat(const char* format) {
+  if ( max_repeats < 0 ) {
+    return true;
+  }
+  unsigned int hash = (unsigned int)(((uintptr_t)format >> 3) * 2654435761U);
+  for(int probe=0; probe < RATE_TABLE_SIZE; ++probe) {
+    RateEntry& rate = p_rates[(hash + probe) & (RATE_TABLE_SIZE-1)];
+    const char* entryFormat = rate.format;
+    if ( entryFormat == NULL ) {
+      entryFormat = __sync_val_compare_and_swap(&rate.format, (const char*)NULL, format);
+      if ( entryFormat == NULL ) {
+        entryFormat = format;
+      }
+    }
+    if ( entryFormat == format ) {
+      return ( __sync_add_and_fetch(&rate.count, 1) <= max_repeats );
+    }
+  }
+  // too many formats to track
+  return true;
+}
+
+void Logger::push(LogKind kind, const char* format, va_list args) {
+  if ( ( kind == LOG_INFO ) && ( fp_log == NULL ) && ( ! b_verbose ) ) {
+    return; // nowhere to write it
+  }
+  if ( ( kind == LOG_WARNING ) && ( ! allowRepeat(format) ) ) {
+    return;
+  }
+
+  // claim the next free slot of the ring
+  uint64_t pos = n_enqueue_pos;
+  LogEntry* entry = NULL;
+  while ( true ) {
+    entry = &p_ring[pos & (RING_SIZE-1)];
+    uint64_t seq = entry->seq;
+    __sync_synchronize();
+    int64_t diff = (int64_t)seq - (int64_t)pos;
+    if ( diff == 0 ) {
+      if ( __sync_bool_compare_and_swap(&n_enqueue_pos, pos, pos+1) ) {
+        break;
+      }
+    }
+    else if ( diff < 0 ) {
+      // the ring is full, so wake the writer & wait for it
+      pthread_mutex_lock(&lock);
+      pthread_cond_signal(&wake_cond);
+      pthread_mutex_unlock(&lock);
+      sched_yield();
+    }
+    pos = n_enqueue_pos;
+  }
+
+  entry->kind = kind;
+  va_list copy;
+  va_copy(copy, args);
+  int len = vsnprintf(entry->text, MAX_MESSAGE, format, args);
+  entry->long_text = NULL;
+  if ( len >= MAX_MESSAGE ) {
+    // too long for the slot, so format it again on the heap
+    entry->long_text = (char*) malloc(len+1);
+    if ( entry->long_text != NULL ) {
+      vsnprintf(entry->long_text, len+1, format, copy);
+    }
+    else {
+      len = MAX_MESSAGE-1;
+    }
+  }
+  va_end(copy);
+  entry->len = ( len < 0 ) ? 0 : len;
+  // publish the message to the writer
+  __sync_synchronize();
+  entry->seq = pos + 1;
+
+  if ( ! b_started ) {
+    pthread_mutex_lock(&lock);
+    writeAvailable();
+    pthread_mutex_unlock(&lock);
+  }
+}
+
+// write every published message in 1 batch.  must hold lock.
+int Logger::writeAvailable() {
+  std::string logText;
+  std::string errText;
+  int n = 0;
+  while ( true ) {
+    LogEntry& entry = p_ring[n_dequeue_pos & (RING_SIZE-1)];
+    if ( entry.seq != n_dequeue_pos + 1 ) {
+      break;
+    }
+    __sync_synchronize();
+    const char* logPrefix = "";
+    const char* errPrefix = "";
+    if ( entry.kind == LOG_WARNING ) {
+      logPrefix = "WARNING: ";
+      errPrefix = "WARNING : ";
+    }
+    else if ( entry.kind == LOG_ERROR ) {
+      logPrefix = "ERROR: ";
+      errPrefix = "ERROR : ";
+    }
+    const char* text = ( entry.long_text != NULL ) ? entry.long_text : entry.text;
+    if ( fp_log != NULL ) {
+      logText += logPrefix;
+      logText.append(text, entry.len);
+      logText += '\n';
+    }
+    if ( ( entry.kind != LOG_INFO ) || b_verbose ) {
+      errText += errPrefix;
+      errText.append(text, entry.len);
+      errText += '\n';
+    }
+    free(entry.long_text);
+    entry.long_text = NULL;
+    // free the slot for the producer that wraps around to it
+    __sync_synchronize();
+    entry.seq = n_dequeue_pos + RING_SIZE;
+    ++n_dequeue_pos;
+    ++n;
+  }
+  if ( ! logText.empty() ) {
+    ::ifwrite(fp_log, logText.data(), logText.size());
+  }
+  if ( ! errText.empty() ) {
+    fwrite(errText.data(), 1, errText.size(), fp_err);
+    fflush(fp_err);
+  }
+  n_written_pos = n_dequeue_pos;
+  pthread_cond_broadcast(&written_cond);
+  return n;
+}
+
+void* Logger::runWriter(void* arg) {
+  Logger* logger = (Logger*)arg;
+  pthread_mutex_lock(&logger->lock);
+  while ( true ) {
+    int n = logger->writeAvailable();
+    if ( logger->b_stopping && ( n == 0 ) ) {
+      break;
+    }
+    if ( n == 0 ) {
+      timedWait(&logger->wake_cond, &logger->lock, WRITER_SLEEP_NS);
+    }
+  }
+  pthread_mutex_unlock(&logger->lock);
+  return NULL;
+}
+
+void Logger::flush() {
+  uint64_t target = n_enqueue_pos;
+  pthread_mutex_lock(&lock);
+  if ( ! b_started ) {
+    writeAvailable();
+  }
+  while ( b_started && ( n_written_pos < target ) ) {
+    pthread_cond_signal(&wake_cond);
+    timedWait(&written_cond, &lock, WRITER_SLEEP_NS);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+// summarize the rate-limited messages.  the writer must be stopped.
+void Logger::writeSuppressed() {
+  for(int i=0; i < RATE_TABLE_SIZE; ++i) {
+    if ( ( max_repeats >= 0 ) && ( p_rates[i].count > max_repeats ) ) {
+      String buffer;
+      buffer.printf("WARNING: %d more messages like \"%s\" were not logged", p_rates[i].count - max_repeats, p_rates[i].format);
+      if ( fp_log != NULL ) {
+        ::ifwrite(fp_log, (const char*) buffer, buffer.Length());
+        ifprintf(fp_log,"\n");
+      }
+      fprintf(fp_err, "%s\n", (const char*) buffer);
+    }
+  }
+  fflush(fp_err);
+}
+
+void Logger::writeLog(const char* format, ...) {
+  va_list args;
+  va_start (args, format);
+  push(LOG_INFO, format, args);
+  va_end (args);
+}
+
+void Logger::error(const char* format, ...) {
+  va_list args;
+  va_start (args, format);
+  push(LOG_ERROR, format, args);
+  va_end (args);
+
+  // make sure everything, including this error, is written & that the
+  // writer is done with the log before closing it
+  stopWriter();
+  if ( fp_log != NULL ) {
+    ifclose(fp_log);
+    fp_log = NULL;
+  }
+  abort();
+}
+
+void Logger::warning(const char* format, ...) {
+  va_list args;
+  va_start (args, format);
+  push(LOG_WARNING, format, args);
+  va_end (args);
+}
@@ -5,100 +5,88 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
 
 #include "InputFile.h"
 #include "StringBasics.h"
 
+// Asynchronous logger : callers format each message into a slot of a
+// lock-free multi-producer ring, and a background thread writes batches
+// of messages to the log file & stderr, so logging never waits on I/O.
+// Warnings from the same format string can be rate-limited : after
+// max_repeats of them, the rest are counted & summarized when the
+// logger is destroyed.  By default, there is no limit.
+// error() flushes everything that was logged before aborting.
 class Logger {
+ public:
+  static const int RING_SIZE = 1024;       // must be a power of 2
+  static const int MAX_MESSAGE = 1024;     // longer messages go on the heap
+  static const int RATE_TABLE_SIZE = 256;  // must be a power of 2
+  static const int DEFAULT_MAX_REPEATS = 100; // for per-record warnings
+
  protected:
+  enum LogKind { LOG_INFO, LOG_WARNING, LOG_ERROR };
+
+  // One message in the ring.  seq tells whether it is free for the
+  // producer claiming position seq, or ready for the consumer at seq-1.
+  struct LogEntry {
+    volatile uint64_t seq;
+    LogKind kind;
+    int len;
+    char text[MAX_MESSAGE];
+    char* long_text; // the message if it does not fit in text, else NULL
+  };
+
+  // Number of messages logged with a format string.
+  struct RateEntry {
+    const char* volatile format;
+    volatile int count;
+  };
+
   IFILE fp_log;
   FILE* fp_err;
   bool b_verbose;
-  
+  int max_repeats;
+
+  LogEntry* p_ring;
+  volatile uint64_t n_enqueue_pos;
+  uint64_t n_dequeue_pos;
+  RateEntry* p_rates;
+
+  pthread_t writer_thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake_cond;
+  pthread_cond_t written_cond;
+  volatile uint64_t n_written_pos;
+  bool b_started;
+  bool b_stopping;
+
   Logger() {} // default constructor prohibited
+
+  void push(LogKind kind, const char* format, va_list args);
+  bool allowRepeat(const char* format);
+  int writeAvailable();
+  void stopWriter();
+  void writeSuppressed();
+  static void* runWriter(void* arg);
+
  public:
   static Logger* gLogger;
 
-  Logger(const char* filename, bool verbose) {
-    b_verbose = verbose;
-    if ( strlen(filename) > 0 ) {
-      //strcmp(filename,"__NONE__") != 0 ) {
-      fp_log = ifopen(filename, "wb");
-      if ( fp_log == NULL ) {
-	fprintf(stderr,"ERROR: Cannot open the log file %s. Check if the directory exists and you have the permission to create a file", filename);
-	abort();
-      }
-    }
-    else {
-      fp_log = NULL;
-    }
-    fp_err = stderr;
-  }
-
-  void writeLog(const char* format, ...) {
-    va_list args;
-    if ( fp_log != NULL ) {
-      String buffer;
-      va_start (args, format);
-      buffer.vprintf(format, args);
-      va_end (args);
-      ::ifwrite(fp_log, (const char*) buffer, buffer.Length());
-      ifprintf(fp_log,"\n");
-      //fflush(fp_log);
-    }
-    
-    if ( b_verbose ) {
-      va_start (args, format);
-      vfprintf(fp_err, format, args);
-      va_end (args);
-      fprintf(fp_err, "\n");
-      fflush(fp_err);
-    }
-  }
-
-  void error(const char* format, ...) {
-    va_list args;
-    if ( fp_log != NULL ) {
-      String buffer;
-      va_start (args, format);
-      buffer.printf("ERROR: ");
-      buffer.vprintf(format, args);
-      va_end (args);
-      ::ifwrite(fp_log, (const char*) buffer, buffer.Length());
-      ifprintf(fp_log,"\n");
-      //fflush(fp_log);
-    }
-    
-    va_start (args, format);
-    fprintf(fp_err, "ERROR : ");
-    vfprintf(fp_err, format, args);
-    va_end (args);
-    fprintf(fp_err, "\n");
-    fflush(fp_err);
-
-    abort();    
-  }
-
-  void warning(const char* format, ...) {
-    va_list args;
-    if ( fp_log != NULL ) {
-      String buffer;
-      va_start (args, format);
-      buffer.printf("WARNING: ");
-      buffer.vprintf(format, args);
-      va_end (args);
-      ::ifwrite(fp_log, (const char*) buffer, buffer.Length());
-      ifprintf(fp_log,"\n");
-      //fflush(fp_log);
-    }
-    
-    va_start (args, format);
-    fprintf(fp_err, "WARNING : ");
-    vfprintf(fp_err, format, args);
-    va_end (args);
-    fprintf(fp_err, "\n");
-    fflush(fp_err);
-  }
+  Logger(const char* filename, bool verbose);
+  ~Logger();
+
+  // set how many warnings with the same format string are logged
+  // (negative for no limit, the default)
+  void setMaxRepeats(int n) { max_repeats = n; }
+
+  // wait until everything logged so far is written
+  void flush();
+
+  void writeLog(const char* format, ...);
+  void error(const char* format, ...);
+  void warning(const char* format, ...);
 };
 
 #endif // __LOGGER_H__
@@ -0,0 +1,317 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MacBinaryFile.h"
+
+static const char MAC_BINARY_MAGIC[8] = {'V','C','F','U','M','A','C','\0'};
+static const uint32_t MAC_BINARY_VERSION = 1;
+
+MacBinaryWriter::MacBinaryWriter()
+    : myFile(NULL),
+      myContigTable(),
+      myIdFile(NULL),
+      myIdTableSize(0),
+      myPrevChrom(),
+      myPrevContig(0),
+      myFailed(false)
+{
+    memset(&myHeader, 0, sizeof(myHeader));
+}
+
+
+MacBinaryWriter::~MacBinaryWriter()
+{
+    if(myFile != NULL)
+    {
+        close();
+    }
+}
+
+
+bool MacBinaryWriter::open(const char* filename)
+{
+    myFile = fopen(filename, "wb");
+    if(myFile == NULL)
+    {
+        return(false);
+    }
+    memset(&myHeader, 0, sizeof(myHeader));
+    memcpy(myHeader.magic, MAC_BINARY_MAGIC, sizeof(myHeader.magic));
+    myHeader.version = MAC_BINARY_VERSION;
+    myContigTable.clear();
+    myIdTableSize = 0;
+    myPrevChrom.clear();
+    myPrevContig = 0;
+    myFailed = false;
+
+    // Spool the IDs beside the output, which is where the space for them
+    // is needed anyway, removing the name so the file goes away on close.
+    std::string idName = filename;
+    idName += ".idsXXXXXX";
+    std::vector<char> idBuf(idName.begin(), idName.end());
+    idBuf.push_back('\0');
+    int idFd = mkstemp(&(idBuf[0]));
+    if(idFd < 0)
+    {
+        return(failOpen());
+    }
+    unlink(&(idBuf[0]));
+    myIdFile = fdopen(idFd, "w+b");
+    if(myIdFile == NULL)
+    {
+        ::close(idFd);
+        return(failOpen());
+    }
+
+    // The header is rewritten once the counts & offsets are known.
+    if(fwrite(&myHeader, sizeof(myHeader), 1, myFile) != 1)
+    {
+        return(failOpen());
+    }
+    return(true);
+}
+
+
+bool MacBinaryWriter::failOpen()
+{
+    if(myIdFile != NULL)
+    {
+        fclose(myIdFile);
+        myIdFile = NULL;
+    }
+    fclose(myFile);
+    myFile = NULL;
+    return(false);
+}
+
+
+void MacBinaryWriter::add(const char* chrom, int pos, const char* id,
+                          int minAC, int an)
+{
+    MacBinaryRecord record;
+    // Records are sorted by chromosome, so only look up the contig
+    // id when the chromosome changes.
+    if((myHeader.numContigs == 0) || (myPrevChrom != chrom))
+    {
+        myPrevChrom = chrom;
+        myPrevContig = myHeader.numContigs;
+        // Reuse the id if the chromosome was seen before.
+        const char* name = myContigTable.c_str();
+        for(uint32_t c = 0; c < myHeader.numContigs; c++)
+        {
+            if(myPrevChrom == name)
+            {
+                myPrevContig = c;
+                break;
+            }
+            name += strlen(name) + 1;
+        }
+        if(myPrevContig == myHeader.numContigs)
+        {
+            myContigTable.append(chrom);
+            myContigTable.push_back('\0');
+            ++myHeader.numContigs;
+        }
+    }
+    record.contig = myPrevContig;
+    record.pos = pos;
+    record.minAC = minAC;
+    record.an = an;
+    record.maf = (an == 0) ? 0 : (float)((double)minAC/an);
+    if(myIdTableSize > 0xffffffffUL)
+    {
+        // The ID offset no longer fits in the record.
+        myFailed = true;
+    }
+    record.idOffset = myIdTableSize;
+    size_t idLen = strlen(id) + 1;
+    if(fwrite(id, 1, idLen, myIdFile) != idLen)
+    {
+        myFailed = true;
+    }
+    myIdTableSize += idLen;
+
+    if(fwrite(&record, sizeof(record), 1, myFile) != 1)
+    {
+        myFailed = true;
+    }
+    ++myHeader.numRecords;
+}
+
+
+bool MacBinaryWriter::close()
+{
+    if(myFile == NULL)
+    {
+        return(false);
+    }
+    myHeader.contigTableOffset =
+        sizeof(myHeader) + (myHeader.numRecords * sizeof(MacBinaryRecord));
+    myHeader.idTableOffset =
+        myHeader.contigTableOffset + myContigTable.size();
+    myHeader.fileSize = myHeader.idTableOffset + myIdTableSize;
+
+    if(fwrite(myContigTable.data(), 1, myContigTable.size(), myFile) != myContigTable.size())
+    {
+        myFailed = true;
+    }
+
+    // Append the spooled IDs.
+    char buffer[65536];
+    uint64_t copied = 0;
+    if((fflush(myIdFile) != 0) || (fseek(myIdFile, 0, SEEK_SET) != 0))
+    {
+        myFailed = true;
+    }
+    while(!myFailed && (copied < myIdTableSize))
+    {
+        size_t len = fread(buffer, 1, sizeof(buffer), myIdFile);
+        if((len == 0) || (fwrite(buffer, 1, len, myFile) != len))
+        {
+            myFailed = true;
+        }
+        copied += len;
+    }
+    fclose(myIdFile);
+    myIdFile = NULL;
+
+    if((fseek(myFile, 0, SEEK_SET) != 0) ||
+       (fwrite(&myHeader, sizeof(myHeader), 1, myFile) != 1))
+    {
+        myFailed = true;
+    }
+    if(fclose(myFile) != 0)
+    {
+        myFailed = true;
+    }
+    myFile = NULL;
+    return(!myFailed);
+}
+
+
+MacBinaryReader::MacBinaryReader()
+    : myMap(NULL),
+      myMapSize(0),
+      myHeader(NULL),
+      myRecords(NULL),
+      myIdTable(NULL),
+      myIdTableSize(0),
+      myContigs()
+{
+}
+
+
+MacBinaryReader::~MacBinaryReader()
+{
+    close();
+}
+
+
+bool MacBinaryReader::open(const char* filename)
+{
+    close();
+
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0)
+    {
+        return(false);
+    }
+    struct stat fileStat;
+    if((fstat(fd, &fileStat) != 0) ||
+       ((size_t)fileStat.st_size < sizeof(MacBinaryHeader)))
+    {
+        ::close(fd);
+        return(false);
+    }
+    myMapSize = fileStat.st_size;
+    myMap = mmap(NULL, myMapSize, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+    if(myMap == MAP_FAILED)
+    {
+        myMap = NULL;
+        return(false);
+    }
+
+    // Check that the header & tables are consistent with the file.  The
+    // record count is checked before it is multiplied so a corrupt count
+    // cannot overflow into a valid looking offset.
+    const char* base = (const char*)myMap;
+    myHeader = (const MacBinaryHeader*)base;
+    if((memcmp(myHeader->magic, MAC_BINARY_MAGIC, sizeof(myHeader->magic)) != 0) ||
+       (myHeader->version != MAC_BINARY_VERSION) ||
+       (myHeader->fileSize != myMapSize) ||
+       (myHeader->numRecords > (myHeader->fileSize - sizeof(MacBinaryHeader)) /
+        sizeof(MacBinaryRecord)) ||
+       (myHeader->contigTableOffset != sizeof(MacBinaryHeader) +
+        (myHeader->numRecords * sizeof(MacBinaryRecord))) ||
+       (myHeader->idTableOffset < myHeader->contigTableOffset) ||
+       (myHeader->idTableOffset > myHeader->fileSize))
+    {
+        close();
+        return(false);
+    }
+    myRecords = (const MacBinaryRecord*)(base + sizeof(MacBinaryHeader));
+    myIdTable = base + myHeader->idTableOffset;
+    myIdTableSize = myHeader->fileSize - myHeader->idTableOffset;
+
+    // Every ID, including the last, must be terminated within the table.
+    if((myIdTableSize > 0) && (myIdTable[myIdTableSize - 1] != '\0'))
+    {
+        close();
+        return(false);
+    }
+
+    // Index the contig names.
+    const char* name = base + myHeader->contigTableOffset;
+    const char* tableEnd = myIdTable;
+    for(uint32_t c = 0; c < myHeader->numContigs; c++)
+    {
+        const char* nameEnd = (const char*)memchr(name, '\0', tableEnd - name);
+        if(nameEnd == NULL)
+        {
+            close();
+            return(false);
+        }
+        myContigs.push_back(name);
+        name = nameEnd + 1;
+    }
+    return(true);
+}
+
+
+void MacBinaryReader::close()
+{
+    if(myMap != NULL)
+    {
+        munmap(myMap, myMapSize);
+    }
+    myMap = NULL;
+    myMapSize = 0;
+    myHeader = NULL;
+    myRecords = NULL;
+    myIdTable = NULL;
+    myIdTableSize = 0;
+    myContigs.clear();
+}
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __MAC_BINARY_FILE_H__
+#define __MAC_BINARY_FILE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/// Binary table of the mac results, written by mac --binOut.
+///
+/// The file is laid out so it can be memory mapped and used in place
+/// (all values are in the byte order of the machine that wrote it):
+///   MacBinaryHeader
+///   numRecords MacBinaryRecords, in the order they were written
+///   contig table: numContigs '\0' terminated names, in id order
+///   ID table: the '\0' terminated IDs, referenced by MacBinaryRecord::idOffset
+struct MacBinaryHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t numContigs;
+    uint64_t numRecords;
+    // Byte offsets from the start of the file.
+    uint64_t contigTableOffset;
+    uint64_t idTableOffset;
+    uint64_t fileSize;
+};
+
+
+/// Fixed width record for 1 site.
+struct MacBinaryRecord
+{
+    uint32_t contig;
+    uint32_t pos;
+    uint32_t minAC;
+    uint32_t an;
+    float maf;
+    /// Offset of the ID in the ID table.
+    uint32_t idOffset;
+};
+
+
+/// Writes a mac binary table.
+class MacBinaryWriter
+{
+public:
+    MacBinaryWriter();
+    ~MacBinaryWriter();
+
+    /// Open the file for writing.  Returns false if it could not be opened
+    /// or its header could not be written.
+    bool open(const char* filename);
+
+    /// Add the record for 1 site.
+    void add(const char* chrom, int pos, const char* id, int minAC, int an);
+
+    /// Write the string tables & header, and close the file.
+    /// Returns false if any write failed.
+    bool close();
+
+private:
+    MacBinaryWriter(const MacBinaryWriter&);
+    MacBinaryWriter& operator=(const MacBinaryWriter&);
+
+    // Close the files after a failed open, returning false.
+    bool failOpen();
+
+    FILE* myFile;
+    MacBinaryHeader myHeader;
+    std::string myContigTable;
+    // The IDs are spooled to an unlinked temporary file beside the output
+    // until close() appends them, so they are never all held in memory.
+    FILE* myIdFile;
+    uint64_t myIdTableSize;
+    std::string myPrevChrom;
+    uint32_t myPrevContig;
+    bool myFailed;
+};
+
+
+/// Memory maps a mac binary table for reading.
+class MacBinaryReader
+{
+public:
+    MacBinaryReader();
+    ~MacBinaryReader();
+
+    /// Map the file, returning false if it could not be read or
+    /// is not a mac binary table.
+    bool open(const char* filename);
+    void close();
+
+    uint64_t getNumRecords() const { return((myHeader == NULL) ? 0 : myHeader->numRecords); }
+    /// Get the record, index must be less than getNumRecords().
+    const MacBinaryRecord& getRecord(uint64_t index) const { return(myRecords[index]); }
+
+    unsigned int getNumContigs() const { return(myContigs.size()); }
+    /// Returns NULL if there is no such contig.
+    const char* getContig(unsigned int contig) const
+    { return((contig < myContigs.size()) ? myContigs[contig] : NULL); }
+
+    /// Returns NULL if the record's ID offset is outside of the ID table.
+    const char* getID(const MacBinaryRecord& record) const
+    { return((record.idOffset < myIdTableSize) ? (myIdTable + record.idOffset) : NULL); }
+
+private:
+    MacBinaryReader(const MacBinaryReader&);
+    MacBinaryReader& operator=(const MacBinaryReader&);
+
+    void* myMap;
+    size_t myMapSize;
+    const MacBinaryHeader* myHeader;
+    const MacBinaryRecord* myRecords;
+    const char* myIdTable;
+    uint64_t myIdTableSize;
+    std::vector<const char*> myContigs;
+};
+
+#endif
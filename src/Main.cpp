@@ -20,14 +20,8 @@
 #include <stdlib.h>
 #include <stdexcept>
 
-#include "ReplaceReference.h"
-//#include "VcfCooker.h"
-#include "VcfCleaner.h"
-#include "VcfExample.h"
-#include "VcfConvert.h"
-#include "VcfSplit.h"
-#include "VcfMac.h"
-#include "VcfConsensus.h"
+#include "VcfToolFactory.h"
+#include "Profiler.h"
 #include "PhoneHome.h"
 
 void Usage()
@@ -35,17 +29,14 @@ void Usage()
     VcfExecutable::vcfExecutableDescription();
     std::cerr << std::endl;
     std::cerr << "Tools: " << std::endl;
-    ReplaceReference::replaceReferenceDescription();
-    VcfCleaner::vcfCleanerDescription();
-    VcfConvert:: vcfConvertDescription();
-    VcfSplit:: vcfSplitDescription();
-    VcfMac:: vcfMacDescription();
-    VcfConsensus:: vcfConsensusDescription();
+    VcfToolFactory::toolDescriptions();
 
     std::cerr << std::endl;
     std::cerr << "Usage: " << std::endl;
     std::cerr << "\tvcfUtil <tool> [<tool arguments>]" << std::endl;
     std::cerr << "The usage for each tool is described by specifying the tool with no arguments." << std::endl;
+    std::cerr << "Any tool accepts \"--profile [<json file>]\" to print the time spent in each" << std::endl;
+    std::cerr << "stage (and write it as JSON) at exit when built with \"make PROFILE=1\"." << std::endl;
 }
 
 
@@ -61,47 +52,47 @@ int main(int argc, char ** argv)
         exit(-1);
     }
 
-    String cmd = argv[1];
-
-    if(cmd.SlowCompare("replaceReference") == 0)
-    {
-        vcfExe = new ReplaceReference();
-    }
-    else if(cmd.SlowCompare("cleaner") == 0)
-    {
-        vcfExe = new VcfCleaner();
-    }
-//     if(cmd.SlowCompare("vcfCooker") == 0)
-//     {
-//         vcfExe = new VcfCooker();
-//     }
-    else if(cmd.SlowCompare("vcfExample") == 0)
-    {
-        vcfExe = new VcfExample();
-    }
-    else if(cmd.SlowCompare("convert") == 0)
-    {
-        vcfExe = new VcfConvert();
-    }
-    else if(cmd.SlowCompare("split") == 0)
-    {
-        vcfExe = new VcfSplit();
-    }
-    else if(cmd.SlowCompare("mac") == 0)
-    {
-        vcfExe = new VcfMac();
-    }
-    else if(cmd.SlowCompare("consensus") == 0)
-    {
-        vcfExe = new VcfConsensus();
-    }
-    else
+    vcfExe = VcfToolFactory::create(argv[1]);
+    if(vcfExe == NULL)
     {
         std::cerr << "No tool specified\n";
         Usage();
         exit(-1);
     }
   
+    // Remove the tool independent "--profile [<json file>]" option before
+    // the tool reads its parameters.
+    bool profile = false;
+    std::string profileJson = "";
+    for(int i = 2; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--profile") == 0)
+        {
+            profile = true;
+            int numArgs = 1;
+            if((i + 1 < argc) && (argv[i + 1][0] != '-'))
+            {
+                profileJson = argv[i + 1];
+                numArgs = 2;
+            }
+            for(int j = i; j + numArgs < argc; j++)
+            {
+                argv[j] = argv[j + numArgs];
+            }
+            argc -= numArgs;
+            break;
+        }
+    }
+    if(profile)
+    {
+#ifdef VCF_PROFILE
+        Profiler::enable(argv[1]);
+#else
+        std::cerr << "WARNING: --profile requires building with \"make PROFILE=1\", "
+                  << "so no profile will be reported.\n";
+#endif
+    }
+
     if(vcfExe != NULL)
     {
         int returnVal = 0;
@@ -119,6 +110,10 @@ int main(int argc, char ** argv)
             std::cerr << errorMsg << std::endl;
             returnVal = -1;
         }
+        if(!Profiler::report(profileJson))
+        {
+            returnVal = -1;
+        }
 
         compStatus = returnVal;
         PhoneHome::completionStatus(compStatus.c_str());
@@ -0,0 +1,128 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PackedGenotype.h"
+
+// Combine two allele values (allele + 1, 0 for missing) into a packed GT.
+static inline uint32_t combine(uint32_t a, uint32_t b, uint32_t flags)
+{
+    if(a > b)
+    {
+        uint32_t tmp = a;
+        a = b;
+        b = tmp;
+    }
+    return(a | (b << PackedGenotype::ALLELE_BITS) | flags);
+}
+
+
+uint32_t PackedGenotype::pack(const char* gt, int len)
+{
+    // Fast path for single digit diploid genotypes like "0/1" or "1|1".
+    if(len == 3)
+    {
+        char sep = gt[1];
+        char c1 = gt[0];
+        char c2 = gt[2];
+        if(((sep == '/') || (sep == '|')) &&
+           (((c1 >= '0') && (c1 <= '9')) || (c1 == '.')) &&
+           (((c2 >= '0') && (c2 <= '9')) || (c2 == '.')))
+        {
+            uint32_t a = (c1 == '.') ? 0 : (c1 - '0' + 1);
+            uint32_t b = (c2 == '.') ? 0 : (c2 - '0' + 1);
+            return(combine(a, b, (sep == '|') ? PHASED : 0));
+        }
+    }
+
+    // General case: parse the alleles separated by '/' or '|'.
+    uint32_t alleles[2];
+    int numAlleles = 0;
+    uint32_t flags = 0;
+    int i = 0;
+    while(i < len)
+    {
+        if(numAlleles == 2)
+        {
+            // More than diploid.
+            return(UNPACKABLE);
+        }
+        uint32_t allele = 0;
+        if(gt[i] == '.')
+        {
+            ++i;
+        }
+        else
+        {
+            int start = i;
+            while((i < len) && (gt[i] >= '0') && (gt[i] <= '9'))
+            {
+                allele = (allele * 10) + (gt[i] - '0');
+                if(allele >= ALLELE_MASK)
+                {
+                    // Too large to pack.
+                    return(UNPACKABLE);
+                }
+                ++i;
+            }
+            if(i == start)
+            {
+                // Not an allele.
+                return(UNPACKABLE);
+            }
+            ++allele;
+        }
+        alleles[numAlleles++] = allele;
+
+        if(i == len)
+        {
+            break;
+        }
+        // Next character must be a separator followed by another allele.
+        if(gt[i] == '|')
+        {
+            flags = PHASED;
+        }
+        else if(gt[i] != '/')
+        {
+            return(UNPACKABLE);
+        }
+        if(++i == len)
+        {
+            return(UNPACKABLE);
+        }
+    }
+
+    if(numAlleles == 1)
+    {
+        return(combine(alleles[0], alleles[0], HAPLOID));
+    }
+    if(numAlleles == 2)
+    {
+        return(combine(alleles[0], alleles[1], flags));
+    }
+    return(UNPACKABLE);
+}
+
+
+void PackedGenotype::compare(const uint32_t* gt1, const uint32_t* gt2,
+                             uint8_t* match, int numSamples)
+{
+    for(int i = 0; i < numSamples; i++)
+    {
+        match[i] = (((gt1[i] ^ gt2[i]) & ~PHASED) == 0) & ((gt1[i] & UNPACKABLE) == 0);
+    }
+}
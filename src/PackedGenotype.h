@@ -0,0 +1,88 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __PACKED_GENOTYPE_H__
+#define __PACKED_GENOTYPE_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/// Packs a GT string into a single integer so genotypes can be compared
+/// and classified with integer operations.
+/// Layout: bits 0-13 hold the smaller allele + 1 and bits 14-27 the
+/// larger allele + 1 (0 is a missing '.' allele), bit 28 is set for
+/// phased genotypes and bit 29 for haploid genotypes.
+/// The alleles are stored sorted, so "0/1" and "1/0" pack the same.
+/// GTs that cannot be packed (more than diploid, too many alleles, or
+/// malformed) are flagged UNPACKABLE and must be compared as strings.
+class PackedGenotype
+{
+public:
+    static const uint32_t ALLELE_BITS = 14;
+    static const uint32_t ALLELE_MASK = (1 << ALLELE_BITS) - 1;
+    static const uint32_t PHASED = 1 << 28;
+    static const uint32_t HAPLOID = 1 << 29;
+    static const uint32_t UNPACKABLE = 1 << 30;
+    /// No GT found for the sample.
+    static const uint32_t NO_GT = 0xFFFFFFFF;
+
+    /// Packed values of the unphased 0/0, 0/1 (or 1/0), and 1/1 genotypes.
+    static const uint32_t UNPHASED_00 = 1 | (1 << ALLELE_BITS);
+    static const uint32_t UNPHASED_01 = 1 | (2 << ALLELE_BITS);
+    static const uint32_t UNPHASED_11 = 2 | (2 << ALLELE_BITS);
+
+    /// Pack the specified GT string.
+    static uint32_t pack(const char* gt, int len);
+    /// Pack the specified GT string, returning NO_GT if it is NULL.
+    static inline uint32_t pack(const std::string* gt)
+    {
+        if(gt == NULL)
+        {
+            return(NO_GT);
+        }
+        return(pack(gt->c_str(), gt->length()));
+    }
+
+    /// Returns true if the two packed genotypes are known to be the same,
+    /// ignoring phase, so "0|0" matches "0/0".
+    /// Returns false if either is NO_GT or UNPACKABLE.
+    static inline bool isSame(uint32_t gt1, uint32_t gt2)
+    {
+        return((((gt1 ^ gt2) & ~PHASED) == 0) && ((gt1 & UNPACKABLE) == 0));
+    }
+
+    /// Set match[i] to 1 if gt1[i] and gt2[i] are known to be the same
+    /// (as isSame), 0 if not.  Written without branches so it vectorizes
+    /// across samples.
+    static void compare(const uint32_t* gt1, const uint32_t* gt2,
+                        uint8_t* match, int numSamples);
+
+    /// Get the smaller/larger allele index, -1 if missing ('.').
+    static inline int getAllele1(uint32_t gt)
+    {
+        return((int)(gt & ALLELE_MASK) - 1);
+    }
+    static inline int getAllele2(uint32_t gt)
+    {
+        return((int)((gt >> ALLELE_BITS) & ALLELE_MASK) - 1);
+    }
+};
+
+#endif
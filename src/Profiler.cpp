@@ -0,0 +1,179 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <vector>
+
+#include "Profiler.h"
+
+static const char* STAGE_NAMES[NUM_PROFILE_STAGES] =
+{"read", "tokenize", "parseSamples", "filter", "reference", "format", "write"};
+
+// Counters of 1 thread.
+struct ThreadCounters
+{
+    int threadIndex;
+    uint64_t ns[NUM_PROFILE_STAGES];
+    uint64_t calls[NUM_PROFILE_STAGES];
+    uint64_t items[NUM_PROFILE_STAGES];
+};
+
+// The calling thread's counters, created on its first profiled stage.
+static __thread ThreadCounters* threadCounters = NULL;
+
+static pthread_mutex_t allCountersLock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<ThreadCounters*> allCounters;
+static std::string profiledTool;
+static uint64_t profileStartNs = 0;
+
+bool Profiler::ourEnabled = false;
+
+
+static ThreadCounters& getThreadCounters()
+{
+    if(threadCounters == NULL)
+    {
+        ThreadCounters* counters = new ThreadCounters;
+        memset(counters, 0, sizeof(ThreadCounters));
+        pthread_mutex_lock(&allCountersLock);
+        counters->threadIndex = allCounters.size();
+        allCounters.push_back(counters);
+        pthread_mutex_unlock(&allCountersLock);
+        threadCounters = counters;
+    }
+    return(*threadCounters);
+}
+
+
+void Profiler::enable(const char* toolName)
+{
+    profiledTool = toolName;
+    profileStartNs = getNs();
+    // The enabling thread is thread 0.
+    getThreadCounters();
+    ourEnabled = true;
+}
+
+
+void Profiler::addTime(ProfileStage stage, uint64_t ns)
+{
+    ThreadCounters& counters = getThreadCounters();
+    counters.ns[stage] += ns;
+    ++counters.calls[stage];
+}
+
+
+void Profiler::addItems(ProfileStage stage, uint64_t numItems)
+{
+    getThreadCounters().items[stage] += numItems;
+}
+
+
+// Print 1 row of the summary table.
+static void printRow(const char* stage, const char* thread, uint64_t calls,
+                     uint64_t items, uint64_t ns, uint64_t wallNs)
+{
+    fprintf(stderr, "%-13s %6s %12" PRIu64 " %12" PRIu64 " %10.3f %6.1f\n",
+            stage, thread, calls, items, ns / 1e9,
+            (wallNs == 0) ? 0.0 : (100.0 * ns / wallNs));
+}
+
+
+bool Profiler::report(const std::string& jsonFile)
+{
+    if(!ourEnabled)
+    {
+        return(true);
+    }
+    uint64_t wallNs = getNs() - profileStartNs;
+
+    pthread_mutex_lock(&allCountersLock);
+    std::vector<ThreadCounters*> counters = allCounters;
+    pthread_mutex_unlock(&allCountersLock);
+
+    fprintf(stderr, "\nProfile of %s: %.3f seconds wall time\n",
+            profiledTool.c_str(), wallNs / 1e9);
+    fprintf(stderr, "%-13s %6s %12s %12s %10s %6s\n",
+            "stage", "thread", "calls", "items", "seconds", "%wall");
+    for(int s = 0; s < NUM_PROFILE_STAGES; s++)
+    {
+        uint64_t totalCalls = 0;
+        uint64_t totalItems = 0;
+        uint64_t totalNs = 0;
+        int numThreads = 0;
+        for(unsigned int t = 0; t < counters.size(); t++)
+        {
+            const ThreadCounters& thread = *(counters[t]);
+            if((thread.calls[s] == 0) && (thread.items[s] == 0))
+            {
+                continue;
+            }
+            char threadName[16];
+            snprintf(threadName, sizeof(threadName), "%d", thread.threadIndex);
+            printRow(STAGE_NAMES[s], threadName, thread.calls[s],
+                     thread.items[s], thread.ns[s], wallNs);
+            totalCalls += thread.calls[s];
+            totalItems += thread.items[s];
+            totalNs += thread.ns[s];
+            ++numThreads;
+        }
+        if(numThreads > 1)
+        {
+            printRow(STAGE_NAMES[s], "all", totalCalls, totalItems, totalNs,
+                     wallNs);
+        }
+    }
+
+    if(jsonFile.empty())
+    {
+        return(true);
+    }
+    FILE* json = fopen(jsonFile.c_str(), "w");
+    if(json == NULL)
+    {
+        fprintf(stderr, "Failed to open %s\n", jsonFile.c_str());
+        return(false);
+    }
+    fprintf(json, "{\"tool\": \"%s\", \"wallNs\": %" PRIu64 ", \"threads\": [",
+            profiledTool.c_str(), wallNs);
+    for(unsigned int t = 0; t < counters.size(); t++)
+    {
+        const ThreadCounters& thread = *(counters[t]);
+        fprintf(json, "%s\n  {\"thread\": %d, \"stages\": {",
+                (t == 0) ? "" : ",", thread.threadIndex);
+        bool first = true;
+        for(int s = 0; s < NUM_PROFILE_STAGES; s++)
+        {
+            if((thread.calls[s] == 0) && (thread.items[s] == 0))
+            {
+                continue;
+            }
+            fprintf(json, "%s\"%s\": {\"calls\": %" PRIu64 ", \"items\": %"
+                    PRIu64 ", \"ns\": %" PRIu64 "}", first ? "" : ", ",
+                    STAGE_NAMES[s], thread.calls[s], thread.items[s],
+                    thread.ns[s]);
+            first = false;
+        }
+        fprintf(json, "}}");
+    }
+    fprintf(json, "\n]}\n");
+    return(fclose(json) == 0);
+}
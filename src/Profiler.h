@@ -0,0 +1,122 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdint.h>
+#include <time.h>
+#include <string>
+
+/// Stages of processing that profiled time is attributed to.
+enum ProfileStage
+{
+    PROFILE_READ = 0,       // reading & decompressing records
+    PROFILE_TOKENIZE,       // splitting records into columns
+    PROFILE_PARSE_SAMPLES,  // parsing the per sample fields
+    PROFILE_FILTER,         // region & record filters
+    PROFILE_REFERENCE,      // reference lookups & allele updates
+    PROFILE_FORMAT,         // formatting output records
+    PROFILE_WRITE,          // compressing & writing output
+    NUM_PROFILE_STAGES
+};
+
+
+/// Collects the time spent in each ProfileStage, with separate counters
+/// for each thread so timing does not need any locking.
+/// The PROFILE_ macros below only time anything when built with
+/// VCF_PROFILE defined (make PROFILE=1) and then only when enabled with
+/// --profile, so normal builds have no overhead.
+class Profiler
+{
+public:
+    /// Start profiling the specified tool.
+    static void enable(const char* toolName);
+
+    static bool isEnabled() { return(ourEnabled); }
+
+    static uint64_t getNs()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return(((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec);
+    }
+
+    /// Add a timed call of the stage to the calling thread's counters.
+    static void addTime(ProfileStage stage, uint64_t ns);
+
+    /// Add the number of items (records, bytes, ...) processed by the
+    /// stage to the calling thread's counters.
+    static void addItems(ProfileStage stage, uint64_t numItems);
+
+    /// Print a summary table to stderr and, if jsonFile is not empty,
+    /// write the counters as JSON to it.  Returns false if the JSON
+    /// could not be written.
+    static bool report(const std::string& jsonFile);
+
+private:
+    Profiler();
+
+    static bool ourEnabled;
+};
+
+
+/// Times from construction to destruction when profiling is enabled.
+class ProfileTimer
+{
+public:
+    ProfileTimer(ProfileStage stage)
+        : myStage(stage),
+          myStart(Profiler::isEnabled() ? Profiler::getNs() : 0)
+    {
+    }
+
+    ~ProfileTimer()
+    {
+        if(myStart != 0)
+        {
+            Profiler::addTime(myStage, Profiler::getNs() - myStart);
+        }
+    }
+
+private:
+    ProfileStage myStage;
+    uint64_t myStart;
+};
+
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+#ifdef VCF_PROFILE
+/// Time the rest of the enclosing scope.
+#define PROFILE_SCOPE(stage) \
+    ProfileTimer PROFILE_CONCAT(profileTimer, __LINE__)(stage)
+/// Time the expression, evaluating to its value.
+#define PROFILE_CALL(stage, expr) (ProfileTimer(stage), (expr))
+/// Count items processed by the stage.
+#define PROFILE_ITEMS(stage, numItems) \
+    do { if(Profiler::isEnabled()) Profiler::addItems(stage, numItems); } while(0)
+#else
+#define PROFILE_SCOPE(stage)
+#define PROFILE_CALL(stage, expr) (expr)
+#define PROFILE_ITEMS(stage, numItems)
+#endif
+
+#endif
@@ -0,0 +1,356 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "ProgressReporter.h"
+#include "VcfRecord.h"
+
+// After asking the record loop for its position, wait this long for it
+// before reporting.
+static const long POSITION_WAIT_NS = 50000000;
+
+static uint64_t getNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return(((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec);
+}
+
+
+// Get the time the specified number of ns from now for waitUntil.
+static struct timespec getDeadline(uint64_t ns)
+{
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    uint64_t untilNs = until.tv_nsec + ns;
+    until.tv_sec += untilNs / 1000000000;
+    until.tv_nsec = untilNs % 1000000000;
+    return(until);
+}
+
+
+// Wait on the condition until the deadline or until stopping is set,
+// ignoring spurious wakeups.  Returns whether stopping was set.
+static bool waitUntil(pthread_cond_t* cond, pthread_mutex_t* lock,
+                      const struct timespec& until, volatile bool& stopping)
+{
+    while(!stopping)
+    {
+        if(pthread_cond_timedwait(cond, lock, &until) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    return(stopping);
+}
+
+
+// Format a duration as hours, minutes & seconds.
+static std::string formatSecs(double secs)
+{
+    char buffer[64];
+    uint64_t total = (uint64_t)(secs + 0.5);
+    snprintf(buffer, sizeof(buffer), "%" PRIu64 ":%02d:%02d", total / 3600,
+             (int)((total / 60) % 60), (int)(total % 60));
+    return(buffer);
+}
+
+
+ProgressReporter::ProgressReporter(const char* toolName, const char* inputFile)
+    : myToolName(toolName),
+      myInputSize(-1),
+      myInputType(UNKNOWN_INPUT),
+      myNumRecords(0),
+      myPositionWanted(false),
+      myOffsetWanted(false),
+      myRawOffset(-1),
+      myChrom(),
+      myPos(0),
+      myIntervalSecs(0),
+      myStatusFile(),
+      myStartNs(0),
+      myLastNs(0),
+      myLastRecords(0),
+      myLastOffset(0),
+      myStarted(false),
+      myStopping(false)
+{
+    // The size of the input is only known for files.
+    struct stat inputStat;
+    if((stat(inputFile, &inputStat) != 0) || !S_ISREG(inputStat.st_mode))
+    {
+        myInputSize = -1;
+    }
+    else
+    {
+        myInputSize = inputStat.st_size;
+        // iftell gives the file offset for uncompressed files & the
+        // offset of the block << 16 for BGZF, but the uncompressed
+        // offset for other gzip files, which can't be used.
+        unsigned char magic[14];
+        FILE* input = fopen(inputFile, "rb");
+        size_t len = (input == NULL) ? 0 : fread(magic, 1, sizeof(magic), input);
+        if(input != NULL)
+        {
+            fclose(input);
+        }
+        if((len < 2) || (magic[0] != 0x1f) || (magic[1] != 0x8b))
+        {
+            myInputType = PLAIN_INPUT;
+        }
+        else if((len == sizeof(magic)) && (magic[3] & 4) &&
+                (magic[12] == 'B') && (magic[13] == 'C'))
+        {
+            myInputType = BGZF_INPUT;
+        }
+    }
+    pthread_mutex_init(&myLock, NULL);
+    pthread_mutex_init(&myPositionLock, NULL);
+    pthread_cond_init(&myStopCond, NULL);
+}
+
+
+ProgressReporter::~ProgressReporter()
+{
+    stop();
+    pthread_cond_destroy(&myStopCond);
+    pthread_mutex_destroy(&myPositionLock);
+    pthread_mutex_destroy(&myLock);
+}
+
+
+bool ProgressReporter::start(int intervalSecs, const std::string& statusFile)
+{
+    myIntervalSecs = intervalSecs;
+    myStatusFile = statusFile;
+    myStartNs = getNs();
+    myLastNs = myStartNs;
+    myStopping = false;
+    if(pthread_create(&myThread, NULL, run, this) != 0)
+    {
+        return(false);
+    }
+    myStarted = true;
+    return(true);
+}
+
+
+void ProgressReporter::stop()
+{
+    if(!myStarted)
+    {
+        return;
+    }
+    pthread_mutex_lock(&myLock);
+    myStopping = true;
+    pthread_cond_signal(&myStopCond);
+    pthread_mutex_unlock(&myLock);
+    pthread_join(myThread, NULL);
+    myStarted = false;
+
+    report(true);
+}
+
+
+void ProgressReporter::setPosition(VcfRecord& record)
+{
+    // Never wait on the reporter: if it is copying the position, this
+    // record's position is skipped & the next record's is set instead.
+    if(pthread_mutex_trylock(&myPositionLock) != 0)
+    {
+        return;
+    }
+    myChrom = record.getChromStr();
+    myPos = record.get1BasedPosition();
+    myPositionWanted = false;
+    pthread_mutex_unlock(&myPositionLock);
+}
+
+
+void ProgressReporter::setPosition(const char* line)
+{
+    if(pthread_mutex_trylock(&myPositionLock) != 0)
+    {
+        return;
+    }
+    // CHROM & POS are the first 2 columns.
+    const char* chromEnd = strchr(line, '\t');
+    if(chromEnd != NULL)
+    {
+        myChrom.assign(line, chromEnd - line);
+        myPos = atoi(chromEnd + 1);
+    }
+    myPositionWanted = false;
+    pthread_mutex_unlock(&myPositionLock);
+}
+
+
+void* ProgressReporter::run(void* arg)
+{
+    ProgressReporter* reporter = (ProgressReporter*)arg;
+    pthread_mutex_lock(&(reporter->myLock));
+    while(!reporter->myStopping)
+    {
+        struct timespec until =
+            getDeadline((uint64_t)reporter->myIntervalSecs * 1000000000 - POSITION_WAIT_NS);
+        if(waitUntil(&(reporter->myStopCond), &(reporter->myLock), until,
+                     reporter->myStopping))
+        {
+            break;
+        }
+        // Ask the record loop where it is, then report.
+        reporter->myPositionWanted = true;
+        reporter->myOffsetWanted = true;
+        until = getDeadline(POSITION_WAIT_NS);
+        if(waitUntil(&(reporter->myStopCond), &(reporter->myLock), until,
+                     reporter->myStopping))
+        {
+            break;
+        }
+        // Report without the lock so stop() is never held up by the I/O.
+        pthread_mutex_unlock(&(reporter->myLock));
+        reporter->report(false);
+        pthread_mutex_lock(&(reporter->myLock));
+    }
+    pthread_mutex_unlock(&(reporter->myLock));
+    return(NULL);
+}
+
+
+int64_t ProgressReporter::getInputOffset()
+{
+    int64_t offset = myRawOffset;
+    if((myInputSize < 0) || (offset < 0))
+    {
+        return(-1);
+    }
+    if(myInputType == BGZF_INPUT)
+    {
+        return(offset >> 16);
+    }
+    return((myInputType == PLAIN_INPUT) ? offset : -1);
+}
+
+
+void ProgressReporter::report(bool done)
+{
+    uint64_t now = getNs();
+    uint64_t numRecords = myNumRecords;
+    pthread_mutex_lock(&myPositionLock);
+    std::string chrom = myChrom;
+    int pos = myPos;
+    pthread_mutex_unlock(&myPositionLock);
+    int64_t offset = getInputOffset();
+    if(done && (myInputSize >= 0) && (myInputType != UNKNOWN_INPUT))
+    {
+        // All of the input was read.
+        offset = myInputSize;
+    }
+    double elapsedSecs = (now - myStartNs) / 1e9;
+    double intervalSecs = (now - myLastNs) / 1e9;
+    if(intervalSecs <= 0)
+    {
+        intervalSecs = 1e-9;
+    }
+    double recordsPerSec = (numRecords - myLastRecords) / intervalSecs;
+    double bytesPerSec = 0;
+    double etaSecs = -1;
+    if(offset >= 0)
+    {
+        bytesPerSec = (offset - myLastOffset) / intervalSecs;
+        if((offset > 0) && (myInputSize >= offset))
+        {
+            etaSecs = elapsedSecs * (myInputSize - offset) / offset;
+        }
+    }
+    if(done)
+    {
+        // Report the overall rates.
+        recordsPerSec = numRecords / ((elapsedSecs > 0) ? elapsedSecs : 1e-9);
+        if(offset >= 0)
+        {
+            bytesPerSec = offset / ((elapsedSecs > 0) ? elapsedSecs : 1e-9);
+        }
+        etaSecs = 0;
+    }
+    myLastNs = now;
+    myLastRecords = numRecords;
+    if(offset >= 0)
+    {
+        myLastOffset = offset;
+    }
+
+    fprintf(stderr, "%s: %s %" PRIu64 " records (%.0f/s)", myToolName.c_str(),
+            done ? "finished" : "read", numRecords, recordsPerSec);
+    if(offset >= 0)
+    {
+        fprintf(stderr, ", %.1f of %.1f MB (%.1f MB/s)", offset / 1e6,
+                myInputSize / 1e6, bytesPerSec / 1e6);
+    }
+    if(!done && !chrom.empty())
+    {
+        fprintf(stderr, ", at %s:%d", chrom.c_str(), pos);
+    }
+    fprintf(stderr, ", elapsed %s", formatSecs(elapsedSecs).c_str());
+    if(!done && (etaSecs >= 0))
+    {
+        fprintf(stderr, ", ETA %s", formatSecs(etaSecs).c_str());
+    }
+    fprintf(stderr, "\n");
+
+    if(myStatusFile.empty())
+    {
+        return;
+    }
+    // Write a new status file & rename it over the old one so readers
+    // never see a partial status.
+    std::string tmpName = myStatusFile + ".tmp";
+    FILE* status = fopen(tmpName.c_str(), "w");
+    if(status == NULL)
+    {
+        fprintf(stderr, "Failed to open %s - %s\n", tmpName.c_str(),
+                strerror(errno));
+        return;
+    }
+    fprintf(status, "{\"tool\": \"%s\", \"done\": %s, \"records\": %" PRIu64
+            ", \"recordsPerSec\": %.1f, \"bytesRead\": %" PRId64
+            ", \"fileSize\": %" PRId64 ", \"bytesPerSec\": %.1f, \"contig\": \"",
+            myToolName.c_str(), done ? "true" : "false", numRecords,
+            recordsPerSec, offset, myInputSize, bytesPerSec);
+    for(unsigned int i = 0; i < chrom.size(); i++)
+    {
+        if((chrom[i] == '"') || (chrom[i] == '\\'))
+        {
+            fputc('\\', status);
+        }
+        fputc(chrom[i], status);
+    }
+    fprintf(status, "\", \"pos\": %d, \"elapsedSecs\": %.1f, \"etaSecs\": %.1f}\n",
+            pos, elapsedSecs, etaSecs);
+    if((fclose(status) != 0) || (rename(tmpName.c_str(), myStatusFile.c_str()) != 0))
+    {
+        fprintf(stderr, "Failed to write %s\n", myStatusFile.c_str());
+    }
+}
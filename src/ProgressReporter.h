@@ -0,0 +1,141 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __PROGRESS_REPORTER_H__
+#define __PROGRESS_REPORTER_H__
+
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+
+#include "InputFile.h"
+#include "VcfFileReader.h"
+
+/// VcfFileReader that gives a ProgressReporter the file it is reading.
+class ProgressVcfFileReader : public VcfFileReader
+{
+public:
+    /// Get the input file, NULL if it is not open.
+    IFILE getInputFile() { return(myFilePtr); }
+};
+
+
+/// Periodically reports the progress of a tool through its input from a
+/// background thread: records/s, bytes/s, the current contig:pos, and the
+/// ETA estimated from how far the input file has been read.
+/// Reports go to stderr and, if specified, to a status file of JSON that
+/// is replaced atomically each time for schedulers to poll.
+/// The record loop only increments a counter and checks flags, copying
+/// the record's position & the input's offset only when the reporter
+/// thread asks for them, so it never waits on the reporter's I/O.
+class ProgressReporter
+{
+public:
+    /// Seconds between reports for tools that only write a status file.
+    static const int DEFAULT_INTERVAL_SECS = 10;
+
+    /// Report on the progress through the specified input file.
+    ProgressReporter(const char* toolName, const char* inputFile);
+    ~ProgressReporter();
+
+    /// Start reporting every intervalSecs seconds, returning false if the
+    /// reporter thread could not be started.
+    bool start(int intervalSecs, const std::string& statusFile);
+
+    /// Stop reporting, writing a final report.
+    void stop();
+
+    /// Count a processed record.
+    inline void update(VcfRecord& record)
+    {
+        ++myNumRecords;
+        if(myPositionWanted)
+        {
+            setPosition(record);
+        }
+    }
+
+    /// Count a processed record from its line text, for tools that scan
+    /// lines rather than reading VcfRecords.
+    inline void update(const char* line)
+    {
+        ++myNumRecords;
+        if(myPositionWanted)
+        {
+            setPosition(line);
+        }
+    }
+
+    /// Note how far the input has been read.  Call from the thread
+    /// reading the input, which may not be the one counting records.
+    inline void updateOffset(IFILE input)
+    {
+        if(myOffsetWanted)
+        {
+            myOffsetWanted = false;
+            myRawOffset = (input == NULL) ? -1 : iftell(input);
+        }
+    }
+
+private:
+    ProgressReporter();
+    ProgressReporter(const ProgressReporter&);
+    ProgressReporter& operator=(const ProgressReporter&);
+
+    static void* run(void* arg);
+    void setPosition(VcfRecord& record);
+    void setPosition(const char* line);
+    void report(bool done);
+    // Get how far the input file has been read, -1 if unknown.
+    int64_t getInputOffset();
+
+    // How iftell offsets of the input map to file offsets.
+    enum InputType {UNKNOWN_INPUT, PLAIN_INPUT, BGZF_INPUT};
+
+    std::string myToolName;
+    int64_t myInputSize;
+    InputType myInputType;
+
+    volatile uint64_t myNumRecords;
+    volatile bool myPositionWanted;
+    volatile bool myOffsetWanted;
+    // Last iftell of the input, -1 if not yet known.
+    volatile int64_t myRawOffset;
+    // Guards the position, which the record loop only sets if it can
+    // lock it without waiting.
+    pthread_mutex_t myPositionLock;
+    std::string myChrom;
+    int myPos;
+
+    int myIntervalSecs;
+    std::string myStatusFile;
+    uint64_t myStartNs;
+    uint64_t myLastNs;
+    uint64_t myLastRecords;
+    int64_t myLastOffset;
+
+    pthread_t myThread;
+    // Guards stopping the reporter thread.
+    pthread_mutex_t myLock;
+    pthread_cond_t myStopCond;
+    bool myStarted;
+    bool myStopping;
+};
+
+#endif
@@ -0,0 +1,221 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "ReferenceManager.h"
+
+pthread_mutex_t ReferenceManager::ourLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t ReferenceManager::ourOpenedCond = PTHREAD_COND_INITIALIZER;
+std::map<std::string, GenomeSequence*> ReferenceManager::ourReferences;
+
+
+const GenomeSequence& ReferenceManager::getReference(const char* refName)
+{
+    std::string name = refName;
+    GenomeSequence* reference = NULL;
+    pthread_mutex_lock(&ourLock);
+    while(true)
+    {
+        std::map<std::string, GenomeSequence*>::iterator iter =
+            ourReferences.find(name);
+        if(iter == ourReferences.end())
+        {
+            break;
+        }
+        if(iter->second != NULL)
+        {
+            reference = iter->second;
+            break;
+        }
+        // Another thread is opening it.
+        pthread_cond_wait(&ourOpenedCond, &ourLock);
+    }
+
+    if(reference == NULL)
+    {
+        // Open it without the lock so other references can be looked up
+        // & opened meanwhile, leaving a placeholder so other threads wait
+        // for this one rather than opening it too.  It is removed if the
+        // reference fails to open so the next caller tries again.
+        ourReferences[name] = NULL;
+        pthread_mutex_unlock(&ourLock);
+        try
+        {
+            reference = openOrBuild(name);
+        }
+        catch(...)
+        {
+            pthread_mutex_lock(&ourLock);
+            ourReferences.erase(name);
+            pthread_cond_broadcast(&ourOpenedCond);
+            pthread_mutex_unlock(&ourLock);
+            throw;
+        }
+        pthread_mutex_lock(&ourLock);
+        if(reference != NULL)
+        {
+            ourReferences[name] = reference;
+        }
+        else
+        {
+            ourReferences.erase(name);
+        }
+        pthread_cond_broadcast(&ourOpenedCond);
+    }
+    pthread_mutex_unlock(&ourLock);
+
+    if(reference == NULL)
+    {
+        throw(std::runtime_error("Failed opening the reference " + name));
+    }
+    return(*reference);
+}
+
+
+GenomeSequence* ReferenceManager::openPacked(const std::string& refName)
+{
+    GenomeSequence* reference = new GenomeSequence();
+    reference->setReferenceName(refName);
+    reference->useMemoryMap(true);
+    // open returns true on failure.
+    if(reference->open())
+    {
+        delete reference;
+        return(NULL);
+    }
+    return(reference);
+}
+
+
+GenomeSequence* ReferenceManager::openOrBuild(const std::string& refName)
+{
+    GenomeSequence* reference = openPacked(refName);
+    if(reference != NULL)
+    {
+        return(reference);
+    }
+
+    // Not built yet, so only let 1 process build it.  The lock file is
+    // left in place since removing it would let a waiting process lock
+    // a file that a new process no longer sees.
+    std::string lockName = refName + ".lock";
+    int lockFd = open(lockName.c_str(), O_RDWR | O_CREAT, 0666);
+    if(lockFd < 0)
+    {
+        std::cerr << "Failed opening the reference lock file " << lockName
+                  << " - " << strerror(errno) << "\n";
+        return(NULL);
+    }
+    while((flock(lockFd, LOCK_EX) != 0) && (errno == EINTR))
+    {
+    }
+
+    // Another process may have built it while this one waited.
+    reference = openPacked(refName);
+    if((reference == NULL) && buildPacked(refName))
+    {
+        reference = openPacked(refName);
+    }
+
+    flock(lockFd, LOCK_UN);
+    close(lockFd);
+    return(reference);
+}
+
+
+bool ReferenceManager::buildPacked(const std::string& refName)
+{
+    // Build in a temporary directory beside the reference so the
+    // rename into place is atomic.
+    std::string dirName = ".";
+    std::string baseName = refName;
+    std::string::size_type slash = refName.rfind('/');
+    if(slash != std::string::npos)
+    {
+        dirName = refName.substr(0, (slash == 0) ? 1 : slash);
+        baseName = refName.substr(slash + 1);
+    }
+    std::string tmpTemplate = dirName + "/." + baseName + ".buildXXXXXX";
+    std::vector<char> tmpBuf(tmpTemplate.begin(), tmpTemplate.end());
+    tmpBuf.push_back('\0');
+    if(mkdtemp(&(tmpBuf[0])) == NULL)
+    {
+        std::cerr << "Failed creating a directory to build the packed reference in "
+                  << dirName << " - " << strerror(errno) << "\n";
+        return(false);
+    }
+    std::string tmpDir = &(tmpBuf[0]);
+    std::string tmpRef = tmpDir + "/" + baseName;
+
+    std::cerr << "Building the packed reference for " << refName << "\n";
+    bool built = (symlink(("../" + baseName).c_str(), tmpRef.c_str()) == 0);
+    if(built)
+    {
+        GenomeSequence builder;
+        builder.setReferenceName(tmpRef);
+        // create returns true on failure.
+        built = !builder.create(false);
+    }
+    if(!built)
+    {
+        std::cerr << "Failed building the packed reference for " << refName
+                  << "\n";
+    }
+
+    // Move everything that was built next to the reference, then
+    // clean up the temporary directory.
+    DIR* dir = opendir(tmpDir.c_str());
+    struct dirent* entry = NULL;
+    while((dir != NULL) && ((entry = readdir(dir)) != NULL))
+    {
+        std::string entryName = entry->d_name;
+        if((entryName == ".") || (entryName == ".."))
+        {
+            continue;
+        }
+        std::string tmpName = tmpDir + "/" + entryName;
+        if(built && (entryName != baseName) &&
+           (rename(tmpName.c_str(), (dirName + "/" + entryName).c_str()) == 0))
+        {
+            continue;
+        }
+        if(built && (entryName != baseName))
+        {
+            std::cerr << "Failed moving the packed reference into "
+                      << dirName << " - " << strerror(errno) << "\n";
+            built = false;
+        }
+        unlink(tmpName.c_str());
+    }
+    if(dir != NULL)
+    {
+        closedir(dir);
+    }
+    rmdir(tmpDir.c_str());
+    return(built);
+}
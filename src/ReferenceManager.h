@@ -0,0 +1,65 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __REFERENCE_MANAGER_H__
+#define __REFERENCE_MANAGER_H__
+
+#include <map>
+#include <string>
+#include <pthread.h>
+
+#include "GenomeSequence.h"
+
+/// Opens references as memory mapped packed (.umfa) images, so every
+/// process using a reference shares 1 copy through the page cache.
+/// The packed image is built on first use: 1 process builds it under a
+/// lock file in a temporary directory next to the reference and renames
+/// it into place, so concurrent jobs never race on or rebuild a partial
+/// image, and later jobs just map it.
+/// Each reference is opened once per process & kept open until exit.
+class ReferenceManager
+{
+public:
+    /// Get the specified reference, opening it (and building its packed
+    /// image if needed) on first use.  Safe to call from multiple threads;
+    /// only threads wanting the same reference wait while it is opened.
+    /// Throws std::runtime_error if the reference cannot be opened.
+    static const GenomeSequence& getReference(const char* refName);
+
+private:
+    ReferenceManager();
+
+    // Open the packed image, returning NULL if it does not exist/fails.
+    static GenomeSequence* openPacked(const std::string& refName);
+
+    // Open the packed image, building it under the lock file if needed.
+    static GenomeSequence* openOrBuild(const std::string& refName);
+
+    // Build the packed image and rename it next to the reference.
+    static bool buildPacked(const std::string& refName);
+
+    // Guards ourReferences, but is not held while opening a reference.
+    static pthread_mutex_t ourLock;
+    // Signaled when a reference is done being opened.
+    static pthread_cond_t ourOpenedCond;
+    // Open references, NULL while one thread opens it & others wait.
+    static std::map<std::string, GenomeSequence*> ourReferences;
+};
+
+#endif
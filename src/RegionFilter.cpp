@@ -0,0 +1,343 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "RegionFilter.h"
+#include "InputFile.h"
+#include "StringBasics.h"
+#include "StringArray.h"
+
+pthread_mutex_t RegionFilter::ourLock = PTHREAD_MUTEX_INITIALIZER;
+std::map<std::string, RegionFilter::Regions*> RegionFilter::ourRegions;
+
+
+// Get the key the regions of the file are shared by: its real path,
+// size & modification time, so a file that is replaced or changed is
+// parsed again.  Returns false if the file is not a regular file (such as
+// a pipe), whose regions can not be shared.
+static bool getSharedKey(const char* filename, std::string& key)
+{
+    char path[PATH_MAX];
+    struct stat fileStat;
+    if((realpath(filename, path) == NULL) || (stat(path, &fileStat) != 0) ||
+       !S_ISREG(fileStat.st_mode))
+    {
+        return(false);
+    }
+    char version[64];
+    snprintf(version, sizeof(version), "\t%lld\t%lld.%09ld",
+             (long long)fileStat.st_size, (long long)fileStat.st_mtime,
+             (long)fileStat.st_mtim.tv_nsec);
+    key = path;
+    key += version;
+    return(true);
+}
+
+
+RegionFilter::RegionFilter()
+    : myRegions(NULL),
+      myAllCursor(NULL),
+      myCursors(),
+      myCurChrom(),
+      myCurCursor(NULL),
+      myHaveCurChrom(false)
+{
+}
+
+
+RegionFilter::~RegionFilter()
+{
+    clear();
+}
+
+
+RegionFilter::Regions::Regions()
+    : allChroms(),
+      chroms(),
+      chromOrder(),
+      key(),
+      numUsers(1)
+{
+}
+
+
+RegionFilter::Regions::~Regions()
+{
+    for(std::map<std::string, IntervalIndex<int>*>::iterator iter = chroms.begin();
+        iter != chroms.end(); iter++)
+    {
+        delete iter->second;
+    }
+}
+
+
+bool RegionFilter::load(const char* filename)
+{
+    clear();
+
+    std::string key;
+    if(!getSharedKey(filename, key))
+    {
+        // Not shared, so only this filter uses the regions.
+        myRegions = parse(filename);
+        if(myRegions == NULL)
+        {
+            return(false);
+        }
+        myAllCursor = new IntervalIndex<int>::Cursor(myRegions->allChroms);
+        return(true);
+    }
+
+    pthread_mutex_lock(&ourLock);
+    std::map<std::string, Regions*>::iterator iter = ourRegions.find(key);
+    if(iter == ourRegions.end())
+    {
+        Regions* regions = parse(filename);
+        if(regions == NULL)
+        {
+            pthread_mutex_unlock(&ourLock);
+            return(false);
+        }
+        regions->key = key;
+        iter = ourRegions.insert(std::make_pair(key, regions)).first;
+    }
+    else
+    {
+        ++(iter->second->numUsers);
+    }
+    myRegions = iter->second;
+    pthread_mutex_unlock(&ourLock);
+
+    myAllCursor = new IntervalIndex<int>::Cursor(myRegions->allChroms);
+    return(true);
+}
+
+
+void RegionFilter::release(Regions* regions)
+{
+    if(regions == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&ourLock);
+    bool last = (--(regions->numUsers) == 0);
+    if(last && !regions->key.empty())
+    {
+        ourRegions.erase(regions->key);
+    }
+    pthread_mutex_unlock(&ourLock);
+    if(last)
+    {
+        delete regions;
+    }
+}
+
+
+RegionFilter::Regions* RegionFilter::parse(const char* filename)
+{
+    IFILE regionFile = ifopen(filename, "r");
+    if(regionFile == NULL)
+    {
+        return(NULL);
+    }
+    Regions* regions = new Regions();
+
+    String regionLine;
+    StringArray regionColumn;
+    int start;
+    int end;
+    int intervalVal = 1;
+    while(regionFile->isOpen() && !regionFile->ifeof())
+    {
+        // Read the next interval
+        regionLine.Clear();
+        regionLine.ReadLine(regionFile);
+        if(regionLine.IsEmpty() || (regionLine[0] == '#') ||
+           (strncmp(regionLine.c_str(), "track", 5) == 0) ||
+           (strncmp(regionLine.c_str(), "browser", 7) == 0))
+        {
+            // Nothing on this line or a BED header, continue to the next.
+            continue;
+        }
+        regionColumn.ReplaceTokens(regionLine, " \t\r");
+        if(regionColumn.Length() < 2)
+        {
+            std::cerr << "Improperly formatted region line: "
+                      << regionLine << "; skipping to the next line.\n";
+            continue;
+        }
+        // A chromosome column means the line is BED.
+        bool bed = (regionColumn.Length() > 2);
+        int startCol = bed ? 1 : 0;
+
+        // Convert the columns to integers.
+        if(!regionColumn[startCol].AsInteger(start))
+        {
+            // The start position is not an integer.
+            std::cerr << "Improperly formatted region line, start position "
+                      << "(" << (bed ? "2nd" : "1st") << " column) is not an integer: "
+                      << regionColumn[startCol]
+                      << "; Skipping to the next line.\n";
+            continue;
+        }
+        if(!regionColumn[startCol + 1].AsInteger(end))
+        {
+            // The end position is not an integer.
+            std::cerr << "Improperly formatted region line, end position "
+                      << "(" << (bed ? "3rd" : "2nd") << " column) is not an integer: "
+                      << regionColumn[startCol + 1]
+                      << "; Skipping to the next line.\n";
+            continue;
+        }
+
+        if(!bed)
+        {
+            // Add 1-based inclusive intervals.
+            regions->allChroms.add(start, end, intervalVal);
+            continue;
+        }
+
+        // BED is 0-based start, exclusive end, so convert to
+        // 1-based inclusive.
+        std::string chrom = regionColumn[0].c_str();
+        std::map<std::string, IntervalIndex<int>*>::iterator iter =
+            regions->chroms.find(chrom);
+        if(iter == regions->chroms.end())
+        {
+            iter = regions->chroms.insert(std::make_pair(chrom, new IntervalIndex<int>())).first;
+            regions->chromOrder.push_back(chrom);
+        }
+        iter->second->add(start + 1, end, intervalVal);
+    }
+    ifclose(regionFile);
+
+    regions->allChroms.build();
+    for(std::map<std::string, IntervalIndex<int>*>::iterator iter = regions->chroms.begin();
+        iter != regions->chroms.end(); iter++)
+    {
+        iter->second->build();
+    }
+    return(regions);
+}
+
+
+bool RegionFilter::contains(const char* chrom, int position)
+{
+    if(myRegions == NULL)
+    {
+        return(false);
+    }
+    if(hasAllChromRegions())
+    {
+        if(myAllCursor->overlaps(position))
+        {
+            return(true);
+        }
+    }
+
+    // Only look up the chromosome's cursor when the chromosome changes.
+    if(!myHaveCurChrom || (myCurChrom != chrom))
+    {
+        myCurChrom = chrom;
+        myHaveCurChrom = true;
+        std::map<std::string, IntervalIndex<int>::Cursor*>::iterator iter =
+            myCursors.find(myCurChrom);
+        if(iter == myCursors.end())
+        {
+            // First time checking this chromosome.
+            std::map<std::string, IntervalIndex<int>*>::const_iterator regionIter =
+                myRegions->chroms.find(myCurChrom);
+            IntervalIndex<int>::Cursor* cursor = NULL;
+            if(regionIter != myRegions->chroms.end())
+            {
+                cursor = new IntervalIndex<int>::Cursor(*(regionIter->second));
+            }
+            iter = myCursors.insert(std::make_pair(myCurChrom, cursor)).first;
+        }
+        myCurCursor = iter->second;
+    }
+    return((myCurCursor != NULL) && myCurCursor->overlaps(position));
+}
+
+
+void RegionFilter::getSections(int maxGap, std::vector<Section>& sections) const
+{
+    if(myRegions == NULL)
+    {
+        return;
+    }
+    Section section;
+    for(unsigned int c = 0; c < myRegions->chromOrder.size(); c++)
+    {
+        const std::string& chrom = myRegions->chromOrder[c];
+        const IntervalIndex<int>& index = *(myRegions->chroms.find(chrom)->second);
+        section.chrom = chrom;
+        bool haveSection = false;
+        for(int i = 0; i < index.size(); i++)
+        {
+            if(index.getEnd(i) < index.getStart(i))
+            {
+                // Empty region.
+                continue;
+            }
+            if(haveSection && (index.getStart(i) <= section.end + maxGap + 1))
+            {
+                // Close enough to the current section to extend it.
+                if(index.getEnd(i) > section.end)
+                {
+                    section.end = index.getEnd(i);
+                }
+                continue;
+            }
+            if(haveSection)
+            {
+                sections.push_back(section);
+            }
+            section.start = index.getStart(i);
+            section.end = index.getEnd(i);
+            haveSection = true;
+        }
+        if(haveSection)
+        {
+            sections.push_back(section);
+        }
+    }
+}
+
+
+void RegionFilter::clear()
+{
+    for(std::map<std::string, IntervalIndex<int>::Cursor*>::iterator iter = myCursors.begin();
+        iter != myCursors.end(); iter++)
+    {
+        delete iter->second;
+    }
+    myCursors.clear();
+    delete myAllCursor;
+    myAllCursor = NULL;
+    release(myRegions);
+    myRegions = NULL;
+    myCurChrom.clear();
+    myCurCursor = NULL;
+    myHaveCurChrom = false;
+}
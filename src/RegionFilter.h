@@ -0,0 +1,115 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __REGION_FILTER_H__
+#define __REGION_FILTER_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <pthread.h>
+
+#include "IntervalIndex.h"
+
+/// Set of regions to keep, read from a file with one region per line in
+/// either of these formats:
+///     start end          - 1-based inclusive, applies to all chromosomes
+///     chrom start end    - BED (0-based start, exclusive end), any
+///                          additional columns are ignored
+/// Each chromosome's regions are kept in their own IntervalIndex.
+/// The indexes of each file are parsed once per process and shared by
+/// every RegionFilter that loads the file, each keeping its own cursors,
+/// and are freed when the last of those filters is cleared or destroyed.
+/// Files are identified by their real path, size & modification time,
+/// so a changed file is parsed again.
+class RegionFilter
+{
+public:
+    /// A section of a chromosome to read, 1-based inclusive.
+    struct Section
+    {
+        std::string chrom;
+        int start;
+        int end;
+    };
+
+    RegionFilter();
+    ~RegionFilter();
+
+    /// Read the regions from the specified file, or share them if
+    /// already read.  Improperly formatted lines are reported and skipped.
+    /// Returns false if the file could not be opened.
+    /// Safe to call from multiple threads.
+    bool load(const char* filename);
+
+    /// Returns whether the position is in any of the regions.
+    /// Fastest when called in order of position within each chromosome.
+    bool contains(const char* chrom, int position);
+
+    /// Returns whether any regions apply to all chromosomes.
+    bool hasAllChromRegions() const
+    { return((myRegions != NULL) && (myRegions->allChroms.size() != 0)); }
+
+    /// Get the sections covering all of the per chromosome regions, in
+    /// order of position within each chromosome, with the chromosomes in
+    /// the order they first appear in the file.  Regions separated by
+    /// maxGap or fewer bases are combined into a single section.
+    void getSections(int maxGap, std::vector<Section>& sections) const;
+
+private:
+    RegionFilter(const RegionFilter&);
+    RegionFilter& operator=(const RegionFilter&);
+
+    // Parsed regions of a file.
+    struct Regions
+    {
+        Regions();
+        ~Regions();
+        IntervalIndex<int> allChroms;
+        std::map<std::string, IntervalIndex<int>*> chroms;
+        std::vector<std::string> chromOrder;
+        // Key in ourRegions, empty if not shared.
+        std::string key;
+        // Number of filters using the regions, guarded by ourLock.
+        int numUsers;
+    };
+
+    // Read the regions of the file, returning NULL if it can't be opened.
+    static Regions* parse(const char* filename);
+
+    // Stop using the regions, freeing them if no other filter uses them.
+    static void release(Regions* regions);
+
+    void clear();
+
+    Regions* myRegions;
+    IntervalIndex<int>::Cursor* myAllCursor;
+    // Cursor of each chromosome checked, NULL if it has no regions.
+    std::map<std::string, IntervalIndex<int>::Cursor*> myCursors;
+
+    // Cursor of the last chromosome checked.
+    std::string myCurChrom;
+    IntervalIndex<int>::Cursor* myCurCursor;
+    bool myHaveCurChrom;
+
+    static pthread_mutex_t ourLock;
+    static std::map<std::string, Regions*> ourRegions;
+};
+
+#endif
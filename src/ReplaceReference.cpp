@@ -21,10 +21,10 @@
 #include "Parameters.h"
 #include "BgzfFileType.h"
 #include "GenomeSequence.h"
-#include "HyunVcfFile.h"
+#include "ReferenceManager.h"
 #include "VcfFileReader.h"
 #include "VcfFileWriter.h"
-#include <time.h>
+#include "Profiler.h"
 
 void ReplaceReference::replaceReferenceDescription()
 {
@@ -103,129 +103,9 @@ int ReplaceReference::execute(int argc, char **argv)
         inputParameters.Status();
     }
 
-    // Open the reference.
-    GenomeSequence reference(refFile);
+    // Open the reference, shared with other processes using it.
+    const GenomeSequence& reference = ReferenceManager::getReference(refFile);
 
-    time_t start;
-    time_t end;
-    
-
-    ////////////////////////////////////////////////////////////////////////////
-    // Using IFILE.
-    String outFileName;
-    start = time(NULL);
-    outFileName = "ifile_" + outputVcf;
-
-    // Open the vcf files.
-    IFILE vcfIn = ifopen(inputVcf, "r");
-    IFILE vcfOut = ifopen(outFileName, "w");
-
-    String line = "";
-    StringArray tokens;
-    while(!ifeof(vcfIn))
-    {
-        if(line.ReadLine(vcfIn) < 0)
-        {
-            // Error/end of file, exit loop.
-            break;
-        }
-
-        line += '\n';
-        // Check if it is a header line.
-        if(line[0] == '#')
-        {
-            // Meta/Header line, so just write it.
-            ifwrite(vcfOut, line.c_str(), line.Length());
-        }
-        else
-        {
-            // Data line.
-            // Parse out the tabs.
-            tokens.ReplaceColumns(line,'\t');
-
-            if(tokens.Length() < 4)
-            {
-                // Not enough tokens for having a reference, so just write it
-                ifwrite(vcfOut, line.c_str(), line.Length());
-            }
-            else
-            {
-                // Get the chromosome start position.
-                uint32_t chrStart = 
-                    reference.getGenomePosition(tokens[0].c_str());
-
-                int pos = 0;
-                if(tokens[1].AsInteger(pos))
-                {
-                    // Successfully converted to integer, so make 0 based.
-                    --pos;
-                    char newRef = reference[chrStart + pos];
-
-                    tokens[3] = newRef;
-                }
-
-                // Write out the line.
-                for(int i = 0; i < tokens.Length(); i++)
-                {
-                    if(i != 0)
-                    {
-                        ifprintf(vcfOut, "\t%s", tokens[i].c_str());
-                    }
-                    else
-                    {
-                        ifprintf(vcfOut, "%s", tokens[i].c_str());
-                    }
-                }
-            }
-        }
-    }
- 
-    ifclose(vcfOut);
-    ifclose(vcfIn);
-
-    end = time(NULL);
-
-    std::cerr << "Took: " << end-start << " to run IFILE verison\n";
-
-    ////////////////////////////////////////////////////////////////////////////
-    // Using Hyun's library.
-    start = time(NULL);
-    outFileName = "hyun_" + outputVcf;
-
-    HyunVcfFile inFileH;
-    IFILE outFileH;
-
-    // Open the files.
-    inFileH.openForRead(inputVcf);
-    outFileH = ifopen(outFileName.c_str(), "wb");
-
-    // Write the header.
-    inFileH.printVCFHeader(outFileH);
-
-    while(inFileH.iterateMarker())
-    {
-        VcfMarker* pMarker = inFileH.getLastMarker();
-
-        // Get the ref position.
-        genomeIndex_t markerIndex = 
-            reference.getGenomePosition(pMarker->sChrom.c_str(), pMarker->nPos);
-        
-        char newRef = reference[markerIndex];
-            
-        pMarker->sRef = newRef;
-        pMarker->printVCFMarker(outFileH,false);
-    }
-
-     ifclose(outFileH);
-     end = time(NULL);
-
-     std::cerr << "Took: " << end-start << " to run Hyun verison\n";
-
-    ////////////////////////////////////////////////////////////////////////////
-    // Using my library.
-    start = time(NULL);
-    outFileName = "lib_" + outputVcf;
-    
     VcfFileReader inFile;
     VcfHeader header;
     VcfFileWriter outFile;
@@ -233,28 +113,28 @@ int ReplaceReference::execute(int argc, char **argv)
     // Open the files.
     inFile.open(inputVcf, header);
     // Open and write the header
-    outFile.open(outFileName, header);
+    outFile.open(outputVcf, header);
 
     VcfRecord record;
 
     std::string newRef = "";
-    while(inFile.readRecord(record))
+    while(PROFILE_CALL(PROFILE_READ, inFile.readRecord(record)))
     {
-        // Get the ref position.
-        genomeIndex_t markerIndex = 
-            reference.getGenomePosition(record.getChromStr(), record.get1BasedPosition());
+        {
+            PROFILE_SCOPE(PROFILE_REFERENCE);
+            // Get the ref position.
+            genomeIndex_t markerIndex = 
+                reference.getGenomePosition(record.getChromStr(), record.get1BasedPosition());
         
-        newRef = reference[markerIndex];
+            newRef = reference[markerIndex];
         
-        record.setRef(newRef.c_str());
-        outFile.writeRecord(record);
+            record.setRef(newRef.c_str());
+        }
+        PROFILE_CALL(PROFILE_WRITE, outFile.writeRecord(record));
     }
  
     inFile.close();   
     outFile.close();   
-    end = time(NULL);
-    
-    std::cerr << "Took: " << end-start << " to run my verison\n";
     return(0);
 }
 
@@ -0,0 +1,382 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+#include "VcfBatch.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Parameters.h"
+#include "InputFile.h"
+#include "StringArray.h"
+#include "WorkerPool.h"
+#include "VcfToolFactory.h"
+
+void VcfBatch::vcfBatchDescription()
+{
+    std::cerr << " batch - Run a list of vcfUtil jobs on a pool of threads in 1 process" << std::endl;
+}
+
+
+void VcfBatch::description()
+{
+    vcfBatchDescription();
+}
+
+
+void VcfBatch::usage()
+{
+    VcfExecutable::usage();
+    std::cerr << "\t./vcfUtil batch --jobs <job list file> [--threads <n>] [--stopOnError] [--params]"<< std::endl;
+    std::cerr << "\tRequired Parameters:\n"
+              << "\t\t--jobs        : file with 1 job per line: a tool name followed by\n"
+              << "\t\t                its arguments, separated by spaces or tabs (no quoting).\n"
+              << "\t\t                Blank lines and lines starting with '#' are skipped.\n"
+              << "\tOptional Parameters:\n"
+              << "\t\t--threads     : number of jobs to run at a time, defaults to 1\n"
+              << "\t\t--stopOnError : do not start any more jobs once a job fails\n"
+              << "\t\t--params      : print the parameter settings\n"
+              << "\tJobs share what is loaded once per process, such as the references\n"
+              << "\t(with their contig dictionaries) and --filterList region indexes,\n"
+              << "\tso many small jobs only pay the startup cost once.\n"
+              << "\tJobs running at the same time share stderr, so their messages may\n"
+              << "\tbe interleaved; a line reporting each job's status is written as it\n"
+              << "\tfinishes.  Jobs can not write to stdout (\"--out -\"), so mac jobs\n"
+              << "\tmust specify --out or --binOut.  --noeof is not allowed since it\n"
+              << "\twould apply to every job in the process.  batch and bench jobs\n"
+              << "\tare not allowed.\n"
+              << "\tReturns failure if any job fails.\n"
+              << std::endl;
+}
+
+
+// A line of the job list.
+struct BatchJob
+{
+    int lineNum;
+    std::vector<std::string> args;
+    int returnVal;
+    bool ran;
+    double seconds;
+};
+
+
+static uint64_t getNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return(((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec);
+}
+
+
+// Read the jobs, checking each is a tool that can be run in a batch.
+// Returns false if the file could not be read or a job is invalid.
+static bool readJobs(const char* jobFile, std::vector<BatchJob>& jobs)
+{
+    IFILE jobIn = ifopen(jobFile, "r");
+    if(jobIn == NULL)
+    {
+        std::cerr << "Failed to open " << jobFile << "\n";
+        return(false);
+    }
+
+    bool valid = true;
+    String line;
+    StringArray columns;
+    int lineNum = 0;
+    BatchJob job;
+    job.returnVal = 0;
+    job.ran = false;
+    job.seconds = 0;
+    while(!ifeof(jobIn))
+    {
+        line.Clear();
+        if(line.ReadLine(jobIn) < 0)
+        {
+            // Error/end of file, exit loop.
+            break;
+        }
+        ++lineNum;
+        columns.ReplaceTokens(line, " \t\r");
+        if((columns.Length() == 0) || (columns[0][0] == '#'))
+        {
+            continue;
+        }
+
+        if((columns[0].SlowCompare("batch") == 0) ||
+           (columns[0].SlowCompare("bench") == 0))
+        {
+            std::cerr << jobFile << " line " << lineNum << ": "
+                      << columns[0] << " can not be run in a batch\n";
+            valid = false;
+            continue;
+        }
+        VcfExecutable* tool = VcfToolFactory::create(columns[0].c_str());
+        if(tool == NULL)
+        {
+            std::cerr << jobFile << " line " << lineNum << ": "
+                      << columns[0] << " is not a vcfUtil tool\n";
+            valid = false;
+            continue;
+        }
+        delete tool;
+
+        // Check the arguments that can not be used in a batch, allowing
+        // for the abbreviations the parameters accept.
+        bool hasOutput = false;
+        bool hasStdout = false;
+        bool hasNoEof = false;
+        for(int i = 1; i < columns.Length(); i++)
+        {
+            if((columns[i] == "--out") || (columns[i] == "--binOut"))
+            {
+                hasOutput = true;
+                if((i + 1 < columns.Length()) && (columns[i + 1] == "-"))
+                {
+                    hasStdout = true;
+                }
+            }
+            else if((columns[i].Length() >= 5) &&
+                    (strncmp("--noeof", columns[i].c_str(), columns[i].Length()) == 0))
+            {
+                hasNoEof = true;
+            }
+        }
+        if(hasNoEof)
+        {
+            std::cerr << jobFile << " line " << lineNum << ": "
+                      << "--noeof applies to the whole process, so can not be used in a batch\n";
+            valid = false;
+            continue;
+        }
+        if(hasStdout)
+        {
+            std::cerr << jobFile << " line " << lineNum << ": "
+                      << "jobs can not write to stdout\n";
+            valid = false;
+            continue;
+        }
+        if((columns[0].SlowCompare("mac") == 0) && !hasOutput)
+        {
+            std::cerr << jobFile << " line " << lineNum << ": "
+                      << "mac jobs must write to --out or --binOut rather than stdout\n";
+            valid = false;
+            continue;
+        }
+
+        job.lineNum = lineNum;
+        job.args.clear();
+        for(int i = 0; i < columns.Length(); i++)
+        {
+            job.args.push_back(columns[i].c_str());
+        }
+        jobs.push_back(job);
+    }
+    ifclose(jobIn);
+    return(valid);
+}
+
+
+// Runs 1 job per block.
+class BatchTask : public WorkerTask
+{
+public:
+    BatchTask(std::vector<BatchJob>& jobs, bool stopOnError)
+        : myJobs(jobs),
+          myStopOnError(stopOnError),
+          myFailed(false)
+    {
+    }
+
+    void runBlock(int blockIndex, int threadIndex)
+    {
+        BatchJob& job = myJobs[blockIndex];
+        if(myStopOnError && myFailed)
+        {
+            return;
+        }
+
+        // Tools read their parameters starting after the tool name, as
+        // the command line is passed to them by main.  The batch phones
+        // home once, so the jobs do not.
+        std::vector< std::vector<char> > argStrings;
+        argStrings.reserve(job.args.size() + 2);
+        addArg(argStrings, "vcfUtil");
+        for(unsigned int i = 0; i < job.args.size(); i++)
+        {
+            addArg(argStrings, job.args[i]);
+        }
+        addArg(argStrings, "--noPhoneHome");
+        std::vector<char*> argv;
+        for(unsigned int i = 0; i < argStrings.size(); i++)
+        {
+            argv.push_back(&(argStrings[i][0]));
+        }
+        argv.push_back(NULL);
+
+        uint64_t startNs = getNs();
+        VcfExecutable* tool = VcfToolFactory::create(job.args[0].c_str());
+        std::string errorMsg = "";
+        try
+        {
+            job.returnVal = tool->execute(argStrings.size(), &(argv[0]));
+        }
+        catch (const std::exception& e)
+        {
+            errorMsg = e.what();
+            job.returnVal = -1;
+        }
+        catch (...)
+        {
+            errorMsg = "unknown exception";
+            job.returnVal = -1;
+        }
+        delete tool;
+        job.seconds = (getNs() - startNs) / 1e9;
+        job.ran = true;
+        if(job.returnVal != 0)
+        {
+            myFailed = true;
+        }
+
+        // Write the report in 1 call so it is not split up by other jobs.
+        std::ostringstream report;
+        if(!errorMsg.empty())
+        {
+            report << "Job on line " << job.lineNum
+                   << " exiting due to ERROR:\n\t" << errorMsg << "\n";
+        }
+        report << "Job on line " << job.lineNum << " (" << job.args[0]
+               << ") finished with status " << job.returnVal
+               << " in " << job.seconds << " seconds\n";
+        std::cerr << report.str() << std::flush;
+    }
+
+private:
+    static void addArg(std::vector< std::vector<char> >& argStrings,
+                       const std::string& arg)
+    {
+        argStrings.push_back(std::vector<char>(arg.begin(), arg.end()));
+        argStrings.back().push_back('\0');
+    }
+
+    std::vector<BatchJob>& myJobs;
+    bool myStopOnError;
+    volatile bool myFailed;
+};
+
+
+int VcfBatch::execute(int argc, char **argv)
+{
+    String jobFile = "";
+    int numThreads = 1;
+    bool stopOnError = false;
+    bool params = false;
+
+    // Read in the parameters.
+    ParameterList inputParameters;
+    BEGIN_LONG_PARAMETERS(longParameterList)
+        LONG_PARAMETER_GROUP("Required Parameters")
+        LONG_STRINGPARAMETER("jobs", &jobFile)
+        LONG_PARAMETER_GROUP("Optional Parameters")
+        LONG_INTPARAMETER("threads", &numThreads)
+        LONG_PARAMETER("stopOnError", &stopOnError)
+        LONG_PARAMETER("params", &params)
+        LONG_PHONEHOME(VERSION)
+        END_LONG_PARAMETERS();
+
+    inputParameters.Add(new LongParameters ("Input Parameters",
+                                            longParameterList));
+
+    inputParameters.Read(argc-1, &(argv[1]));
+
+    // Check that all files were specified.
+    if(jobFile == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--jobs\", a required parameter.\n\n";
+        return(-1);
+    }
+    if(numThreads < 1)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--threads must be at least 1.\n\n";
+        return(-1);
+    }
+
+    if(params)
+    {
+        inputParameters.Status();
+    }
+
+    // Check every job before running any of them.
+    std::vector<BatchJob> jobs;
+    if(!readJobs(jobFile, jobs))
+    {
+        std::cerr << "No jobs were run.\n";
+        return(-1);
+    }
+
+    uint64_t startNs = getNs();
+    if(!jobs.empty())
+    {
+        WorkerPool workers(numThreads);
+        BatchTask task(jobs, stopOnError);
+        workers.run(task, jobs.size());
+    }
+
+    int numFailed = 0;
+    int numNotRun = 0;
+    for(unsigned int i = 0; i < jobs.size(); i++)
+    {
+        if(!jobs[i].ran)
+        {
+            ++numNotRun;
+        }
+        else if(jobs[i].returnVal != 0)
+        {
+            if(numFailed == 0)
+            {
+                std::cerr << "Failed jobs on lines:";
+            }
+            std::cerr << " " << jobs[i].lineNum;
+            ++numFailed;
+        }
+    }
+    if(numFailed != 0)
+    {
+        std::cerr << "\n";
+    }
+
+    std::cerr << "Jobs: " << jobs.size()
+              << ", failed: " << numFailed
+              << ", not run: " << numNotRun
+              << ", seconds: " << (getNs() - startNs) / 1e9 << "\n";
+    if((numFailed != 0) || (numNotRun != 0))
+    {
+        return(-1);
+    }
+    return(0);
+}
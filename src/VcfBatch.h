@@ -0,0 +1,33 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+#ifndef __VCF_BATCH_H__
+#define __VCF_BATCH_H__
+
+#include "VcfExecutable.h"
+
+class VcfBatch : public VcfExecutable
+{
+public:
+    static void vcfBatchDescription();
+    virtual void description();
+    void usage();
+    int execute(int argc, char **argv);
+};
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+
+#include "VcfBatchReader.h"
+#include "ProgressReporter.h"
+#include "Profiler.h"
+
+VcfBatchReader::VcfBatchReader(VcfFileReader& inFile, int batchSize,
+                               int numBatches)
+    : myInFile(inFile),
+      myRegions(NULL),
+      mySections(NULL),
+      myNextSection(0),
+      myProgress(NULL),
+      myProgressInput(NULL),
+      myBatches(numBatches),
+      myFreeBatches(numBatches),
+      myReadBatches(numBatches),
+      myThreadStarted(false),
+      myError()
+{
+    for(int b = 0; b < numBatches; b++)
+    {
+        myBatches[b] = new VcfRecordBatch();
+        myBatches[b]->numRecords = 0;
+        for(int r = 0; r < batchSize; r++)
+        {
+            myBatches[b]->records.push_back(new VcfRecord());
+        }
+        myFreeBatches.push(myBatches[b]);
+    }
+}
+
+
+VcfBatchReader::~VcfBatchReader()
+{
+    // Stop the reader thread if the batches were not all read.
+    myFreeBatches.close();
+    myReadBatches.close();
+    if(myThreadStarted)
+    {
+        pthread_join(myThread, NULL);
+    }
+    for(unsigned int b = 0; b < myBatches.size(); b++)
+    {
+        for(unsigned int r = 0; r < myBatches[b]->records.size(); r++)
+        {
+            delete myBatches[b]->records[r];
+        }
+        delete myBatches[b];
+    }
+}
+
+
+void VcfBatchReader::setRegions(RegionFilter* regions,
+                                const std::vector<RegionFilter::Section>* sections)
+{
+    myRegions = regions;
+    mySections = sections;
+    myNextSection = 0;
+}
+
+
+void VcfBatchReader::setProgress(ProgressReporter* progress, IFILE input)
+{
+    myProgress = progress;
+    myProgressInput = input;
+}
+
+
+bool VcfBatchReader::readRecord(VcfRecord& record)
+{
+    while(true)
+    {
+        if(myProgress != NULL)
+        {
+            myProgress->updateOffset(myProgressInput);
+        }
+        if(mySections == NULL)
+        {
+            if(!PROFILE_CALL(PROFILE_READ, myInFile.readRecord(record)))
+            {
+                return(false);
+            }
+        }
+        else if((myNextSection == 0) ||
+                !PROFILE_CALL(PROFILE_READ, myInFile.readRecord(record)))
+        {
+            if(myNextSection >= mySections->size())
+            {
+                // No more sections.
+                return(false);
+            }
+            // Read the next section.
+            const RegionFilter::Section& section = (*mySections)[myNextSection++];
+            if(!myInFile.set1BasedReadSection(section.chrom.c_str(), section.start,
+                                              section.end + 1))
+            {
+                std::cerr << "Failed to read " << section.chrom << ":"
+                          << section.start << "-" << section.end
+                          << ", so skipping it\n";
+            }
+            continue;
+        }
+
+        PROFILE_SCOPE(PROFILE_FILTER);
+        if((myRegions == NULL) ||
+           myRegions->contains(record.getChromStr(), record.get1BasedPosition()))
+        {
+            return(true);
+        }
+        // not in the interval, so continue to the next record.
+    }
+}
+
+
+bool VcfBatchReader::start()
+{
+    if(pthread_create(&myThread, NULL, run, this) != 0)
+    {
+        return(false);
+    }
+    myThreadStarted = true;
+    return(true);
+}
+
+
+VcfRecordBatch* VcfBatchReader::next()
+{
+    if(!myThreadStarted)
+    {
+        // Read on this thread, reusing the first batch.
+        if(!fillBatch(*(myBatches[0])))
+        {
+            return(NULL);
+        }
+        return(myBatches[0]);
+    }
+
+    VcfRecordBatch* batch = NULL;
+    if(myReadBatches.pop(batch))
+    {
+        return(batch);
+    }
+    // All batches were read.
+    if(!myError.empty())
+    {
+        throw(std::runtime_error(myError));
+    }
+    return(NULL);
+}
+
+
+void VcfBatchReader::release(VcfRecordBatch* batch)
+{
+    if(myThreadStarted)
+    {
+        myFreeBatches.push(batch);
+    }
+}
+
+
+bool VcfBatchReader::fillBatch(VcfRecordBatch& batch)
+{
+    batch.numRecords = 0;
+    while((batch.numRecords < (int)batch.records.size()) &&
+          readRecord(*(batch.records[batch.numRecords])))
+    {
+        ++batch.numRecords;
+    }
+    return(batch.numRecords != 0);
+}
+
+
+void* VcfBatchReader::run(void* arg)
+{
+    VcfBatchReader* reader = (VcfBatchReader*)arg;
+    VcfRecordBatch* batch = NULL;
+    try
+    {
+        while(reader->myFreeBatches.pop(batch))
+        {
+            if(!reader->fillBatch(*batch) ||
+               !reader->myReadBatches.push(batch))
+            {
+                break;
+            }
+        }
+    }
+    catch(std::exception& e)
+    {
+        // Pass the failure to the processing thread.
+        reader->myError = e.what();
+    }
+    reader->myReadBatches.close();
+    return(NULL);
+}
@@ -0,0 +1,104 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __VCF_BATCH_READER_H__
+#define __VCF_BATCH_READER_H__
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include "VcfFileReader.h"
+#include "RegionFilter.h"
+#include "BoundedQueue.h"
+
+class ProgressReporter;
+
+/// Records read together by a VcfBatchReader.
+struct VcfRecordBatch
+{
+    std::vector<VcfRecord*> records;
+    int numRecords;
+};
+
+
+/// Reads the records of an open VcfFileReader, optionally only those in
+/// the regions of a RegionFilter, either 1 at a time or in batches that
+/// are read ahead on a separate thread while the previous batches are
+/// processed.  Batches are returned in file order.
+class VcfBatchReader
+{
+public:
+    /// Read inFile in batches of batchSize records, with at most
+    /// numBatches batches being read or processed at once.
+    VcfBatchReader(VcfFileReader& inFile, int batchSize, int numBatches);
+    ~VcfBatchReader();
+
+    /// Only return the records in the regions (NULL for all records).
+    /// If sections is not NULL, only those sections of the file are
+    /// read (the file's index must already be read).
+    void setRegions(RegionFilter* regions,
+                    const std::vector<RegionFilter::Section>* sections);
+
+    /// Tell progress how far inFile, whose file is input, has been read
+    /// as records are read (NULL to not).
+    void setProgress(ProgressReporter* progress, IFILE input);
+
+    /// Read the next record on the calling thread.
+    /// Do not mix with start().
+    bool readRecord(VcfRecord& record);
+
+    /// Start reading batches on a separate thread.  Returns false if
+    /// the thread could not be started, in which case next() reads
+    /// each batch on the calling thread.
+    bool start();
+
+    /// Get the next batch of records, NULL once all records were read.
+    /// Throws std::runtime_error if reading failed.
+    VcfRecordBatch* next();
+
+    /// Return a batch from next() once done with its records.
+    void release(VcfRecordBatch* batch);
+
+private:
+    VcfBatchReader();
+    VcfBatchReader(const VcfBatchReader&);
+    VcfBatchReader& operator=(const VcfBatchReader&);
+
+    bool fillBatch(VcfRecordBatch& batch);
+    static void* run(void* arg);
+
+    VcfFileReader& myInFile;
+    RegionFilter* myRegions;
+    const std::vector<RegionFilter::Section>* mySections;
+    unsigned int myNextSection;
+    ProgressReporter* myProgress;
+    IFILE myProgressInput;
+
+    std::vector<VcfRecordBatch*> myBatches;
+    // Batches are taken from myFreeBatches, filled, and added to myReadBatches.
+    BoundedQueue<VcfRecordBatch*> myFreeBatches;
+    BoundedQueue<VcfRecordBatch*> myReadBatches;
+    pthread_t myThread;
+    bool myThreadStarted;
+    // Set if reading failed on the reader thread.
+    std::string myError;
+};
+
+#endif
@@ -0,0 +1,552 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+#include "VcfBench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Parameters.h"
+#include "BgzfFileType.h"
+#include "StringArray.h"
+#include "HyunVcfFile.h"
+#include "VcfFileReader.h"
+#include "VcfFileWriter.h"
+
+// Reader/writer implementations that can be benchmarked.
+enum BenchBackend {BACKEND_IFILE = 0, BACKEND_HYUN, BACKEND_LIB, NUM_BACKENDS};
+static const char* BACKEND_NAMES[NUM_BACKENDS] = {"ifile", "hyun", "lib"};
+
+// Result of 1 trial, passed from the trial's process.
+struct TrialResult
+{
+    uint64_t numRecords;
+    uint64_t elapsedNs;
+    // Peak resident set size of the trial's process.
+    long peakRssKB;
+    bool succeeded;
+};
+
+
+static uint64_t getNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return(((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec);
+}
+
+
+// Copy the VCF line by line with IFILE.  Returns the number of records.
+static uint64_t runIfile(const char* inName, const char* outName)
+{
+    IFILE vcfIn = ifopen(inName, "r");
+    if(vcfIn == NULL)
+    {
+        throw(std::runtime_error(std::string("Failed to open ") + inName));
+    }
+    IFILE vcfOut = NULL;
+    if(outName != NULL)
+    {
+        vcfOut = ifopen(outName, "w");
+        if(vcfOut == NULL)
+        {
+            throw(std::runtime_error(std::string("Failed to open ") + outName));
+        }
+    }
+
+    uint64_t numRecords = 0;
+    String line = "";
+    while(!ifeof(vcfIn))
+    {
+        line.Clear();
+        if(line.ReadLine(vcfIn) < 0)
+        {
+            // Error/end of file, exit loop.
+            break;
+        }
+        if(line.IsEmpty())
+        {
+            continue;
+        }
+        if(line[0] != '#')
+        {
+            ++numRecords;
+        }
+        if(vcfOut != NULL)
+        {
+            line += '\n';
+            ifwrite(vcfOut, line.c_str(), line.Length());
+        }
+    }
+    if(vcfOut != NULL)
+    {
+        ifclose(vcfOut);
+    }
+    ifclose(vcfIn);
+    return(numRecords);
+}
+
+
+// Parse & rewrite the records with HyunVcfFile.
+static uint64_t runHyun(const char* inName, const char* outName)
+{
+    HyunVcfFile inFile;
+    inFile.openForRead(inName);
+    IFILE outFile = NULL;
+    if(outName != NULL)
+    {
+        outFile = ifopen(outName, "wb");
+        if(outFile == NULL)
+        {
+            throw(std::runtime_error(std::string("Failed to open ") + outName));
+        }
+        inFile.printVCFHeader(outFile);
+    }
+
+    uint64_t numRecords = 0;
+    while(inFile.iterateMarker())
+    {
+        ++numRecords;
+        if(outFile != NULL)
+        {
+            inFile.getLastMarker()->printVCFMarker(outFile, false);
+        }
+    }
+    if(outFile != NULL)
+    {
+        ifclose(outFile);
+    }
+    return(numRecords);
+}
+
+
+// Parse & rewrite the records with VcfFileReader/VcfFileWriter.
+static uint64_t runLib(const char* inName, const char* outName)
+{
+    VcfFileReader inFile;
+    VcfHeader header;
+    VcfFileWriter outFile;
+    VcfRecord record;
+
+    inFile.open(inName, header);
+    if(outName != NULL)
+    {
+        outFile.open(outName, header, InputFile::DEFAULT);
+    }
+
+    uint64_t numRecords = 0;
+    while(inFile.readRecord(record))
+    {
+        ++numRecords;
+        if(outName != NULL)
+        {
+            outFile.writeRecord(record);
+        }
+    }
+    inFile.close();
+    if(outName != NULL)
+    {
+        outFile.close();
+    }
+    return(numRecords);
+}
+
+
+// Run 1 trial of the backend in a child process, so its peak memory is
+// its own and nothing is cached in this process between trials.
+static TrialResult runTrial(BenchBackend backend, const char* inName,
+                            const char* outName)
+{
+    TrialResult result;
+    memset(&result, 0, sizeof(result));
+
+    int resultPipe[2];
+    if(pipe(resultPipe) != 0)
+    {
+        std::cerr << "Failed to create a pipe for the trial\n";
+        return(result);
+    }
+    // Flush so buffered output is not also written by the trial process.
+    fflush(NULL);
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        std::cerr << "Failed to start the trial process\n";
+        close(resultPipe[0]);
+        close(resultPipe[1]);
+        return(result);
+    }
+    if(pid == 0)
+    {
+        // Trial process: run the backend & send back its counts.
+        close(resultPipe[0]);
+        try
+        {
+            uint64_t start = getNs();
+            if(backend == BACKEND_IFILE)
+            {
+                result.numRecords = runIfile(inName, outName);
+            }
+            else if(backend == BACKEND_HYUN)
+            {
+                result.numRecords = runHyun(inName, outName);
+            }
+            else
+            {
+                result.numRecords = runLib(inName, outName);
+            }
+            result.elapsedNs = getNs() - start;
+            result.succeeded = true;
+        }
+        catch(std::exception& e)
+        {
+            std::cerr << BACKEND_NAMES[backend] << " failed: " << e.what() << "\n";
+        }
+        if(write(resultPipe[1], &result, sizeof(result)) != sizeof(result))
+        {
+            _exit(1);
+        }
+        _exit(0);
+    }
+
+    close(resultPipe[1]);
+    if(read(resultPipe[0], &result, sizeof(result)) != sizeof(result))
+    {
+        result.succeeded = false;
+    }
+    close(resultPipe[0]);
+
+    int status = 0;
+    struct rusage usage;
+    if(wait4(pid, &status, 0, &usage) == pid)
+    {
+        // ru_maxrss is in KB on Linux.
+        result.peakRssKB = usage.ru_maxrss;
+    }
+    if(!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+    {
+        result.succeeded = false;
+    }
+    return(result);
+}
+
+
+// Write a synthetic VCF of random diploid GTs.
+static bool writeSynthetic(const char* fileName, int numRecords, int numSamples)
+{
+    static const char* BASES = "ACGT";
+
+    IFILE outFile = ifopen(fileName, "w");
+    if(outFile == NULL)
+    {
+        return(false);
+    }
+    ifprintf(outFile, "##fileformat=VCFv4.1\n");
+    ifprintf(outFile, "##contig=<ID=1>\n");
+    ifprintf(outFile, "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n");
+    ifprintf(outFile, "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT");
+    for(int i = 0; i < numSamples; i++)
+    {
+        ifprintf(outFile, "\tS%d", i + 1);
+    }
+    ifprintf(outFile, "\n");
+
+    // Fixed seed so every run benchmarks the same file.
+    uint32_t random = 12345;
+    String line;
+    for(int r = 0; r < numRecords; r++)
+    {
+        random = (random * 1103515245) + 12345;
+        int ref = (random >> 16) & 3;
+        int alt = (ref + 1 + ((random >> 18) % 3)) & 3;
+        line.printf("1\t%d\t.\t%c\t%c\t.\tPASS\t.\tGT", (r * 10) + 1,
+                    BASES[ref], BASES[alt]);
+        for(int i = 0; i < numSamples; i++)
+        {
+            random = (random * 1103515245) + 12345;
+            int bits = (random >> 16) & 0xF;
+            // Mostly 0/0, some 0/1, few 1/1 & missing.
+            const char* gt = (bits < 10) ? "\t0/0" : ((bits < 14) ? "\t0/1" :
+                                                      ((bits < 15) ? "\t1/1" : "\t./."));
+            line += gt;
+        }
+        line += '\n';
+        ifwrite(outFile, line.c_str(), line.Length());
+    }
+    ifclose(outFile);
+    return(true);
+}
+
+
+// Write the string as a JSON string.
+static void printJsonString(FILE* out, const char* str)
+{
+    fputc('"', out);
+    for(; *str != '\0'; str++)
+    {
+        if((*str == '"') || (*str == '\\'))
+        {
+            fputc('\\', out);
+            fputc(*str, out);
+        }
+        else if((unsigned char)*str < 0x20)
+        {
+            fprintf(out, "\\u%04x", (unsigned char)*str);
+        }
+        else
+        {
+            fputc(*str, out);
+        }
+    }
+    fputc('"', out);
+}
+
+
+void VcfBench::vcfBenchDescription()
+{
+    std::cerr << " bench - Benchmark the VCF reader/writer implementations" << std::endl;
+}
+
+
+void VcfBench::description()
+{
+    vcfBenchDescription();
+}
+
+
+void VcfBench::usage()
+{
+    VcfExecutable::usage();
+    std::cerr << "\t./vcfUtil bench (--in <input VCF File>|--synthetic) --out <output prefix> [--backends <list>] [--trials <num>] [--readOnly] [--json <file>] [--params]"<< std::endl;
+    std::cerr << "\tRequired Parameters:\n"
+              << "\t\t--in         : VCF file to benchmark with, or\n"
+              << "\t\t--synthetic  : benchmark with a generated VCF, <out>.synthetic.vcf\n"
+              << "\t\t--out        : prefix of the files written by each backend,\n"
+              << "\t\t               <out>.<backend>.vcf (not required with --readOnly\n"
+              << "\t\t               unless --synthetic)\n"
+              << "\tOptional Parameters:\n"
+              << "\t\t--numRecords : records in the --synthetic VCF (default 10000)\n"
+              << "\t\t--numSamples : samples in the --synthetic VCF (default 100)\n"
+              << "\t\t--backends   : comma separated backends to run (default ifile,hyun,lib)\n"
+              << "\t\t                 ifile: copy the lines with IFILE\n"
+              << "\t\t                 hyun : parse & write with HyunVcfFile\n"
+              << "\t\t                 lib  : parse & write with VcfFileReader/VcfFileWriter\n"
+              << "\t\t--trials     : number of times to run each backend (default 3)\n"
+              << "\t\t--readOnly   : only read the records, without writing them\n"
+              << "\t\t--json       : write the JSON results to this file rather than stdout\n"
+              << "\t\t--params     : print the parameter settings\n"
+              << "\tEach trial runs in its own process; the peak RSS is the largest of\n"
+              << "\tany trial of the backend.\n"
+              << std::endl;
+}
+
+
+int VcfBench::execute(int argc, char **argv)
+{
+    String inputVcf = "";
+    String outPrefix = "";
+    bool synthetic = false;
+    int numRecords = 10000;
+    int numSamples = 100;
+    String backendList = "ifile,hyun,lib";
+    int numTrials = 3;
+    bool readOnly = false;
+    String jsonFile = "";
+    bool params = false;
+
+    // Read in the parameters.
+    ParameterList inputParameters;
+    BEGIN_LONG_PARAMETERS(longParameterList)
+        LONG_PARAMETER_GROUP("Required Parameters")
+        LONG_STRINGPARAMETER("in", &inputVcf)
+        LONG_PARAMETER("synthetic", &synthetic)
+        LONG_STRINGPARAMETER("out", &outPrefix)
+        LONG_PARAMETER_GROUP("Optional Parameters")
+        LONG_INTPARAMETER("numRecords", &numRecords)
+        LONG_INTPARAMETER("numSamples", &numSamples)
+        LONG_STRINGPARAMETER("backends", &backendList)
+        LONG_INTPARAMETER("trials", &numTrials)
+        LONG_PARAMETER("readOnly", &readOnly)
+        LONG_STRINGPARAMETER("json", &jsonFile)
+        LONG_PARAMETER("params", &params)
+        LONG_PHONEHOME(VERSION)
+        END_LONG_PARAMETERS();
+
+    inputParameters.Add(new LongParameters ("Input Parameters",
+                                            longParameterList));
+
+    inputParameters.Read(argc-1, &(argv[1]));
+
+    // Check that all files were specified.
+    if((inputVcf == "") == !synthetic)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Exactly 1 of \"--in\" or \"--synthetic\" is required.\n\n";
+        return(-1);
+    }
+    if((outPrefix == "") && (synthetic || !readOnly))
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--out\", a required parameter.\n\n";
+        return(-1);
+    }
+    if((numTrials < 1) || (numRecords < 0) || (numSamples < 0))
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--trials must be at least 1, and --numRecords & --numSamples at least 0.\n\n";
+        return(-1);
+    }
+
+    // Find the backends to run.
+    std::vector<BenchBackend> backends;
+    StringArray backendNames;
+    backendNames.ReplaceTokens(backendList, ",");
+    for(int i = 0; i < backendNames.Length(); i++)
+    {
+        int b = 0;
+        while((b < NUM_BACKENDS) && (backendNames[i] != BACKEND_NAMES[b]))
+        {
+            ++b;
+        }
+        if(b == NUM_BACKENDS)
+        {
+            usage();
+            inputParameters.Status();
+            std::cerr << "Unknown backend in \"--backends\": " << backendNames[i] << "\n\n";
+            return(-1);
+        }
+        backends.push_back((BenchBackend)b);
+    }
+
+    if(params)
+    {
+        inputParameters.Status();
+    }
+
+    if(synthetic)
+    {
+        inputVcf = outPrefix + ".synthetic.vcf";
+        if(!writeSynthetic(inputVcf, numRecords, numSamples))
+        {
+            std::cerr << "Failed to write " << inputVcf << "\n";
+            return(-1);
+        }
+    }
+
+    struct stat inStat;
+    if(stat(inputVcf.c_str(), &inStat) != 0)
+    {
+        std::cerr << "Failed to open " << inputVcf << "\n";
+        return(-1);
+    }
+    uint64_t fileBytes = inStat.st_size;
+
+    FILE* jsonOut = stdout;
+    if(!jsonFile.IsEmpty())
+    {
+        jsonOut = fopen(jsonFile.c_str(), "w");
+        if(jsonOut == NULL)
+        {
+            std::cerr << "Failed to open " << jsonFile << "\n";
+            return(-1);
+        }
+    }
+
+    fprintf(jsonOut, "{\n  \"version\": ");
+    printJsonString(jsonOut, VERSION);
+    fprintf(jsonOut, ",\n  \"input\": ");
+    printJsonString(jsonOut, inputVcf.c_str());
+    fprintf(jsonOut, ",\n  \"inputBytes\": %llu,\n  \"mode\": \"%s\",\n  \"trials\": %d,\n  \"results\": [",
+            (unsigned long long)fileBytes, readOnly ? "read" : "readWrite", numTrials);
+
+    int status = 0;
+    for(unsigned int b = 0; b < backends.size(); b++)
+    {
+        const char* name = BACKEND_NAMES[backends[b]];
+        String outFileName = outPrefix + "." + name + ".vcf";
+
+        std::vector<uint64_t> trialNs;
+        uint64_t backendRecords = 0;
+        long peakRssKB = 0;
+        bool succeeded = true;
+        for(int t = 0; t < numTrials; t++)
+        {
+            TrialResult result = runTrial(backends[b], inputVcf.c_str(),
+                                          readOnly ? NULL : outFileName.c_str());
+            if(!result.succeeded)
+            {
+                succeeded = false;
+                break;
+            }
+            trialNs.push_back(result.elapsedNs);
+            backendRecords = result.numRecords;
+            peakRssKB = std::max(peakRssKB, result.peakRssKB);
+        }
+
+        fprintf(jsonOut, "%s\n    {\"backend\": \"%s\", ", (b == 0) ? "" : ",", name);
+        if(!succeeded)
+        {
+            std::cerr << name << ": failed\n";
+            fprintf(jsonOut, "\"failed\": true}");
+            status = -1;
+            continue;
+        }
+
+        // Rates are from the median trial.
+        std::sort(trialNs.begin(), trialNs.end());
+        uint64_t medianNs = trialNs[trialNs.size() / 2];
+        double medianSec = medianNs / 1e9;
+        double recordsPerSec = (medianNs == 0) ? 0 : (backendRecords / medianSec);
+        double mbPerSec = (medianNs == 0) ? 0 : ((fileBytes / 1e6) / medianSec);
+        double nsPerRecord = (backendRecords == 0) ? 0 : ((double)medianNs / backendRecords);
+
+        fprintf(jsonOut, "\"records\": %llu, \"trialSeconds\": [",
+                (unsigned long long)backendRecords);
+        for(unsigned int t = 0; t < trialNs.size(); t++)
+        {
+            fprintf(jsonOut, "%s%.6f", (t == 0) ? "" : ", ", trialNs[t] / 1e9);
+        }
+        fprintf(jsonOut, "], \"bestSeconds\": %.6f, \"medianSeconds\": %.6f, "
+                "\"recordsPerSec\": %.1f, \"mbPerSec\": %.3f, \"nsPerRecord\": %.1f, "
+                "\"peakRssKB\": %ld}",
+                trialNs[0] / 1e9, medianSec, recordsPerSec, mbPerSec,
+                nsPerRecord, peakRssKB);
+
+        std::cerr << name << ": " << backendRecords << " records, median "
+                  << medianSec << "s (best " << trialNs[0] / 1e9 << "s), "
+                  << recordsPerSec << " records/s, " << mbPerSec << " MB/s, "
+                  << nsPerRecord << " ns/record, peak RSS " << peakRssKB << " KB\n";
+    }
+    fprintf(jsonOut, "\n  ]\n}\n");
+    if(jsonOut != stdout)
+    {
+        fclose(jsonOut);
+    }
+    return(status);
+}
@@ -18,10 +18,230 @@
 //////////////////////////////////////////////////////////////////////////
 #include "VcfCleaner.h"
 
+#include <string.h>
+#include <string>
+#include <vector>
+
 #include "Parameters.h"
 #include "BgzfFileType.h"
-#include "VcfFileReader.h"
-#include "VcfFileWriter.h"
+#include "WorkerPool.h"
+#include "Profiler.h"
+
+// Number of columns from CHROM through FILTER.
+static const int NUM_SITE_COLUMNS = 7;
+
+// Records are cleaned in blocks of this many lines, with this many
+// blocks per thread read at a time.
+static const int LINES_PER_BLOCK = 64;
+static const int BLOCKS_PER_THREAD = 4;
+
+
+// Find the end of the column that starts at col: the next tab or lineEnd.
+static inline const char* columnEnd(const char* col, const char* lineEnd)
+{
+    const char* end = (const char*)memchr(col, '\t', lineEnd - col);
+    return((end == NULL) ? lineEnd : end);
+}
+
+
+// Check a GT as allPhased() & hasAllGenotypeAlleles() would: only allele
+// numbers, each separated by '|'.  '.' (missing), '/' (unphased), or
+// anything else fails it, as do empty & haploid GTs, which are not phased.
+static inline bool isPhasedGT(const char* gt, const char* gtEnd)
+{
+    bool phased = false;
+    for(; gt != gtEnd; ++gt)
+    {
+        if(*gt == '|')
+        {
+            phased = true;
+        }
+        else if((*gt < '0') || (*gt > '9'))
+        {
+            return(false);
+        }
+    }
+    return(phased);
+}
+
+
+// Scan the GT subfield of each sample in place, without parsing the rest
+// of the record line (without the '\n').  If every sample has a complete
+// phased GT, sets cleaned to the record with the INFO cleared & only the
+// GTs, CHROM..FILTER copied as read, and returns true.  Returns false,
+// stopping at the first failing sample, if any GT is missing or unphased.
+static bool cleanRecord(const std::string& record, std::string& cleaned)
+{
+    const char* line = record.c_str();
+    const char* lineEnd = line + record.size();
+
+    // Split out the site columns & find the GT subfield.
+    const char* siteEnd = line - 1;
+    const char* formatStart = NULL;
+    const char* formatEnd = NULL;
+    int gtIndex = 0;
+    {
+        PROFILE_SCOPE(PROFILE_TOKENIZE);
+        // Find the end of FILTER.
+        for(int c = 0; c < NUM_SITE_COLUMNS; c++)
+        {
+            siteEnd = (const char*)memchr(siteEnd + 1, '\t', lineEnd - siteEnd - 1);
+            if(siteEnd == NULL)
+            {
+                // Too few columns.
+                return(false);
+            }
+        }
+        cleaned.assign(line, siteEnd - line);
+
+        // Skip INFO to find the FORMAT column.
+        formatStart = columnEnd(siteEnd + 1, lineEnd);
+        if(formatStart == lineEnd)
+        {
+            // No samples.
+            cleaned += "\t.\n";
+            return(true);
+        }
+        ++formatStart;
+        formatEnd = columnEnd(formatStart, lineEnd);
+
+        // Find which subfield is GT.
+        const char* key = formatStart;
+        while(true)
+        {
+            const char* keyEnd = (const char*)memchr(key, ':', formatEnd - key);
+            if(keyEnd == NULL)
+            {
+                keyEnd = formatEnd;
+            }
+            if((keyEnd - key == 2) && (key[0] == 'G') && (key[1] == 'T'))
+            {
+                break;
+            }
+            if(keyEnd == formatEnd)
+            {
+                // No GT, so the GTs are missing if there are any samples.
+                if(formatEnd != lineEnd)
+                {
+                    return(false);
+                }
+                break;
+            }
+            key = keyEnd + 1;
+            ++gtIndex;
+        }
+    }
+
+    PROFILE_SCOPE(PROFILE_PARSE_SAMPLES);
+    cleaned += "\t.\tGT";
+
+    if((gtIndex == 0) && (formatEnd - formatStart == 2))
+    {
+        // Only GTs follow, so reject on the first missing or unphased
+        // allele with a vectorized scan before checking each sample.
+        // The record's string is terminated, so strcspn stops at lineEnd.
+        if(formatEnd + strcspn(formatEnd, "/.") != lineEnd)
+        {
+            return(false);
+        }
+        for(const char* sampleTab = formatEnd; sampleTab != lineEnd; )
+        {
+            const char* gtEnd = columnEnd(sampleTab + 1, lineEnd);
+            if(!isPhasedGT(sampleTab + 1, gtEnd))
+            {
+                return(false);
+            }
+            sampleTab = gtEnd;
+        }
+        cleaned.append(formatEnd, lineEnd - formatEnd);
+        cleaned += '\n';
+        return(true);
+    }
+
+    // Each sample starts after the tab at sampleTab.
+    const char* sampleTab = formatEnd;
+    while(sampleTab != lineEnd)
+    {
+        const char* gt = sampleTab + 1;
+        for(int i = 0; i < gtIndex; i++)
+        {
+            while((gt != lineEnd) && (*gt != ':') && (*gt != '\t'))
+            {
+                ++gt;
+            }
+            if((gt == lineEnd) || (*gt != ':'))
+            {
+                // GT is missing from this sample.
+                return(false);
+            }
+            ++gt;
+        }
+
+        const char* gtEnd = gt;
+        while((gtEnd != lineEnd) && (*gtEnd != ':') && (*gtEnd != '\t'))
+        {
+            ++gtEnd;
+        }
+        if(!isPhasedGT(gt, gtEnd))
+        {
+            return(false);
+        }
+        cleaned += '\t';
+        cleaned.append(gt, gtEnd - gt);
+        sampleTab = columnEnd(gtEnd, lineEnd);
+    }
+    cleaned += '\n';
+    return(true);
+}
+
+// Cleans a chunk of record lines, LINES_PER_BLOCK per block.  Each kept
+// line is replaced by its cleaned record.
+class CleanTask : public WorkerTask
+{
+public:
+    CleanTask(int numThreads)
+        : keep(), myCleaned(numThreads), myLines(NULL), myNumLines(0)
+    {
+    }
+
+    void setChunk(std::vector<std::string>& lines, int numLines)
+    {
+        myLines = &lines;
+        myNumLines = numLines;
+        keep.resize(lines.size());
+    }
+
+    virtual void runBlock(int blockIndex, int threadIndex)
+    {
+        int end = (blockIndex + 1) * LINES_PER_BLOCK;
+        if(end > myNumLines)
+        {
+            end = myNumLines;
+        }
+        PROFILE_ITEMS(PROFILE_TOKENIZE, end - blockIndex * LINES_PER_BLOCK);
+        PROFILE_ITEMS(PROFILE_PARSE_SAMPLES, end - blockIndex * LINES_PER_BLOCK);
+        std::string& cleaned = myCleaned[threadIndex];
+        for(int r = blockIndex * LINES_PER_BLOCK; r < end; r++)
+        {
+            keep[r] = cleanRecord((*myLines)[r], cleaned);
+            if(keep[r])
+            {
+                (*myLines)[r].swap(cleaned);
+            }
+        }
+    }
+
+    // Whether each line of the chunk is kept (not vector<bool>, since
+    // threads set neighboring entries).
+    std::vector<char> keep;
+
+private:
+    // Per thread cleaned record space.
+    std::vector<std::string> myCleaned;
+    std::vector<std::string>* myLines;
+    int myNumLines;
+};
+
 
 void VcfCleaner::vcfCleanerDescription()
 {
@@ -38,11 +258,12 @@ void VcfCleaner::description()
 void VcfCleaner::usage()
 {
     VcfExecutable::usage();
-    std::cerr << "\t./vcfUtil cleaner --in <input VCF File> --out <output VCF File> [--params]"<< std::endl;
+    std::cerr << "\t./vcfUtil cleaner --in <input VCF File> --out <output VCF File> [--threads <num>] [--params]"<< std::endl;
     std::cerr << "\tRequired Parameters:\n"
               << "\t\t--in      : VCF file to read\n"
               << "\t\t--out     : VCF file to write\n"
               << "\tOptional Parameters:\n"
+              << "\t\t--threads    : number of threads for cleaning (default 1)\n"
               << "\t\t--uncompress : write an uncompressed VCF output file\n"
               << "\t\t--params     : print the parameter settings\n"
               << std::endl;
@@ -55,6 +276,7 @@ int VcfCleaner::execute(int argc, char **argv)
     String refFile = "";
     String inputVcf = "";
     String outputVcf = "";
+    int numThreads = 1;
     bool uncompress = false;
     bool params = false;
     
@@ -65,6 +287,7 @@ int VcfCleaner::execute(int argc, char **argv)
         LONG_STRINGPARAMETER("in", &inputVcf)
         LONG_STRINGPARAMETER("out", &outputVcf)
         LONG_PARAMETER_GROUP("Optional Parameters")
+        LONG_INTPARAMETER("threads", &numThreads)
         LONG_PARAMETER("uncompress", &uncompress)
         LONG_PARAMETER("params", &params)
         LONG_PHONEHOME(VERSION)
@@ -90,58 +313,112 @@ int VcfCleaner::execute(int argc, char **argv)
         std::cerr << "Missing \"--out\", a required parameter.\n\n";
         return(-1);
     }
+    if(numThreads < 1)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--threads must be at least 1.\n\n";
+        return(-1);
+    }
 
     if(params)
     {
         inputParameters.Status();
     }
 
-    VcfFileReader inFile;
-    VcfFileWriter outFile;
-    VcfHeader header;
-    VcfRecord record;
-
-    // Open the file.
-    inFile.open(inputVcf, header);
+    IFILE inFile = ifopen(inputVcf, "r");
+    if(inFile == NULL)
+    {
+        std::cerr << "Failed to open " << inputVcf << "\n";
+        return(-1);
+    }
+    IFILE outFile = NULL;
     if(uncompress)
     {
-        outFile.open(outputVcf, header, InputFile::DEFAULT);
+        outFile = ifopen(outputVcf, "w", InputFile::DEFAULT);
     }
     else
     {
-        outFile.open(outputVcf, header);
+        outFile = ifopen(outputVcf, "w", InputFile::BGZF);
+    }
+    if(outFile == NULL)
+    {
+        std::cerr << "Failed to open " << outputVcf << "\n";
+        ifclose(inFile);
+        return(-1);
     }
 
     int numReadRecords = 0;
     int numWrittenRecords = 0;
     int returnVal = 0;
 
-    // Set to only store/write the GT field.
-    VcfRecordGenotype::addStoreField("GT");
-    while(inFile.readRecord(record))
+    // Chunks of lines are read on this thread and cleaned straight from
+    // the line text by the workers, only keeping the GT field.  The kept
+    // records are then written in read order.
+    WorkerPool workers(numThreads);
+    CleanTask cleanTask(numThreads);
+    std::vector<std::string> chunk(numThreads * BLOCKS_PER_THREAD *
+                                   LINES_PER_BLOCK);
+    String line = "";
+    bool moreLines = true;
+    while(moreLines)
     {
-        ++numReadRecords;
-        // Check if any samples are missing GT or if any are not phased.
-        if(!record.hasAllGenotypeAlleles() || !record.allPhased())
+        int numLines = 0;
+        while((numLines < (int)chunk.size()) && !ifeof(inFile))
         {
-            // Missing a GT or not phased, so continue without writing.
-            continue;
+            line.Clear();
+            if(PROFILE_CALL(PROFILE_READ, line.ReadLine(inFile)) < 0)
+            {
+                // Error/end of file, exit loop.
+                break;
+            }
+            int len = line.Length();
+            if((len > 0) && (line[len - 1] == '\r'))
+            {
+                // Clean CRLF lines as if they were LF lines.
+                --len;
+            }
+            if(len == 0)
+            {
+                continue;
+            }
+            if(line[0] == '#')
+            {
+                // Headers precede the records, so are written as read.
+                ifwrite(outFile, line.c_str(), len);
+                ifwrite(outFile, "\n", 1);
+                continue;
+            }
+            chunk[numLines++].assign(line.c_str(), len);
         }
-        
-        // Clear the INFO field.
-        record.getInfo().clear();
-        // Write the record.
-        if(!outFile.writeRecord(record))
+        moreLines = (numLines == (int)chunk.size());
+        numReadRecords += numLines;
+
+        // Check if any samples are missing GT or if any are not phased.
+        cleanTask.setChunk(chunk, numLines);
+        workers.run(cleanTask,
+                    (numLines + LINES_PER_BLOCK - 1) / LINES_PER_BLOCK);
+        PROFILE_SCOPE(PROFILE_WRITE);
+        for(int r = 0; r < numLines; r++)
         {
-            // Write error.
-            std::cerr << "Failed writing a vcf record.\n";
-            returnVal = -1;
+            if(!cleanTask.keep[r])
+            {
+                // Missing a GT or not phased, so continue without writing.
+                continue;
+            }
+            // Write the record.
+            if(ifwrite(outFile, chunk[r].data(), chunk[r].size()) != chunk[r].size())
+            {
+                // Write error.
+                std::cerr << "Failed writing a vcf record.\n";
+                returnVal = -1;
+            }
+            ++numWrittenRecords;
         }
-        ++numWrittenRecords;
     }
- 
-    inFile.close();   
-    outFile.close();   
+
+    ifclose(inFile);
+    ifclose(outFile);
 
     std::cerr << "NumReadRecords: " << numReadRecords
               << "; NumWrittenRecords: " << numWrittenRecords << "\n";
@@ -16,31 +16,163 @@
  */
 
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdexcept>
 
 
 #include "VcfConsensus.h"
-#include "VcfFileReader.h"
+#include "VcfMergeReader.h"
+#include "PackedGenotype.h"
 #include "VcfFileWriter.h"
+#include "WorkerPool.h"
+#include "BoundedQueue.h"
+#include "Profiler.h"
 
 bool isSame(const std::string* gt1, const std::string* gt2);
-bool findPos(bool newChrom, const char* chrom1, int pos1, VcfRecord& record2, VcfFileReader& vcf2);
 
-const int UNSET_POS = -1;
+static const std::string GT_FIELD = "GT";
+
+// Number of samples voted on by a worker at a time.
+static const int SAMPLE_BLOCK_SIZE = 1024;
+// Number of positions that can be aligned ahead of the voting.
+static const int NUM_ALIGNED_SITES = 8;
+
+// Rows & columns of the 3 input summary table.
+enum MatchType {ALL_MATCHED = 0, ONE_MATCHED_TWO, ONE_MATCHED_THREE,
+                TWO_MATCHED_THREE, NUM_MATCH_TYPES};
+enum MatchColumn {MATCH_TOTAL = 0, MATCH_00, MATCH_01, MATCH_11,
+                  NUM_MATCH_COLUMNS};
+
+// Index into the list of input pairs for inputs k < j.
+static inline int pairIndex(int k, int j)
+{
+    return(((j * (j - 1)) / 2) + k);
+}
+
+
+// Vote counts, kept per thread and summed after all positions are voted.
+struct ConsensusTally
+{
+    uint64_t numAllMatch;
+    uint64_t numNoMatches;
+    uint64_t matchTypes[NUM_MATCH_TYPES][NUM_MATCH_COLUMNS];
+    // Per input concordance with the consensus genotype.
+    std::vector<uint64_t> numAgree;
+    std::vector<uint64_t> numDisagree;
+    std::vector<uint64_t> numNoGT;
+
+    void init(int numInputs);
+    void add(const ConsensusTally& other);
+};
+
+
+// The records from each input at one position.
+struct AlignedSite
+{
+    std::vector<VcfRecord*> records;
+};
+
+
+static void deleteSites(std::vector<AlignedSite*>& sites)
+{
+    for(unsigned int s = 0; s < sites.size(); s++)
+    {
+        for(unsigned int j = 0; j < sites[s]->records.size(); j++)
+        {
+            delete sites[s]->records[j];
+        }
+        delete sites[s];
+    }
+    sites.clear();
+}
+
+
+// Finds the positions found in all inputs with matching ref/alt,
+// running ahead of the voting on its own thread when threads are used.
+struct SiteAligner
+{
+    VcfMergeReader* inputs;
+    const std::vector<std::string>* inputNames;
+    std::vector<bool> present;
+    std::vector<unsigned int> numMissing;
+    unsigned int numMismatchRefAlt;
+    unsigned int maxErrors;
+    // Serializes the error messages with those of the voting thread.
+    pthread_mutex_t* messageLock;
+    // Sites are taken from freeSites, filled, and added to alignedSites.
+    BoundedQueue<AlignedSite*>* freeSites;
+    BoundedQueue<AlignedSite*>* alignedSites;
+    // Set if reading failed on the alignment thread.
+    std::string error;
+
+    // Fill in the site with the records at the next aligned position.
+    // Returns false when there are no more positions.
+    bool alignNext(AlignedSite& site);
+
+    // Alignment thread: fills sites until the inputs are exhausted.
+    static void* run(void* arg);
+};
+
+
+// Votes on the consensus genotype for a block of samples at one position.
+class ConsensusVoteTask : public WorkerTask
+{
+public:
+    // Decisions other than the index of the input whose GT to output.
+    static const int NO_GT1 = -2;
+    static const int NO_CONSENSUS = -1;
+
+    ConsensusVoteTask(int numInputs, int numSamples, int numThreads,
+                      const std::vector<double>& weights,
+                      const std::vector< std::vector<int> >& sampleIndices,
+                      bool threeWayStats);
+
+    void setSite(AlignedSite* site);
+    virtual void runBlock(int blockIndex, int threadIndex);
+
+    // For each sample, the input whose GT is the consensus, or
+    // NO_GT1/NO_CONSENSUS.  An input of 0 means keep the first input's GT.
+    std::vector<int> decisions;
+    // Counts for each thread.
+    std::vector<ConsensusTally> tallies;
+
+private:
+    int myNumInputs;
+    int myNumSamples;
+    const std::vector<double>& myWeights;
+    const std::vector< std::vector<int> >& mySampleIndices;
+    bool myThreeWayStats;
+
+    std::vector<VcfRecordGenotype*> myGenotypeInfo;
+    // Packed GTs for each input and whether each pair of inputs match.
+    std::vector< std::vector<uint32_t> > myPackedGTs;
+    std::vector< std::vector<uint8_t> > myGTMatches;
+    // Per thread scratch space for grouping the inputs, numInputs per thread.
+    // gtClass is the index of the first input with the same GT, -1 if no GT.
+    std::vector<int> myGTClass;
+    std::vector<int> myClassVotes;
+    std::vector<double> myClassWeight;
+};
+
 
 void VcfConsensus::vcfConsensusDescription()
 {
-    std::cerr << " consensus - Write consensus VCF from 3 input VCFs" << std::endl;
+    std::cerr << " consensus - Write consensus VCF from 3 or more input VCFs" << std::endl;
 }
 
 
 void VcfConsensus::description()
 {
     vcfConsensusDescription();
-    std::cerr << "\t* Sites and samples not found in all 3 VCFs do not appear in the output VCF (silently skips sites not found in --in1).\n";
-    std::cerr << "\t* If all 3 VCFs have a different genotype, \"./.\" will be output.\n";
-    std::cerr << "\t* If at least 2 VCFs have the same genotype, that genotype will be output.\n";
+    std::cerr << "\t* Sites and samples not found in all input VCFs do not appear in the output VCF (silently skips sites not found in --in1).\n";
+    std::cerr << "\t* If no genotype is found in at least 2 VCFs, or there is a tie for the most votes, \"./.\" will be output.\n";
+    std::cerr << "\t* Otherwise the genotype with the most votes will be output.\n";
+    std::cerr << "\t* Votes are weighted by the optional weight column of --inList, defaulting to 1.\n";
     std::cerr << "\t* Does not handle more than diploid genotypes.\n";
-    std::cerr << "\t* Keeps all non-GT genotype settings from --in1.\n";
+    std::cerr << "\t* Keeps all non-GT genotype settings from --in1 (the first input).\n";
+    std::cerr << "\t* Inputs after the first with a tabix index (<file>.tbi) seek past positions not in the first input.\n";
+    std::cerr << "\t* Chromosomes are merged in the order of the ##contig lines of --in1; inputs in another order need a tabix index.\n";
     std::cerr << "\n";
 }
 
@@ -48,14 +180,23 @@ void VcfConsensus::description()
 void VcfConsensus::usage()
 {
     VcfExecutable::usage();
-    std::cerr << "\t./vcfUtil consensus --in1 <input VCF File1>  --in2 <input VCF File2>  --in3 <input VCF File3> --out <output VCF File> [--params]"<< std::endl;
+    std::cerr << "\t./vcfUtil consensus --in1 <input VCF File1>  --in2 <input VCF File2>  --in3 <input VCF File3> --out <output VCF File> [--threads <num>] [--seekGap <bases>] [--params]"<< std::endl;
+    std::cerr << "\t./vcfUtil consensus --inList <file of input VCFs> --out <output VCF File> [--threads <num>] [--seekGap <bases>] [--params]"<< std::endl;
     std::cerr << "\tRequired Parameters:\n"
               << "\t\t--in1      : VCF file1 to read\n"
               << "\t\t--in2      : VCF file2 to read\n"
               << "\t\t--in3      : VCF file3 to read\n"
               << "\t\t--out      : VCF file to write\n"
+              << "\t\t  or\n"
+              << "\t\t--inList   : file with 1 input VCF per line, format: filename [weight]\n"
+              << "\t\t             used in addition to any --in1/--in2/--in3 files.\n"
+              << "\t\t--out      : VCF file to write\n"
               << "\tOptional Parameters:\n"
               << "\t\t--uncompress : write an uncompressed VCF output file\n"
+              << "\t\t--threads    : number of threads for aligning & voting (default 1)\n"
+              << "\t\t--seekGap    : for inputs after the first with a tabix index, jump to the next\n"
+              << "\t\t               position of the first input when more than this many bases\n"
+              << "\t\t               behind it (default 100000, -1 to never skip ahead)\n"
               << "\t\t--params     : print the parameter settings\n"
               << std::endl;
 }
@@ -65,8 +206,11 @@ int VcfConsensus::execute(int argc, char ** argv)
     String vcfName1;
     String vcfName2;
     String vcfName3;
+    String inputList;
     String outputFileName;
     bool uncompress = false;
+    int numThreads = 1;
+    int seekGap = 100000;
     bool params = false;
 
     // Read in the parameters.    
@@ -76,9 +220,12 @@ int VcfConsensus::execute(int argc, char ** argv)
         LONG_STRINGPARAMETER("in1", &vcfName1)
         LONG_STRINGPARAMETER("in2", &vcfName2)
         LONG_STRINGPARAMETER("in3", &vcfName3)
+        LONG_STRINGPARAMETER("inList", &inputList)
         LONG_STRINGPARAMETER("out", &outputFileName)
         LONG_PARAMETER_GROUP("Optional Parameters")
         LONG_PARAMETER("uncompress", &uncompress)
+        LONG_INTPARAMETER("threads", &numThreads)
+        LONG_INTPARAMETER("seekGap", &seekGap)
         LONG_PARAMETER("params", &params)
         LONG_PHONEHOME(VERSION)
        END_LONG_PARAMETERS();
@@ -88,54 +235,120 @@ int VcfConsensus::execute(int argc, char ** argv)
     
     inputParameters.Read(argc-1, &(argv[1]));
     
-    std::string gtField = "GT";
-
-    VcfFileReader vcf1;
-    VcfFileReader vcf2;
-    VcfFileReader vcf3;
-    VcfHeader header1;
-    VcfHeader header2;
-    VcfHeader header3;
-    VcfRecord record1;
-    VcfRecord record2;
-    VcfRecord record3;
-    VcfRecordGenotype* genotypeInfoPtr1 = NULL;
-    VcfRecordGenotype* genotypeInfoPtr2 = NULL;
-    VcfRecordGenotype* genotypeInfoPtr3 = NULL;
-    
-    unsigned int numMissing2 = 0;
-    unsigned int numMissing3 = 0;
-    unsigned int numMismatchRefAlt = 0;
     unsigned int numMissingGT1 = 0;
     const unsigned int myMaxErrors = 4;
 
     // Check that the required parameters were set.
-    if(vcfName1 == "")
+    if(inputList.IsEmpty())
     {
-        usage();
-        inputParameters.Status();
-        std::cerr << "Missing \"--in1\", a required parameter.\n\n";
-        return(-1);
+        if(vcfName1 == "")
+        {
+            usage();
+            inputParameters.Status();
+            std::cerr << "Missing \"--in1\", a required parameter.\n\n";
+            return(-1);
+        }
+        if(vcfName2 == "")
+        {
+            usage();
+            inputParameters.Status();
+            std::cerr << "Missing \"--in2\", a required parameter.\n\n";
+            return(-1);
+        }
+        if(vcfName3 == "")
+        {
+            usage();
+            inputParameters.Status();
+            std::cerr << "Missing \"--in3\", a required parameter.\n\n";
+            return(-1);
+        }
     }
-    if(vcfName2 == "")
+    if(outputFileName == "")
     {
         usage();
         inputParameters.Status();
-        std::cerr << "Missing \"--in2\", a required parameter.\n\n";
+        std::cerr << "Missing \"--out\", a required parameter.\n\n";
         return(-1);
     }
-    if(vcfName3 == "")
+
+    // Build the list of input files, labels, & weights.
+    std::vector<std::string> inputNames;
+    std::vector<std::string> inputLabels;
+    std::vector<double> weights;
+    bool weighted = false;
+    if(vcfName1 != "")
+    {
+        inputNames.push_back(vcfName1.c_str());
+        inputLabels.push_back("--in1");
+        weights.push_back(1);
+    }
+    if(vcfName2 != "")
+    {
+        inputNames.push_back(vcfName2.c_str());
+        inputLabels.push_back("--in2");
+        weights.push_back(1);
+    }
+    if(vcfName3 != "")
+    {
+        inputNames.push_back(vcfName3.c_str());
+        inputLabels.push_back("--in3");
+        weights.push_back(1);
+    }
+    if(!inputList.IsEmpty())
+    {
+        IFILE listFile = ifopen(inputList, "r");
+        if(listFile == NULL)
+        {
+            std::cerr << "Failed to open --inList file " << inputList << "\n";
+            return(-1);
+        }
+        String listLine;
+        StringArray listColumn;
+        while(!ifeof(listFile))
+        {
+            listLine.Clear();
+            listLine.ReadLine(listFile);
+            listColumn.ReplaceTokens(listLine, " \t\r\n");
+            if(listColumn.Length() == 0)
+            {
+                // Nothing on this line, continue to the next.
+                continue;
+            }
+            double weight = 1;
+            if((listColumn.Length() > 2) ||
+               ((listColumn.Length() == 2) && !listColumn[1].AsDouble(weight)) ||
+               (weight <= 0))
+            {
+                std::cerr << "Improperly formatted --inList line: " << listLine
+                          << "; expected: filename [positive weight]\n";
+                ifclose(listFile);
+                return(-1);
+            }
+            if(weight != 1)
+            {
+                weighted = true;
+            }
+            inputNames.push_back(listColumn[0].c_str());
+            inputLabels.push_back(listColumn[0].c_str());
+            weights.push_back(weight);
+        }
+        ifclose(listFile);
+    }
+
+    if(inputNames.size() < 3)
     {
         usage();
         inputParameters.Status();
-        std::cerr << "Missing \"--in3\", a required parameter.\n\n";
+        std::cerr << "At least 3 input VCFs are required, but only "
+                  << inputNames.size() << " were specified.\n\n";
         return(-1);
     }
-    if(outputFileName == "")
+
+    if(numThreads < 1)
     {
         usage();
         inputParameters.Status();
-        std::cerr << "Missing \"--out\", a required parameter.\n\n";
+        std::cerr << "--threads must be at least 1.\n\n";
         return(-1);
     }
 
@@ -144,38 +357,67 @@ int VcfConsensus::execute(int argc, char ** argv)
         inputParameters.Status();
     }
 
+    const int numInputs = inputNames.size();
     
     // Open the files.
-    vcf1.open(vcfName1, header1);
-    vcf2.open(vcfName2, header2);
-    vcf3.open(vcfName3, header3);
+    VcfMergeReader inputs;
+    for(int j = 0; j < numInputs; j++)
+    {
+        if(inputs.open(inputNames[j].c_str()) < 0)
+        {
+            std::cerr << "Failed to open " << inputNames[j] << "\n";
+            return(-1);
+        }
+    }
+    // Only positions in the first input are output, so the other inputs
+    // can use their indexes to skip the records in between and to read
+    // their chromosomes in the same order as the first input.
+    inputs.setFirstInputDriven(seekGap);
+    for(int j = 1; j < numInputs; j++)
+    {
+        std::string indexName = inputNames[j] + ".tbi";
+        if((access(indexName.c_str(), R_OK) == 0) && !inputs.readIndex(j))
+        {
+            std::cerr << "Failed to read " << indexName
+                      << ", so reading all records of " << inputNames[j] << "\n";
+        }
+    }
+    VcfHeader& header1 = inputs.getHeader(0);
 
     // Setup the sample name maps.
+    // sampleIndices[j][i] is the index in input j of sample i of the output.
     int numSamples = header1.getNumSamples();
-    std::vector<int> sample2Indices;
-    std::vector<int> sample3Indices;
+    std::vector< std::vector<int> > sampleIndices(numInputs);
+    std::vector<int> foundIndices(numInputs);
     std::vector<int> removeIndices;
-    int numSamplesSkipped1 = 0;
-    int numSamplesSkipped2 = 0;
-    int numSamplesSkipped3 = 0;
     for(int i = 0; i < numSamples; i++)
     {
-        int sm2Index = header2.getSampleIndex(header1.getSampleName(i));
-        int sm3Index = header3.getSampleIndex(header1.getSampleName(i));
-        // Look for this sample name in vcf2.
-        if((sm2Index != -1) && (sm3Index != -1))
+        // Look for this sample name in each of the other vcfs.
+        bool foundAll = true;
+        for(int j = 1; j < numInputs; j++)
         {
-            sample2Indices.push_back(sm2Index);
-            sample3Indices.push_back(sm3Index);
+            foundIndices[j] = 
+                inputs.getHeader(j).getSampleIndex(header1.getSampleName(i));
+            if(foundIndices[j] == -1)
+            {
+                foundAll = false;
+            }
+        }
+        if(foundAll)
+        {
+            sampleIndices[0].push_back(sampleIndices[0].size());
+            for(int j = 1; j < numInputs; j++)
+            {
+                sampleIndices[j].push_back(foundIndices[j]);
+            }
         }
         else
         {
-            // Sample not found in all three vcfs.
+            // Sample not found in all vcfs.
             removeIndices.push_back(i);
-            ++numSamplesSkipped1;
         }
     }
-    // Remove samples not found in all 3 vcfs from header1.
+    // Remove samples not found in all vcfs from header1.
     // Remove them in reverse order so they are removed from the end of the header first.
     VcfSubsetSamples subset1;
     subset1.init(header1, true);
@@ -184,25 +426,21 @@ int VcfConsensus::execute(int argc, char ** argv)
         subset1.addExcludeSample(header1.getSampleName(removeIndices[i]));
         header1.removeSample(removeIndices[i]);
     }
+    inputs.setSampleSubset(0, &subset1);
 
     // Set numSamples to the new number of samples in header1.
     numSamples = header1.getNumSamples();
 
-    // Calculate the number of samples skipped for files 2 & 3.
-    numSamplesSkipped2 = header2.getNumSamples() - sample2Indices.size();
-    numSamplesSkipped3 = header3.getNumSamples() - sample3Indices.size();
-
-    if(numSamplesSkipped1 > 0)
-    {
-        std::cerr << "Skipping " << numSamplesSkipped1 << " samples from --in1\n";
-    }
-    if(numSamplesSkipped2 > 0)
-    {
-        std::cerr << "Skipping " << numSamplesSkipped2 << " samples from --in2\n";
-    }
-    if(numSamplesSkipped3 > 0)
+    // Report the number of samples skipped for each file.
+    for(int j = 0; j < numInputs; j++)
     {
-        std::cerr << "Skipping " << numSamplesSkipped3 << " samples from --in3\n";
+        int numSamplesSkipped = (j == 0) ? removeIndices.size() :
+            inputs.getHeader(j).getNumSamples() - sampleIndices[j].size();
+        if(numSamplesSkipped > 0)
+        {
+            std::cerr << "Skipping " << numSamplesSkipped << " samples from "
+                      << inputLabels[j] << "\n";
+        }
     }
 
     VcfFileWriter outputVcf;
@@ -216,232 +454,169 @@ int VcfConsensus::execute(int argc, char ** argv)
         outputVcf.open(outputFileName, header1);
     }
 
-    const char* chrom1 = NULL;
-    int pos1 = UNSET_POS;
-
-    // Read the first record from vcf2 & vcf3.
-    vcf2.readRecord(record2);
-    vcf3.readRecord(record3);
-
-    bool newChrom = true;
-    static std::string prevChrom = "";
-
-    uint64_t numAllMatch = 0;
-    uint64_t num1Match2Only = 0;
-    uint64_t num1Match3Only = 0;
-    uint64_t num2Match3Only = 0;
-    uint64_t numNoMatches = 0;
-
-    uint64_t numAllMatch00 = 0;
-    uint64_t num1Match2Only00 = 0;
-    uint64_t num1Match3Only00 = 0;
-    uint64_t num2Match3Only00 = 0;
-
-    uint64_t numAllMatch01 = 0;
-    uint64_t num1Match2Only01 = 0;
-    uint64_t num1Match3Only01 = 0;
-    uint64_t num2Match3Only01 = 0;
-
-    uint64_t numAllMatch11 = 0;
-    uint64_t num1Match2Only11 = 0;
-    uint64_t num1Match3Only11 = 0;
-    uint64_t num2Match3Only11 = 0;
-
-    // Loop through vcf1.
-    while(vcf1.readRecord(record1, &subset1))
+    for(int j = 0; j < numInputs; j++)
     {
-        chrom1 = record1.getChromStr();
-        pos1 = record1.get1BasedPosition();
+        // Pad the sample maps so the first element can always be addressed.
+        sampleIndices[j].push_back(-1);
+    }
 
-        if(strcmp(chrom1, prevChrom.c_str()) == 0)
-        {
-            newChrom = false;
-        }
-        else
-        {
-            prevChrom = chrom1;
-            newChrom = true;
-        }
+    // The 3 input summary table only applies for unweighted votes.
+    bool threeWayStats = (numInputs == 3) && !weighted;
 
-        bool found = true;
-        if(!findPos(newChrom, chrom1, pos1, record2, vcf2))
-        {
-            // Failed to find the position, continue to the next position
-            if(++numMissing2 <= myMaxErrors)
-            {
-                std::cerr << "Failed to find " << chrom1 << ":" << pos1 
-                          << " in " << vcfName2 << ", so skipping this pos\n";
-            }
-            found = false;
-        }
-        
-        if(!findPos(newChrom, chrom1, pos1, record3, vcf3))
-        {
-            // Failed to find the position, continue to the next position
-            if(++numMissing3 <= myMaxErrors)
-            {
-                std::cerr << "Failed to find " << chrom1 << ":" << pos1 
-                          << " in " << vcfName3 << ", so skipping this pos\n";
-            }
-            found = false;
-        }
+    // The samples are voted on in blocks by the worker threads while
+    // the next positions are aligned on a separate thread.
+    WorkerPool workers(numThreads);
+    ConsensusVoteTask voteTask(numInputs, numSamples, numThreads, weights,
+                               sampleIndices, threeWayStats);
+    int numBlocks = (numSamples + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE;
 
-        if(found == false)
+    pthread_mutex_t messageLock;
+    pthread_mutex_init(&messageLock, NULL);
+    BoundedQueue<AlignedSite*> freeSites(NUM_ALIGNED_SITES);
+    BoundedQueue<AlignedSite*> alignedSites(NUM_ALIGNED_SITES);
+    std::vector<AlignedSite*> sites(NUM_ALIGNED_SITES);
+    for(int s = 0; s < NUM_ALIGNED_SITES; s++)
+    {
+        sites[s] = new AlignedSite();
+        for(int j = 0; j < numInputs; j++)
         {
-            continue;
+            sites[s]->records.push_back(new VcfRecord());
         }
+        freeSites.push(sites[s]);
+    }
 
-        // Found the position in all files.
-        
-        // Validate that the reference & alternate alleles are the same.
-        const char* ref1 = record1.getRefStr();
-        const char* alt1 = record1.getAltStr();
-        if((strcmp(ref1, record2.getRefStr()) != 0) ||
-           (strcmp(ref1, record3.getRefStr()) != 0) ||
-           (strcmp(alt1, record2.getAltStr()) != 0) ||
-           (strcmp(alt1, record3.getAltStr()) != 0))
-        {
-            if(++numMismatchRefAlt <= myMaxErrors)
-            {
-                std::cerr << "Mismatching ref/alt found at " << chrom1 << ":" << pos1 << ", so skipping this pos\n";
-            }
-            continue;
-        }
+    SiteAligner aligner;
+    aligner.inputs = &inputs;
+    aligner.inputNames = &inputNames;
+    aligner.numMissing.assign(numInputs, 0);
+    aligner.numMismatchRefAlt = 0;
+    aligner.maxErrors = myMaxErrors;
+    aligner.messageLock = &messageLock;
+    aligner.freeSites = &freeSites;
+    aligner.alignedSites = &alignedSites;
 
-        // Get the genotype information for each.
-        genotypeInfoPtr1 = &(record1.getGenotypeInfo());
-        genotypeInfoPtr2 = &(record2.getGenotypeInfo());
-        genotypeInfoPtr3 = &(record3.getGenotypeInfo());
+    // With 1 thread, align each position just before voting on it.
+    bool pipelined = (numThreads > 1);
+    pthread_t alignThread;
+    if(pipelined &&
+       (pthread_create(&alignThread, NULL, SiteAligner::run, &aligner) != 0))
+    {
+        std::cerr << "Failed to create the alignment thread, so aligning on the main thread\n";
+        pipelined = false;
+    }
 
-        // Loop through all the samples in vcf1.
-        // Get the Genotype Information.
-        for(int i = 0; i < numSamples; i++)
+    // If voting or writing fails, stop the aligner before the queues and
+    // sites it uses are destroyed.
+    try
+    {
+        // Loop through the aligned positions.
+        AlignedSite* site = NULL;
+        while(true)
         {
-            const std::string* genotypeVal1 = genotypeInfoPtr1->getString(gtField, i);
-            const std::string* genotypeVal2 = genotypeInfoPtr2->getString(gtField, sample2Indices[i]);
-            const std::string* genotypeVal3 = genotypeInfoPtr3->getString(gtField, sample3Indices[i]);
-            // Need to make sure the field was found.
-            if(genotypeVal1 == NULL)
+            if(pipelined)
             {
-                // GT not found in the first record, so just continue.
-                if(++numMissingGT1 <= myMaxErrors)
+                if(!alignedSites.pop(site))
                 {
-                    std::cerr << "Missing GT for " << header1.getSampleName(i) << " in " << vcfName1 << "\n";
+                    break;
                 }
-                continue;
             }
-
-
-            if(isSame(genotypeVal1, genotypeVal2))
+            else
             {
-                // genotypeVal1 is majority, so make no change.
-                if(isSame(genotypeVal1, genotypeVal3))
-                {
-                    ++numAllMatch;
-                    if(*genotypeVal1 == "0/0")
-                    {
-                        ++numAllMatch00;
-                    }
-                    else if((*genotypeVal1 == "0/1") || 
-                            (*genotypeVal1 == "1/0"))
-                    {
-                        ++numAllMatch01;
-                    }
-                    if(*genotypeVal1 == "1/1")
-                    {
-                        ++numAllMatch11;
-                    }
-                }
-                else
+                site = sites[0];
+                if(!aligner.alignNext(*site))
                 {
-                    ++num1Match2Only;
-                    if(*genotypeVal1 == "0/0")
-                    {
-                        ++num1Match2Only00;
-                    }
-                    else if((*genotypeVal1 == "0/1") || 
-                            (*genotypeVal1 == "1/0"))
-                    {
-                        ++num1Match2Only01;
-                    }
-                    if(*genotypeVal1 == "1/1")
-                    {
-                        ++num1Match2Only11;
-                    }
+                    break;
                 }
             }
-            else if(isSame(genotypeVal1, genotypeVal3))
+
+            voteTask.setSite(site);
+            workers.run(voteTask, numBlocks);
+
+            // Apply the votes to the first input's record.
+            VcfRecordGenotype& genotypeInfo1 = site->records[0]->getGenotypeInfo();
+            for(int i = 0; i < numSamples; i++)
             {
-                // genotypeVal1 is majority, so make no change.
-                    ++num1Match3Only;
-                    if(*genotypeVal1 == "0/0")
-                    {
-                        ++num1Match3Only00;
-                    }
-                    else if((*genotypeVal1 == "0/1") || 
-                            (*genotypeVal1 == "1/0"))
-                    {
-                        ++num1Match3Only01;
-                    }
-                    if(*genotypeVal1 == "1/1")
+                int winner = voteTask.decisions[i];
+                if(winner == ConsensusVoteTask::NO_GT1)
+                {
+                    // GT not found in the first record, so just continue.
+                    pthread_mutex_lock(&messageLock);
+                    if(++numMissingGT1 <= myMaxErrors)
                     {
-                        ++num1Match3Only11;
+                        std::cerr << "Missing GT for " << header1.getSampleName(i) << " in " << inputNames[0] << "\n";
                     }
-            }
-            else if(isSame(genotypeVal2, genotypeVal3))
-            {
-                // genotypeVal2 is majority, so change genotypeVal1.
-                genotypeInfoPtr1->setString(gtField, i, *genotypeVal2);
-                ++num2Match3Only;
-                if(*genotypeVal2 == "0/0")
-                {
-                    ++num2Match3Only00;
+                    pthread_mutex_unlock(&messageLock);
                 }
-                else if((*genotypeVal2 == "0/1") || 
-                        (*genotypeVal2 == "1/0"))
+                else if(winner == ConsensusVoteTask::NO_CONSENSUS)
                 {
-                    ++num2Match3Only01;
+                    // No consensus so set to "./."
+                    genotypeInfo1.setString(GT_FIELD, i, "./.");
                 }
-                if(*genotypeVal2 == "1/1")
+                else if(winner != 0)
                 {
-                    ++num2Match3Only11;
+                    // The winner's genotype is the consensus, so change vcf1's.
+                    genotypeInfo1.setString(GT_FIELD, i,
+                                            *(site->records[winner]->getGenotypeInfo().getString(GT_FIELD, sampleIndices[winner][i])));
                 }
             }
-            else
+
+            // Write this record.
+            PROFILE_CALL(PROFILE_WRITE, outputVcf.writeRecord(*(site->records[0])));
+
+            if(pipelined)
             {
-                // None are the same so set to "./."
-                genotypeInfoPtr1->setString(gtField, i, "./.");
-                ++numNoMatches;
+                freeSites.push(site);
             }
-        } // loop back to vcf1 samples.
+        } // loop back to next aligned position.
+    }
+    catch(...)
+    {
+        if(pipelined)
+        {
+            freeSites.close();
+            alignedSites.close();
+            pthread_join(alignThread, NULL);
+        }
+        pthread_mutex_destroy(&messageLock);
+        deleteSites(sites);
+        throw;
+    }
 
-        // Write this record.
-        outputVcf.writeRecord(record1);
-    } // loop back to next vcf1 record.
+    if(pipelined)
+    {
+        pthread_join(alignThread, NULL);
+    }
+    pthread_mutex_destroy(&messageLock);
+    deleteSites(sites);
+    if(!aligner.error.empty())
+    {
+        throw(std::runtime_error(aligner.error));
+    }
 
-    std::cerr << "\n";
-    if(numMissing2 > myMaxErrors)
+    // Sum the counts from each thread.
+    ConsensusTally total = voteTask.tallies[0];
+    for(int t = 1; t < numThreads; t++)
     {
-        std::cerr << "Suppressed "
-                  << numMissing2 - myMaxErrors
-                  << " errors about skipped positions because they were not in "
-                  << vcfName2
-                  << "\n";
+        total.add(voteTask.tallies[t]);
     }
 
-    if(numMissing3 > myMaxErrors)
+    std::cerr << "\n";
+    for(int j = 1; j < numInputs; j++)
     {
-        std::cerr << "Suppressed "
-                  << numMissing3 - myMaxErrors
-                  << " errors about skipped positions because they were not in "
-                  << vcfName3
-                  << "\n";
+        if(aligner.numMissing[j] > myMaxErrors)
+        {
+            std::cerr << "Suppressed "
+                      << aligner.numMissing[j] - myMaxErrors
+                      << " errors about skipped positions because they were not in "
+                      << inputNames[j]
+                      << "\n";
+        }
     }
 
-    if(numMismatchRefAlt > myMaxErrors)
+    if(aligner.numMismatchRefAlt > myMaxErrors)
     {
         std::cerr << "Suppressed "
-                  << numMismatchRefAlt - myMaxErrors
+                  << aligner.numMismatchRefAlt - myMaxErrors
                   << " errors about mismatched ref/alt positions\n";
     }
 
@@ -450,99 +625,420 @@ int VcfConsensus::execute(int argc, char ** argv)
         std::cerr << "Suppressed "
                   << numMissingGT1 - myMaxErrors
                   << " errors about missing GT for "
-                  << vcfName1
+                  << inputNames[0]
                   << "\n";
     }
     std::cerr << "\n";
     // Output the stats.
-    std::cerr << "File1 = " << vcfName1 << std::endl;
-    std::cerr << "File2 = " << vcfName2 << std::endl;
-    std::cerr << "File3 = " << vcfName3 << std::endl;
-    std::cerr << "\nType\tTotal\t0/0\t0/1|1/0\t1/1\n";
-    std::cerr << "AllMatched" 
-              << "\t" << numAllMatch
-              << "\t" << numAllMatch00 
-              << "\t" << numAllMatch01 
-              << "\t" << numAllMatch11 << std::endl;
-    std::cerr << "1matched2"
-              << "\t" << num1Match2Only 
-              << "\t" << num1Match2Only00 
-              << "\t" << num1Match2Only01 
-              << "\t" << num1Match2Only11 << std::endl;
-    std::cerr << "1matched3"
-              << "\t" << num1Match3Only 
-              << "\t" << num1Match3Only00 
-              << "\t" << num1Match3Only01 
-              << "\t" << num1Match3Only11 << std::endl;
-    std::cerr << "2matched3"
-              << "\t" << num2Match3Only
-              << "\t" << num2Match3Only00 
-              << "\t" << num2Match3Only01 
-              << "\t" << num2Match3Only11 << std::endl;
-    std::cerr << "NoneMatched\t" << numNoMatches << std::endl;
+    for(int j = 0; j < numInputs; j++)
+    {
+        std::cerr << "File" << j + 1 << " = " << inputNames[j] << std::endl;
+    }
+    if(threeWayStats)
+    {
+        static const char* matchTypeNames[NUM_MATCH_TYPES] =
+            {"AllMatched", "1matched2", "1matched3", "2matched3"};
+        std::cerr << "\nType\tTotal\t0/0\t0/1|1/0\t1/1\n";
+        for(int m = 0; m < NUM_MATCH_TYPES; m++)
+        {
+            std::cerr << matchTypeNames[m];
+            for(int c = 0; c < NUM_MATCH_COLUMNS; c++)
+            {
+                std::cerr << "\t" << total.matchTypes[m][c];
+            }
+            std::cerr << std::endl;
+        }
+        std::cerr << "NoneMatched\t" << total.numNoMatches << std::endl;
+    }
+    else
+    {
+        std::cerr << "\nAllMatched\t" << total.numAllMatch << std::endl;
+        std::cerr << "NoneMatched\t" << total.numNoMatches << std::endl;
+    }
+
+    if(!inputList.IsEmpty())
+    {
+        // Output the concordance of each input with the consensus.
+        std::cerr << "\nFile\tWeight\tAgree\tDisagree\tNoGT\tConcordance\n";
+        for(int j = 0; j < numInputs; j++)
+        {
+            uint64_t numCalled = total.numAgree[j] + total.numDisagree[j];
+            std::cerr << "File" << j + 1
+                      << "\t" << weights[j]
+                      << "\t" << total.numAgree[j]
+                      << "\t" << total.numDisagree[j]
+                      << "\t" << total.numNoGT[j]
+                      << "\t" << ((numCalled == 0) ? 0 : (double)total.numAgree[j]/numCalled)
+                      << std::endl;
+        }
+    }
 
     return(0);
 }
 
 
-bool isSame(const std::string* gt1, const std::string* gt2)
+void ConsensusTally::init(int numInputs)
 {
-    if((gt1 == NULL) || (gt2 == NULL))
+    numAllMatch = 0;
+    numNoMatches = 0;
+    for(int m = 0; m < NUM_MATCH_TYPES; m++)
     {
-        // no gt, so return false.
-        return(false);
+        for(int c = 0; c < NUM_MATCH_COLUMNS; c++)
+        {
+            matchTypes[m][c] = 0;
+        }
     }
+    numAgree.assign(numInputs, 0);
+    numDisagree.assign(numInputs, 0);
+    numNoGT.assign(numInputs, 0);
+}
 
-    if(*gt1 == *gt2)
+
+void ConsensusTally::add(const ConsensusTally& other)
+{
+    numAllMatch += other.numAllMatch;
+    numNoMatches += other.numNoMatches;
+    for(int m = 0; m < NUM_MATCH_TYPES; m++)
     {
-        return(true);
+        for(int c = 0; c < NUM_MATCH_COLUMNS; c++)
+        {
+            matchTypes[m][c] += other.matchTypes[m][c];
+        }
+    }
+    for(unsigned int j = 0; j < numAgree.size(); j++)
+    {
+        numAgree[j] += other.numAgree[j];
+        numDisagree[j] += other.numDisagree[j];
+        numNoGT[j] += other.numNoGT[j];
     }
+}
 
-    // Check for 0/1 && 1/0
-    if((gt1->length() == 3) && (gt2->length() == 3))
+
+bool SiteAligner::alignNext(AlignedSite& site)
+{
+    int numInputs = inputs->getNumInputs();
+
+    // Loop through the merged positions.
+    while(inputs->readMergedRecords(present))
     {
-        // Check if the alleles are in a different order.
-        if((gt1->at(0) == gt2->at(2)) && (gt1->at(2) == gt2->at(0)))
+        if(!present[0])
         {
-            return(true);
+            // Silently skip positions not in the first vcf.
+            continue;
+        }
+        const char* chrom1 = inputs->getChromStr();
+        int pos1 = inputs->get1BasedPosition();
+
+        bool found = true;
+        for(int j = 1; j < numInputs; j++)
+        {
+            if(!present[j])
+            {
+                // Failed to find the position, continue to the next position
+                pthread_mutex_lock(messageLock);
+                if(++numMissing[j] <= maxErrors)
+                {
+                    std::cerr << "Failed to find " << chrom1 << ":" << pos1
+                              << " in " << (*inputNames)[j] << ", so skipping this pos\n";
+                }
+                pthread_mutex_unlock(messageLock);
+                found = false;
+            }
         }
+
+        if(found == false)
+        {
+            continue;
+        }
+
+        // Found the position in all files.
+        // Validate that the reference & alternate alleles are the same.
+        const char* ref1 = inputs->getRecord(0).getRefStr();
+        const char* alt1 = inputs->getRecord(0).getAltStr();
+        bool sameRefAlt = true;
+        for(int j = 1; j < numInputs; j++)
+        {
+            if((strcmp(ref1, inputs->getRecord(j).getRefStr()) != 0) ||
+               (strcmp(alt1, inputs->getRecord(j).getAltStr()) != 0))
+            {
+                sameRefAlt = false;
+                break;
+            }
+        }
+        if(!sameRefAlt)
+        {
+            pthread_mutex_lock(messageLock);
+            if(++numMismatchRefAlt <= maxErrors)
+            {
+                std::cerr << "Mismatching ref/alt found at " << chrom1 << ":" << pos1 << ", so skipping this pos\n";
+            }
+            pthread_mutex_unlock(messageLock);
+            continue;
+        }
+
+        // Take the records, leaving the site's old records to be read into.
+        for(int j = 0; j < numInputs; j++)
+        {
+            site.records[j] = inputs->swapRecord(j, site.records[j]);
+        }
+        return(true);
     }
     return(false);
 }
 
 
-// The VcfRecord passed in should already be set with a record.
-bool findPos(bool newChrom, const char* chrom1, int pos1, VcfRecord& record2, VcfFileReader& vcf2)
+void* SiteAligner::run(void* arg)
+{
+    SiteAligner* aligner = (SiteAligner*)arg;
+    AlignedSite* site = NULL;
+    try
+    {
+        while(aligner->freeSites->pop(site))
+        {
+            if(!aligner->alignNext(*site))
+            {
+                break;
+            }
+            if(!aligner->alignedSites->push(site))
+            {
+                // The main thread stopped early.
+                break;
+            }
+        }
+    }
+    catch(std::exception& e)
+    {
+        // Pass the failure to the main thread.
+        aligner->error = e.what();
+    }
+    aligner->alignedSites->close();
+    return(NULL);
+}
+
+
+ConsensusVoteTask::ConsensusVoteTask(int numInputs, int numSamples,
+                                     int numThreads,
+                                     const std::vector<double>& weights,
+                                     const std::vector< std::vector<int> >& sampleIndices,
+                                     bool threeWayStats)
+    : decisions(numSamples),
+      tallies(numThreads),
+      myNumInputs(numInputs),
+      myNumSamples(numSamples),
+      myWeights(weights),
+      mySampleIndices(sampleIndices),
+      myThreeWayStats(threeWayStats),
+      myGenotypeInfo(numInputs, (VcfRecordGenotype*)NULL),
+      // Sized to at least 1 so the first element can always be addressed.
+      myPackedGTs(numInputs, std::vector<uint32_t>(numSamples + 1)),
+      myGTMatches((numInputs * (numInputs - 1)) / 2, std::vector<uint8_t>(numSamples + 1)),
+      myGTClass(numInputs * numThreads),
+      myClassVotes(numInputs * numThreads),
+      myClassWeight(numInputs * numThreads)
+{
+    for(int t = 0; t < numThreads; t++)
+    {
+        tallies[t].init(numInputs);
+    }
+}
+
+
+void ConsensusVoteTask::setSite(AlignedSite* site)
+{
+    for(int j = 0; j < myNumInputs; j++)
+    {
+        myGenotypeInfo[j] = &(site->records[j]->getGenotypeInfo());
+    }
+}
+
+
+void ConsensusVoteTask::runBlock(int blockIndex, int threadIndex)
 {
-    const char* chrom2 = record2.getChromStr();
-    int pos2 = record2.get1BasedPosition();
+    int start = blockIndex * SAMPLE_BLOCK_SIZE;
+    int end = start + SAMPLE_BLOCK_SIZE;
+    if(end > myNumSamples)
+    {
+        end = myNumSamples;
+    }
+    ConsensusTally& tally = tallies[threadIndex];
+    int* gtClass = &(myGTClass[threadIndex * myNumInputs]);
+    int* classVotes = &(myClassVotes[threadIndex * myNumInputs]);
+    double* classWeight = &(myClassWeight[threadIndex * myNumInputs]);
 
-    // Loop until the chrom/pos is found in vcf2.
-    bool sameChrom = (strcmp(chrom2, chrom1) == 0);
-    while(((pos2 < pos1) && sameChrom) ||
-          (newChrom && !sameChrom))
+    // Decode the GTs of each input once into packed integers.
+    for(int j = 0; j < myNumInputs; j++)
     {
-        if(vcf2.readRecord(record2))
+        uint32_t* gts = &(myPackedGTs[j][0]);
+        const int* indices = &(mySampleIndices[j][0]);
+        for(int i = start; i < end; i++)
         {
-            chrom2 = record2.getChromStr();
-            pos2 = record2.get1BasedPosition();
-            sameChrom = (strcmp(chrom2, chrom1) == 0);
+            gts[i] = PackedGenotype::pack(myGenotypeInfo[j]->getString(GT_FIELD, indices[i]));
         }
-        else
+    }
+
+    // Compare each pair of inputs across the block of samples.
+    for(int j = 1; j < myNumInputs; j++)
+    {
+        for(int k = 0; k < j; k++)
         {
-            // no more records.
-            chrom2 = NULL;
-            pos2 = UNSET_POS;
-            return(false);
+            PackedGenotype::compare(&(myPackedGTs[k][start]), &(myPackedGTs[j][start]),
+                                    &(myGTMatches[pairIndex(k, j)][start]),
+                                    end - start);
         }
     }
-    // If we wind up here, chrom2 is either at the correct 
-    // position, or it is past the correct position.
-    if((!sameChrom) || (pos2 != pos1))
+
+    // Loop through the samples in this block.
+    for(int i = start; i < end; i++)
+    {
+        // Need to make sure the field was found.
+        if(myPackedGTs[0][i] == PackedGenotype::NO_GT)
+        {
+            decisions[i] = NO_GT1;
+            continue;
+        }
+
+        // Group the inputs by matching genotypes, tallying the
+        // votes for each group.
+        for(int j = 0; j < myNumInputs; j++)
+        {
+            classVotes[j] = 0;
+            classWeight[j] = 0;
+            uint32_t gt = myPackedGTs[j][i];
+            if(gt == PackedGenotype::NO_GT)
+            {
+                gtClass[j] = -1;
+                continue;
+            }
+            gtClass[j] = j;
+            for(int k = 0; k < j; k++)
+            {
+                if(gtClass[k] != k)
+                {
+                    continue;
+                }
+                if(myGTMatches[pairIndex(k, j)][i] ||
+                   ((gt & myPackedGTs[k][i] & PackedGenotype::UNPACKABLE) &&
+                    isSame(myGenotypeInfo[k]->getString(GT_FIELD, mySampleIndices[k][i]),
+                           myGenotypeInfo[j]->getString(GT_FIELD, mySampleIndices[j][i]))))
+                {
+                    gtClass[j] = k;
+                    break;
+                }
+            }
+            ++classVotes[gtClass[j]];
+            classWeight[gtClass[j]] += myWeights[j];
+        }
+
+        // The consensus needs at least 2 votes and more weight
+        // than any other genotype.
+        int winner = NO_CONSENSUS;
+        bool tied = false;
+        for(int j = 0; j < myNumInputs; j++)
+        {
+            if(gtClass[j] != j)
+            {
+                continue;
+            }
+            if((winner == NO_CONSENSUS) || (classWeight[j] > classWeight[winner]))
+            {
+                winner = j;
+                tied = false;
+            }
+            else if(classWeight[j] == classWeight[winner])
+            {
+                tied = true;
+            }
+        }
+        if(tied || (winner == NO_CONSENSUS) || (classVotes[winner] < 2))
+        {
+            winner = NO_CONSENSUS;
+            ++tally.numNoMatches;
+        }
+        decisions[i] = winner;
+
+        // Tally the concordance of each input with the consensus.
+        for(int j = 0; j < myNumInputs; j++)
+        {
+            if(gtClass[j] == -1)
+            {
+                ++tally.numNoGT[j];
+            }
+            else if(gtClass[j] == winner)
+            {
+                ++tally.numAgree[j];
+            }
+            else
+            {
+                ++tally.numDisagree[j];
+            }
+        }
+
+        if(winner == NO_CONSENSUS)
+        {
+            continue;
+        }
+        if(myThreeWayStats)
+        {
+            int matchType = TWO_MATCHED_THREE;
+            if((gtClass[1] == 0) && (gtClass[2] == 0))
+            {
+                matchType = ALL_MATCHED;
+            }
+            else if(gtClass[1] == 0)
+            {
+                matchType = ONE_MATCHED_TWO;
+            }
+            else if(gtClass[2] == 0)
+            {
+                matchType = ONE_MATCHED_THREE;
+            }
+            uint32_t gt = myPackedGTs[winner][i];
+            uint64_t* counts = tally.matchTypes[matchType];
+            ++counts[MATCH_TOTAL];
+            counts[MATCH_00] += (gt == PackedGenotype::UNPHASED_00);
+            counts[MATCH_01] += (gt == PackedGenotype::UNPHASED_01);
+            counts[MATCH_11] += (gt == PackedGenotype::UNPHASED_11);
+        }
+        else if(winner == 0)
+        {
+            bool allMatch = true;
+            for(int j = 1; j < myNumInputs; j++)
+            {
+                if(gtClass[j] != 0)
+                {
+                    allMatch = false;
+                    break;
+                }
+            }
+            if(allMatch)
+            {
+                ++tally.numAllMatch;
+            }
+        }
+    } // loop back to the next sample in the block.
+}
+
+bool isSame(const std::string* gt1, const std::string* gt2)
+{
+    if((gt1 == NULL) || (gt2 == NULL))
     {
-        // Position not found.
+        // no gt, so return false.
         return(false);
     }
-    return(true);
-}    
 
+    if(*gt1 == *gt2)
+    {
+        return(true);
+    }
+
+    // Check for 0/1 && 1/0
+    if((gt1->length() == 3) && (gt2->length() == 3))
+    {
+        // Check if the alleles are in a different order.
+        if((gt1->at(0) == gt2->at(2)) && (gt1->at(2) == gt2->at(0)))
+        {
+            return(true);
+        }
+    }
+    return(false);
+}
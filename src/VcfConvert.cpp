@@ -22,6 +22,8 @@
 #include "BgzfFileType.h"
 #include "VcfFileReader.h"
 #include "VcfFileWriter.h"
+#include "Profiler.h"
+#include "ProgressReporter.h"
 
 void VcfConvert::vcfConvertDescription()
 {
@@ -47,6 +49,9 @@ void VcfConvert::usage()
               << "\t\t--refName    : the reference (chromosome) name to read\n"
               << "\t\t               Defaults to all references.\n"
               << "\t\t--noeof      : do not expect an EOF block on a BGZF file\n"
+              << "\t\t--progress   : report the progress every this many seconds\n"
+              << "\t\t--statusFile : also write each progress report to this file as JSON,\n"
+              << "\t\t               reporting every 10 seconds if --progress is not set\n"
               << "\t\t--params     : print the parameter settings\n"
               << std::endl;
 }
@@ -62,6 +67,8 @@ int VcfConvert::execute(int argc, char **argv)
     bool uncompress = false;
     bool params = false;
     bool noeof = false;
+    int progressSecs = 0;
+    String statusFile = "";
     
     // Read in the parameters.    
     ParameterList inputParameters;
@@ -73,6 +80,8 @@ int VcfConvert::execute(int argc, char **argv)
         LONG_PARAMETER("uncompress", &uncompress)
         LONG_STRINGPARAMETER("refName", &refName)
         LONG_PARAMETER("noeof", &noeof)
+        LONG_INTPARAMETER("progress", &progressSecs)
+        LONG_STRINGPARAMETER("statusFile", &statusFile)
         LONG_PARAMETER("params", &params)
         LONG_PHONEHOME(VERSION)
         END_LONG_PARAMETERS();
@@ -98,6 +107,18 @@ int VcfConvert::execute(int argc, char **argv)
         return(-1);
     }
 
+    if(progressSecs < 0)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--progress must not be negative.\n\n";
+        return(-1);
+    }
+    if((progressSecs == 0) && !statusFile.IsEmpty())
+    {
+        progressSecs = ProgressReporter::DEFAULT_INTERVAL_SECS;
+    }
+
     if(params)
     {
         inputParameters.Status();
@@ -111,7 +132,7 @@ int VcfConvert::execute(int argc, char **argv)
         BgzfFileType::setRequireEofBlock(false);
     }
 
-    VcfFileReader inFile;
+    ProgressVcfFileReader inFile;
     VcfFileWriter outFile;
     VcfHeader header;
     
@@ -135,12 +156,21 @@ int VcfConvert::execute(int argc, char **argv)
     VcfRecord record;
     int numRecords = 0;
 
-    while(inFile.readRecord(record))
+    ProgressReporter progress("convert", inputVcf);
+    if((progressSecs > 0) && !progress.start(progressSecs, statusFile.c_str()))
+    {
+        std::cerr << "Failed to start the progress reporter thread, so not reporting progress\n";
+    }
+
+    while(PROFILE_CALL(PROFILE_READ, inFile.readRecord(record)))
     {
         ++numRecords;
+        progress.update(record);
+        progress.updateOffset(inFile.getInputFile());
 
-        outFile.writeRecord(record);
+        PROFILE_CALL(PROFILE_WRITE, outFile.writeRecord(record));
     }
+    progress.stop();
  
     inFile.close();   
 
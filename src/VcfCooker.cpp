@@ -22,6 +22,7 @@
 #include "Parameters.h"
 #include "BgzfFileType.h"
 #include "GenomeSequence.h"
+#include "ReferenceManager.h"
 #include "HyunVcfFile.h"
 #include "VcfFileReader.h"
 #include "VcfFileWriter.h"
@@ -32,7 +33,6 @@
 #include <vector>
 
 #include <time.h>
-Logger* Logger::gLogger = NULL;
 
 void VcfCooker::vcfCookerDescription()
 {
@@ -207,6 +207,8 @@ int VcfCooker::execute(int argc, char **argv)
      abort();
    }
    Logger::gLogger = new Logger((sOut+".log").c_str(), bVerbose);
+   // the per-marker d1/d2 warnings can repeat for every marker
+   Logger::gLogger->setMaxRepeats(Logger::DEFAULT_MAX_REPEATS);
 
    time_t t;
    time(&t);
@@ -288,20 +290,8 @@ int VcfCooker::execute(int argc, char **argv)
        // Open and write the header
        //TODO outFile.open(outFileName, header);
        
-       GenomeSequence genomeSequence;
-       genomeSequence.setReferenceName(sFasta.c_str());
-
-       genomeSequence.useMemoryMap(true);
-       
-       if ( genomeSequence.open() ) {
-	 // write a message that new index file is being created
-	 if ( genomeSequence.create(false) ) {
-	   throw HyunVcfFileException("Failed creating index file of the reference. Please check the file permission");
-	 }
-	 if ( genomeSequence.open() ) {
-	   throw HyunVcfFileException("Failed opening index file of the reference.");
-	 }
-       }
+       // the packed index of the reference is built once & shared by all jobs
+       const GenomeSequence& genomeSequence = ReferenceManager::getReference(sFasta.c_str());
        
        while(inFile.readRecord(record))
        {
@@ -860,5 +850,7 @@ int VcfCooker::execute(int argc, char **argv)
    time(&t);
    Logger::gLogger->writeLog("Analysis finished on %s", ctime(&t));
 
+   delete Logger::gLogger;
+   Logger::gLogger = NULL;
    return 0;
 }
@@ -0,0 +1,266 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+#include "VcfFixRef.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <string>
+
+#include "Parameters.h"
+#include "BgzfFileType.h"
+#include "GenomeSequence.h"
+#include "ReferenceManager.h"
+#include "ContigCache.h"
+#include "Profiler.h"
+
+void VcfFixRef::vcfFixRefDescription()
+{
+    std::cerr << " fixref - Replace the REF alleles with the reference bases, streaming the VCF lines" << std::endl;
+}
+
+
+void VcfFixRef::description()
+{
+    vcfFixRefDescription();
+}
+
+
+void VcfFixRef::usage()
+{
+    VcfExecutable::usage();
+    std::cerr << "\t./vcf fixref --refFile <referenceFilename> --in <input VCF File> --out <output VCF File> [--uncompress] [--params]"<< std::endl;
+    std::cerr << "\tRequired Parameters:\n"
+              << "\t\t--refFile : the reference file\n"
+              << "\t\t--in      : VCF file whose reference alleles should be replaced\n"
+              << "\t\t--out     : new VCF file with updated reference alleles\n"
+              << "\tOptional Parameters:\n"
+              << "\t\t--uncompress : write an uncompressed VCF output file\n"
+              << "\t\t--params     : print the parameter settings\n"
+              << "\tREF alleles of any length are replaced by the same number of\n"
+              << "\treference bases starting at POS; the rest of each line is\n"
+              << "\twritten as read.  Records on contigs that are not in the\n"
+              << "\treference or that extend past the contig end are unchanged.\n"
+              << "\tSorted input only looks up each contig once.\n"
+              << std::endl;
+}
+
+
+int VcfFixRef::execute(int argc, char **argv)
+{
+    String refFile = "";
+    String inputVcf = "";
+    String outputVcf = "";
+    bool uncompress = false;
+    bool params = false;
+
+    // Read in the parameters.
+    ParameterList inputParameters;
+    BEGIN_LONG_PARAMETERS(longParameterList)
+        LONG_STRINGPARAMETER("refFile", &refFile)
+        LONG_STRINGPARAMETER("in", &inputVcf)
+        LONG_STRINGPARAMETER("out", &outputVcf)
+        LONG_PARAMETER("uncompress", &uncompress)
+        LONG_PARAMETER("params", &params)
+        LONG_PHONEHOME(VERSION)
+        END_LONG_PARAMETERS();
+
+    inputParameters.Add(new LongParameters ("Input Parameters",
+                                            longParameterList));
+
+    inputParameters.Read(argc-1, &(argv[1]));
+
+    // Check that all files were specified.
+    if(refFile == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--refFile\", a required parameter.\n\n";
+        return(-1);
+    }
+    if(inputVcf == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--in\", a required parameter.\n\n";
+        return(-1);
+    }
+    if(outputVcf == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--out\", a required parameter.\n\n";
+        return(-1);
+    }
+
+    if(params)
+    {
+        inputParameters.Status();
+    }
+
+    // Open the reference, shared with other processes using it.
+    const GenomeSequence& reference = ReferenceManager::getReference(refFile);
+
+    IFILE inFile = ifopen(inputVcf, "r");
+    if(inFile == NULL)
+    {
+        std::cerr << "Failed to open " << inputVcf << "\n";
+        return(-1);
+    }
+    IFILE outFile = NULL;
+    if(uncompress)
+    {
+        outFile = ifopen(outputVcf, "w", InputFile::DEFAULT);
+    }
+    else
+    {
+        outFile = ifopen(outputVcf, "w", InputFile::BGZF);
+    }
+    if(outFile == NULL)
+    {
+        std::cerr << "Failed to open " << outputVcf << "\n";
+        ifclose(inFile);
+        return(-1);
+    }
+
+    ContigCache contig(reference);
+    std::set<std::string> missingContigs;
+
+    uint64_t numRecords = 0;
+    uint64_t numChanged = 0;
+    uint64_t numUnchanged = 0;
+    uint64_t numSkipped = 0;
+    std::string newRef = "";
+    String line = "";
+    while(!ifeof(inFile))
+    {
+        line.Clear();
+        if(PROFILE_CALL(PROFILE_READ, line.ReadLine(inFile)) < 0)
+        {
+            // Error/end of file, exit loop.
+            break;
+        }
+        if(line.IsEmpty())
+        {
+            continue;
+        }
+        line += '\n';
+        const char* lineStr = line.c_str();
+        int lineLen = line.Length();
+
+        // Headers are written as read.
+        if(lineStr[0] == '#')
+        {
+            ifwrite(outFile, lineStr, lineLen);
+            continue;
+        }
+        ++numRecords;
+
+        // Find the CHROM, POS, and REF columns, leaving the rest of the
+        // line untokenized.
+        const char* chromEnd = NULL;
+        const char* posEnd = NULL;
+        const char* idEnd = NULL;
+        const char* refEnd = NULL;
+        {
+            PROFILE_SCOPE(PROFILE_TOKENIZE);
+            chromEnd = (const char*)memchr(lineStr, '\t', lineLen);
+            if(chromEnd != NULL)
+            {
+                posEnd = (const char*)memchr(chromEnd + 1, '\t',
+                                             lineStr + lineLen - chromEnd - 1);
+            }
+            if(posEnd != NULL)
+            {
+                idEnd = (const char*)memchr(posEnd + 1, '\t',
+                                            lineStr + lineLen - posEnd - 1);
+            }
+            if(idEnd != NULL)
+            {
+                refEnd = (const char*)memchr(idEnd + 1, '\t',
+                                             lineStr + lineLen - idEnd - 1);
+            }
+        }
+        if(refEnd == NULL)
+        {
+            std::cerr << "Record " << numRecords
+                      << " has fewer than 5 columns, so it is written unchanged\n";
+            ++numSkipped;
+            ifwrite(outFile, lineStr, lineLen);
+            continue;
+        }
+
+        const char* refStart = idEnd + 1;
+        unsigned int refLen = refEnd - refStart;
+        char* numEnd = NULL;
+        unsigned long pos = strtoul(chromEnd + 1, &numEnd, 10);
+
+        if(!contig.setContig(lineStr, chromEnd - lineStr))
+        {
+            if(missingContigs.insert(contig.getContig()).second)
+            {
+                std::cerr << "Contig " << contig.getContig()
+                          << " is not in the reference, so its records are "
+                          << "written unchanged\n";
+            }
+            ++numSkipped;
+            ifwrite(outFile, lineStr, lineLen);
+            continue;
+        }
+        if((numEnd != posEnd) || (refLen == 0) || !contig.contains(pos, refLen))
+        {
+            ++numSkipped;
+            ifwrite(outFile, lineStr, lineLen);
+            continue;
+        }
+
+        // Read as many reference bases as are in the REF allele.
+        newRef.resize(refLen);
+        {
+            PROFILE_SCOPE(PROFILE_REFERENCE);
+            for(unsigned int i = 0; i < refLen; i++)
+            {
+                newRef[i] = contig.getBase(pos + i);
+            }
+        }
+        if(newRef.compare(0, refLen, refStart, refLen) == 0)
+        {
+            ++numUnchanged;
+            ifwrite(outFile, lineStr, lineLen);
+            continue;
+        }
+        ++numChanged;
+
+        // Splice the new REF between the unchanged columns.
+        PROFILE_SCOPE(PROFILE_WRITE);
+        ifwrite(outFile, lineStr, refStart - lineStr);
+        ifwrite(outFile, newRef.data(), refLen);
+        ifwrite(outFile, refEnd, lineStr + lineLen - refEnd);
+    }
+
+    ifclose(inFile);
+    ifclose(outFile);
+
+    std::cerr << "Records: " << numRecords
+              << ", REF changed: " << numChanged
+              << ", REF already matched: " << numUnchanged
+              << ", skipped: " << numSkipped << "\n";
+    return(0);
+}
@@ -18,11 +18,511 @@
 //////////////////////////////////////////////////////////////////////////
 #include "VcfMac.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
 #include "Parameters.h"
 #include "BgzfFileType.h"
 #include "VcfFileReader.h"
 #include "VcfFileWriter.h"
-#include "IntervalTree.h"
+#include "RegionFilter.h"
+#include "AlleleCounter.h"
+#include "VcfBatchReader.h"
+#include "WorkerPool.h"
+#include "Profiler.h"
+#include "ProgressReporter.h"
+#include "MacBinaryFile.h"
+
+// Regions closer together than this are read as 1 section with --useIndex.
+static const int SECTION_GAP = 10000;
+
+// With --threads, record lines are counted in blocks of this many lines,
+// with this many blocks per thread read at a time.
+static const int LINES_PER_BLOCK = 64;
+static const int BLOCKS_PER_THREAD = 4;
+
+// With --threads & a --sampleSubset or --useIndex, records are read in
+// batches of this many records per thread, and this many batches are in
+// use at once (being read, counted, or waiting to be counted).
+static const int BATCH_RECORDS_PER_THREAD = 64;
+static const int NUM_BATCHES = 3;
+
+// Number of columns from CHROM through INFO.
+static const int NUM_SITE_COLUMNS = 8;
+
+// MAC/MAF results of 1 record.
+struct MacResult
+{
+    // False if the record has no called alleles or fails --minAC.
+    bool keep;
+    int minAlleleCount;
+    int totalAlleleCount;
+    // Formatted output line when writing text.
+    std::string line;
+    // Site of the record when writing the binary table.
+    std::string chrom;
+    int pos;
+    std::string id;
+};
+
+
+// Apply the minor allele count rule to the counts of the result, then
+// format the output line for the record's ID if formatLine is set.
+static void keepMac(const char* id, int idLen, int minAC, bool formatLine,
+                    MacResult& result)
+{
+    // Apply the minor allele count rule, using the counts
+    // already calculated for the output.
+    if((minAC >= 0) && (result.minAlleleCount < minAC))
+    {
+        return;
+    }
+
+    if(result.totalAlleleCount != 0)
+    {
+        result.keep = true;
+        if(formatLine)
+        {
+            PROFILE_SCOPE(PROFILE_FORMAT);
+            // %g matches the default ostream formatting of the MAF.
+            char counts[64];
+            double maf = (double)result.minAlleleCount/result.totalAlleleCount;
+            snprintf(counts, sizeof(counts), "\t%d\t%g\n", result.minAlleleCount, maf);
+            result.line.assign(id, idLen);
+            result.line += counts;
+        }
+    }
+}
+
+
+// Count the alleles of the record, formatting its output line if
+// formatLine is set.
+static void countMac(VcfRecord& record, AlleleCounter& alleleCounter,
+                     int minAC, bool formatLine, MacResult& result)
+{
+    result.keep = false;
+    result.line.clear();
+
+    {
+        PROFILE_SCOPE(PROFILE_PARSE_SAMPLES);
+        result.totalAlleleCount = alleleCounter.count(record);
+        result.minAlleleCount = alleleCounter.getMinCount();
+    }
+    if(!formatLine)
+    {
+        result.chrom = record.getChromStr();
+        result.pos = record.get1BasedPosition();
+        result.id = record.getIDStr();
+    }
+    const char* id = record.getIDStr();
+    keepMac(id, strlen(id), minAC, formatLine, result);
+}
+
+
+// Find the end of the column that starts at col: the next tab or lineEnd.
+static inline const char* columnEnd(const char* col, const char* lineEnd)
+{
+    const char* end = (const char*)memchr(col, '\t', lineEnd - col);
+    return((end == NULL) ? lineEnd : end);
+}
+
+
+// Count the alleles of a record line (without the '\n') as countMac does,
+// scanning the GT subfield of each sample in place rather than parsing
+// the record.  Returns false if the line has too few columns.
+static bool countMacLine(const std::string& record,
+                         AlleleCounter& alleleCounter, int minAC,
+                         bool formatLine, MacResult& result)
+{
+    result.keep = false;
+    result.line.clear();
+    result.totalAlleleCount = 0;
+    result.minAlleleCount = 0;
+
+    const char* line = record.c_str();
+    const char* lineEnd = line + record.size();
+
+    // Find the start of each site column.
+    const char* columns[NUM_SITE_COLUMNS + 1];
+    columns[0] = line;
+    for(int c = 1; c <= NUM_SITE_COLUMNS; c++)
+    {
+        const char* tab = columnEnd(columns[c - 1], lineEnd);
+        if(tab == lineEnd)
+        {
+            if(c < NUM_SITE_COLUMNS)
+            {
+                // Too few columns.
+                return(false);
+            }
+            // No FORMAT, so no samples.
+            columns[c] = lineEnd;
+            break;
+        }
+        columns[c] = tab + 1;
+    }
+    const char* id = columns[2];
+    int idLen = columns[3] - id - 1;
+    if(!formatLine)
+    {
+        result.chrom.assign(line, columns[1] - line - 1);
+        result.pos = atoi(columns[1]);
+        result.id.assign(id, idLen);
+    }
+
+    // Each ',' in ALT separates another alt; "." is no alts.
+    const char* alt = columns[4];
+    const char* altEnd = columns[5] - 1;
+    int numAlleles = 1;
+    if((altEnd - alt != 1) || (*alt != '.'))
+    {
+        numAlleles = 2 + std::count(alt, altEnd, ',');
+    }
+
+    {
+        PROFILE_SCOPE(PROFILE_PARSE_SAMPLES);
+        alleleCounter.reset(numAlleles);
+        const char* formatStart = columns[NUM_SITE_COLUMNS];
+        const char* formatEnd = columnEnd(formatStart, lineEnd);
+
+        // Find which subfield is GT.
+        int gtIndex = 0;
+        const char* key = formatStart;
+        while(true)
+        {
+            const char* keyEnd = (const char*)memchr(key, ':', formatEnd - key);
+            if(keyEnd == NULL)
+            {
+                keyEnd = formatEnd;
+            }
+            if((keyEnd - key == 2) && (key[0] == 'G') && (key[1] == 'T'))
+            {
+                break;
+            }
+            if(keyEnd == formatEnd)
+            {
+                // No GT, so nothing is called.
+                gtIndex = -1;
+                break;
+            }
+            key = keyEnd + 1;
+            ++gtIndex;
+        }
+
+        // Each sample starts after the tab at sampleTab.
+        const char* sampleTab = (gtIndex < 0) ? lineEnd : formatEnd;
+        while(sampleTab != lineEnd)
+        {
+            // Skip to the GT subfield, which is missing if the sample's
+            // subfields end first.
+            const char* gt = sampleTab + 1;
+            int subfield = 0;
+            while((subfield < gtIndex) && (gt != lineEnd) && (*gt != '\t'))
+            {
+                if(*gt == ':')
+                {
+                    ++subfield;
+                }
+                ++gt;
+            }
+            const char* gtEnd = gt;
+            while((gtEnd != lineEnd) && (*gtEnd != ':') && (*gtEnd != '\t'))
+            {
+                ++gtEnd;
+            }
+            if(subfield == gtIndex)
+            {
+                alleleCounter.add(gt, gtEnd - gt);
+            }
+            sampleTab = columnEnd(gtEnd, lineEnd);
+        }
+        result.totalAlleleCount = alleleCounter.getTotal();
+        result.minAlleleCount = alleleCounter.getMinCount();
+    }
+
+    keepMac(id, idLen, minAC, formatLine, result);
+    return(true);
+}
+
+
+// Write the result of a record as text to textOut (cout if it is NULL)
+// or to the binary file.
+static void writeMac(const MacResult& result, IFILE textOut,
+                     MacBinaryWriter* binOut)
+{
+    if(!result.keep)
+    {
+        return;
+    }
+    PROFILE_SCOPE(PROFILE_WRITE);
+    if(binOut != NULL)
+    {
+        binOut->add(result.chrom.c_str(), result.pos, result.id.c_str(),
+                    result.minAlleleCount, result.totalAlleleCount);
+    }
+    else if(textOut != NULL)
+    {
+        ifwrite(textOut, result.line.data(), result.line.size());
+    }
+    else
+    {
+        std::cout.write(result.line.data(), result.line.size());
+    }
+}
+
+
+// Counts the alleles and formats the output of the records of a batch,
+// 1 record per block.
+class MacCountTask : public WorkerTask
+{
+public:
+    MacCountTask(int numThreads, int batchSize, int minAC, bool formatLines)
+        : results(batchSize),
+          myCounters(numThreads),
+          myMinAC(minAC),
+          myFormatLines(formatLines),
+          myBatch(NULL)
+    {
+    }
+
+    void setBatch(VcfRecordBatch* batch) { myBatch = batch; }
+
+    virtual void runBlock(int blockIndex, int threadIndex)
+    {
+        countMac(*(myBatch->records[blockIndex]), myCounters[threadIndex],
+                 myMinAC, myFormatLines, results[blockIndex]);
+    }
+
+    // Results of each record of the batch.
+    std::vector<MacResult> results;
+
+private:
+    // Counters for each thread.
+    std::vector<AlleleCounter> myCounters;
+    int myMinAC;
+    bool myFormatLines;
+    VcfRecordBatch* myBatch;
+};
+
+
+// Count the records with the specified number of threads, writing the
+// output in the order the records were read.
+static void countThreaded(VcfBatchReader& reader, int batchSize, int minAC,
+                          int numThreads, IFILE textOut,
+                          MacBinaryWriter* binOut, ProgressReporter& progress)
+{
+    // Records are read in batches on a separate thread while the
+    // previous batch is counted by the workers and then written in order.
+    WorkerPool workers(numThreads);
+    MacCountTask countTask(numThreads, batchSize, minAC, binOut == NULL);
+
+    if(!reader.start())
+    {
+        std::cerr << "Failed to create the reader thread, so reading on the main thread\n";
+    }
+    VcfRecordBatch* batch = NULL;
+    while((batch = reader.next()) != NULL)
+    {
+        countTask.setBatch(batch);
+        workers.run(countTask, batch->numRecords);
+        for(int r = 0; r < batch->numRecords; r++)
+        {
+            progress.update(*(batch->records[r]));
+            writeMac(countTask.results[r], textOut, binOut);
+        }
+        reader.release(batch);
+    }
+}
+
+
+// Counts the alleles and formats the output of a chunk of record lines,
+// LINES_PER_BLOCK per block, straight from the line text.
+class MacLineTask : public WorkerTask
+{
+public:
+    MacLineTask(int numThreads, int chunkSize, int minAC, bool formatLines)
+        : results(chunkSize),
+          valid(chunkSize),
+          myCounters(numThreads),
+          myMinAC(minAC),
+          myFormatLines(formatLines),
+          myLines(NULL),
+          myNumLines(0)
+    {
+    }
+
+    void setChunk(const std::vector<std::string>& lines, int numLines)
+    {
+        myLines = &lines;
+        myNumLines = numLines;
+    }
+
+    virtual void runBlock(int blockIndex, int threadIndex)
+    {
+        int end = (blockIndex + 1) * LINES_PER_BLOCK;
+        if(end > myNumLines)
+        {
+            end = myNumLines;
+        }
+        PROFILE_ITEMS(PROFILE_PARSE_SAMPLES, end - blockIndex * LINES_PER_BLOCK);
+        for(int r = blockIndex * LINES_PER_BLOCK; r < end; r++)
+        {
+            valid[r] = countMacLine((*myLines)[r], myCounters[threadIndex],
+                                    myMinAC, myFormatLines, results[r]);
+        }
+    }
+
+    // Results of each line of the chunk.
+    std::vector<MacResult> results;
+    // Whether each line had enough columns to count (not vector<bool>,
+    // since threads set neighboring entries).
+    std::vector<char> valid;
+
+private:
+    // Counters for each thread.
+    std::vector<AlleleCounter> myCounters;
+    int myMinAC;
+    bool myFormatLines;
+    const std::vector<std::string>* myLines;
+    int myNumLines;
+};
+
+
+// Count the record lines of inFile with the specified number of threads,
+// only counting the lines in regions if it is not NULL.  Chunks of lines
+// are read on this thread and counted straight from the line text by the
+// workers, then written in read order.
+static void countLines(IFILE inFile, RegionFilter* regions, int minAC,
+                       int numThreads, IFILE textOut,
+                       MacBinaryWriter* binOut, ProgressReporter& progress)
+{
+    WorkerPool workers(numThreads);
+    std::vector<std::string> chunk(numThreads * BLOCKS_PER_THREAD *
+                                   LINES_PER_BLOCK);
+    MacLineTask countTask(numThreads, chunk.size(), minAC, binOut == NULL);
+    String line = "";
+    std::string chrom;
+    bool moreLines = true;
+    while(moreLines)
+    {
+        int numLines = 0;
+        while((numLines < (int)chunk.size()) && !ifeof(inFile))
+        {
+            line.Clear();
+            if(PROFILE_CALL(PROFILE_READ, line.ReadLine(inFile)) < 0)
+            {
+                // Error/end of file, exit loop.
+                break;
+            }
+            progress.updateOffset(inFile);
+            int len = line.Length();
+            if((len > 0) && (line[len - 1] == '\r'))
+            {
+                // Count CRLF lines as if they were LF lines.
+                --len;
+            }
+            if((len == 0) || (line[0] == '#'))
+            {
+                // Skip the headers.
+                continue;
+            }
+            if(regions != NULL)
+            {
+                PROFILE_SCOPE(PROFILE_FILTER);
+                const char* chromEnd = (const char*)memchr(line.c_str(), '\t', len);
+                if(chromEnd != NULL)
+                {
+                    chrom.assign(line.c_str(), chromEnd - line.c_str());
+                    if(!regions->contains(chrom.c_str(), atoi(chromEnd + 1)))
+                    {
+                        // not in the interval, so continue to the next record.
+                        continue;
+                    }
+                }
+            }
+            chunk[numLines++].assign(line.c_str(), len);
+        }
+        moreLines = (numLines == (int)chunk.size());
+
+        countTask.setChunk(chunk, numLines);
+        workers.run(countTask,
+                    (numLines + LINES_PER_BLOCK - 1) / LINES_PER_BLOCK);
+        for(int r = 0; r < numLines; r++)
+        {
+            progress.update(chunk[r].c_str());
+            if(!countTask.valid[r])
+            {
+                std::cerr << "Skipping a record with fewer than "
+                          << NUM_SITE_COLUMNS << " columns\n";
+                continue;
+            }
+            writeMac(countTask.results[r], textOut, binOut);
+        }
+    }
+}
+
+
+// Finish the text or binary output file if there is one, returning the
+// exit status.
+static int closeOutput(IFILE textOut, const String& outputFile,
+                       MacBinaryWriter* binOut, const String& binOutFile)
+{
+    if((textOut != NULL) && (ifclose(textOut) != 0))
+    {
+        std::cerr << "Failed writing " << outputFile << "\n";
+        return(-1);
+    }
+    if((binOut != NULL) && !binOut->close())
+    {
+        std::cerr << "Failed writing " << binOutFile << "\n";
+        return(-1);
+    }
+    return(0);
+}
+
+// Print a binary table written by --binOut as the text output to textOut
+// (cout if it is NULL), returning the exit status.
+static int printBinIn(const String& binInFile, IFILE textOut)
+{
+    MacBinaryReader binIn;
+    if(!binIn.open(binInFile))
+    {
+        std::cerr << "Failed to read " << binInFile
+                  << ", it is not a mac binary table\n";
+        return(-1);
+    }
+    char counts[64];
+    std::string line;
+    for(uint64_t i = 0; i < binIn.getNumRecords(); i++)
+    {
+        const MacBinaryRecord& record = binIn.getRecord(i);
+        const char* id = binIn.getID(record);
+        if((id == NULL) || (binIn.getContig(record.contig) == NULL) ||
+           (record.an == 0))
+        {
+            std::cerr << "Invalid record " << i << " in " << binInFile << "\n";
+            return(-1);
+        }
+        // Recalculate the MAF as the text output does rather than
+        // printing the float.
+        snprintf(counts, sizeof(counts), "\t%u\t%g\n", record.minAC,
+                 (double)record.minAC/record.an);
+        line = id;
+        line += counts;
+        if(textOut != NULL)
+        {
+            ifwrite(textOut, line.data(), line.size());
+        }
+        else
+        {
+            std::cout.write(line.data(), line.size());
+        }
+    }
+    return(0);
+}
+
 
 void VcfMac::vcfMacDescription()
 {
@@ -39,15 +539,34 @@ void VcfMac::description()
 void VcfMac::usage()
 {
     VcfExecutable::usage();
-    std::cerr << "\t./vcfUtil mac --in1 <input VCF File> [--params]"<< std::endl;
+    std::cerr << "\t./vcfUtil mac --in1 <input VCF File> [--threads <num>] [--params]"<< std::endl;
     std::cerr << "\tRequired Parameters:\n"
               << "\t\t--in      : VCF file to analyze\n"
               << "\tOptional Parameters:\n"
               << "\t\t--sampleSubset : file with samples IDs to keep.\n"
-              << "\t\t--minAC        : min minor allele count to keep\n"
+              << "\t\t--minAC        : min minor allele count to keep, where the minor allele\n"
+              << "\t\t                 count is the smallest count of any allele, including REF\n"
               << "\t\t--filterList   : filename of file containing regions to include,\n"
               << "\t\t                 format: start end\n"
-              << "\t\t                 start & end positions should be 1-based inclusive positions.\n"
+              << "\t\t                 start & end positions should be 1-based inclusive positions,\n"
+              << "\t\t                 and apply to all chromosomes.\n"
+              << "\t\t                 or BED format: chrom start end\n"
+              << "\t\t                 start is 0-based, end is 1-based (exclusive)\n"
+              << "\t\t--useIndex     : only read the --filterList regions using the VCF's tabix\n"
+              << "\t\t                 index rather than scanning the whole file.  Requires BED\n"
+              << "\t\t                 regions; chromosomes are output in --filterList order.\n"
+              << "\t\t--threads      : number of threads for counting, which count straight\n"
+              << "\t\t                 from the record lines unless --sampleSubset or\n"
+              << "\t\t                 --useIndex is set (default 1)\n"
+              << "\t\t--out          : write the text output to this file rather than stdout\n"
+              << "\t\t--binOut       : write a binary table of the results to this file rather\n"
+              << "\t\t                 than text to stdout: fixed width records of contig id,\n"
+              << "\t\t                 position, minAC, AN, & MAF plus the contig & ID strings,\n"
+              << "\t\t                 read with MacBinaryReader\n"
+              << "\t\t--binIn        : print a --binOut table as text rather than reading --in\n"
+              << "\t\t--progress     : report the progress every this many seconds\n"
+              << "\t\t--statusFile   : also write each progress report to this file as JSON,\n"
+              << "\t\t                 reporting every 10 seconds if --progress is not set\n"
               << "\t\t--params     : print the parameter settings\n"
               << std::endl;
 }
@@ -60,10 +579,16 @@ int VcfMac::execute(int argc, char **argv)
     int minAC = -1;
     String sampleSubset = "";
     String filterList = "";
+    String outputFile = "";
+    String binOutFile = "";
+    String binInFile = "";
     bool params = false;
+    int numThreads = 1;
+    int progressSecs = 0;
+    String statusFile = "";
 
-    IntervalTree<int> regions;
-    std::vector<int> intersection;
+    bool useIndex = false;
+    RegionFilter regions;
     
     // Read in the parameters.    
     ParameterList inputParameters;
@@ -74,6 +599,13 @@ int VcfMac::execute(int argc, char **argv)
         LONG_STRINGPARAMETER("sampleSubset", &sampleSubset)
         LONG_INTPARAMETER("minAC", &minAC)
         LONG_STRINGPARAMETER("filterList", &filterList)
+        LONG_PARAMETER("useIndex", &useIndex)
+        LONG_INTPARAMETER("threads", &numThreads)
+        LONG_STRINGPARAMETER("out", &outputFile)
+        LONG_STRINGPARAMETER("binOut", &binOutFile)
+        LONG_STRINGPARAMETER("binIn", &binInFile)
+        LONG_INTPARAMETER("progress", &progressSecs)
+        LONG_STRINGPARAMETER("statusFile", &statusFile)
         LONG_PARAMETER("params", &params)
         LONG_PHONEHOME(VERSION)
         END_LONG_PARAMETERS();
@@ -84,7 +616,7 @@ int VcfMac::execute(int argc, char **argv)
     inputParameters.Read(argc-1, &(argv[1]));
     
     // Check that all files were specified.
-    if(inputVcf == "")
+    if((inputVcf == "") && (binInFile == ""))
     {
         usage();
         inputParameters.Status();
@@ -92,140 +624,199 @@ int VcfMac::execute(int argc, char **argv)
         return(-1);
     }
 
-    if(params)
+    if((inputVcf != "") && (binInFile != ""))
     {
+        usage();
         inputParameters.Status();
+        std::cerr << "Only one of \"--in\" and \"--binIn\" may be specified.\n\n";
+        return(-1);
     }
 
-    // Open the two input files.
-    VcfFileReader inFile;
-    VcfHeader header;
-    VcfRecord record;
+    if((outputFile != "") && (binOutFile != ""))
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Only one of \"--out\" and \"--binOut\" may be specified.\n\n";
+        return(-1);
+    }
+    if((binInFile != "") && (binOutFile != ""))
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "\"--binIn\" only prints text, so \"--binOut\" may not be specified.\n\n";
+        return(-1);
+    }
 
-    // Open the file
-    if(sampleSubset.IsEmpty())
+    if(numThreads < 1)
     {
-        inFile.open(inputVcf, header);        
+        usage();
+        inputParameters.Status();
+        std::cerr << "--threads must be at least 1.\n\n";
+        return(-1);
     }
-    else
+    if(progressSecs < 0)
     {
-        inFile.open(inputVcf, header, sampleSubset, NULL, NULL);
+        usage();
+        inputParameters.Status();
+        std::cerr << "--progress must not be negative.\n\n";
+        return(-1);
     }
-    
-    // Add the discard rule for minor allele count.
-    if(minAC >= 0)
+    if((progressSecs == 0) && !statusFile.IsEmpty())
     {
-        inFile.addDiscardMinMinorAlleleCount(minAC, NULL);
+        progressSecs = ProgressReporter::DEFAULT_INTERVAL_SECS;
     }
-    
-    if(!filterList.IsEmpty())
+
+    if(params)
     {
-        // Open the filter list.
-        IFILE regionFile = ifopen(filterList, "r");
-        String regionLine;
-        StringArray regionColumn;
-        int start;
-        int end;
-        int intervalVal = 1;
-        if(regionFile == NULL)
+        inputParameters.Status();
+    }
+
+    // Open the text or binary output file if there is one.
+    IFILE textOut = NULL;
+    if(!outputFile.IsEmpty())
+    {
+        textOut = ifopen(outputFile, "w");
+        if(textOut == NULL)
         {
-            std::cerr << "Failed to open " << filterList 
-                      << ", so keeping all positions\n";
-            filterList.Clear();
+            std::cerr << "Failed to open " << outputFile << "\n";
+            return(-1);
         }
-        else
+    }
+    MacBinaryWriter binWriter;
+    MacBinaryWriter* binOut = NULL;
+    if(!binOutFile.IsEmpty())
+    {
+        if(!binWriter.open(binOutFile))
         {
-            while( regionFile->isOpen() && !regionFile->ifeof())
-            {
-                // Read the next interval
-                regionLine.Clear();
-                regionLine.ReadLine(regionFile);
-                if(regionLine.IsEmpty())
-                {
-                    // Nothing on this line, continue to the next.
-                    continue;
-                }
-                regionColumn.ReplaceColumns(regionLine, ' ');
-                if(regionColumn.Length() != 2)
-                {
-                    std::cerr << "Improperly formatted region line: " 
-                              << regionLine << "; skipping to the next line.\n";
-                    continue;
-                }
-                // Convert the columns to integers.
-                if(!regionColumn[0].AsInteger(start))
-                {
-                    // The start position (1st column) is not an integer.
-                    std::cerr << "Improperly formatted region line, start position "
-                              << "(1st column) is not an integer: "
-                              << regionColumn[0]
-                              << "; Skipping to the next line.\n";
-                    continue;
-                }
-                if(!regionColumn[1].AsInteger(end))
-                {
-                    // The start position (1st column) is not an integer.
-                    std::cerr << "Improperly formatted region line, end position "
-                              << "(2nd column) is not an integer: "
-                              << regionColumn[1]
-                              << "; Skipping to the next line.\n";
-                    continue;
-                }
-                // Add 1-based inclusive intervals.
-                regions.add(start,end, intervalVal);
-            }
+            std::cerr << "Failed to open " << binOutFile << "\n";
+            return(-1);
         }
+        binOut = &binWriter;
     }
 
+    if(binInFile != "")
+    {
+        int returnVal = printBinIn(binInFile, textOut);
+        if(closeOutput(textOut, outputFile, NULL, binOutFile) != 0)
+        {
+            returnVal = -1;
+        }
+        return(returnVal);
+    }
 
-    int numReadRecords = 0;
+    if(!filterList.IsEmpty() && !regions.load(filterList))
+    {
+        std::cerr << "Failed to open " << filterList 
+                  << ", so keeping all positions\n";
+        filterList.Clear();
+    }
+    if(filterList.IsEmpty())
+    {
+        useIndex = false;
+    }
+    else if(useIndex && regions.hasAllChromRegions())
+    {
+        std::cerr << "--useIndex requires a chromosome column in every --filterList line\n";
+        ifclose(textOut);
+        return(-1);
+    }
+
+    ProgressReporter progress("mac", inputVcf);
 
-    while( inFile.readRecord(record))
+    if((numThreads > 1) && sampleSubset.IsEmpty() && !useIndex)
     {
-        if(!filterList.IsEmpty())
+        // All samples of every record are counted, so the workers count
+        // straight from the record lines.
+        IFILE lineFile = ifopen(inputVcf, "r");
+        if(lineFile == NULL)
         {
-            // Check if the region should be kept.
-            intersection.clear();
-            regions.get_intersecting_intervals(record.get1BasedPosition(), intersection);
-            
-            if(intersection.empty())
-            {
-                // not in the interval, so continue to the next record.
-                continue;
-            }
+            std::cerr << "Failed to open " << inputVcf << "\n";
+            ifclose(textOut);
+            return(-1);
+        }
+        if((progressSecs > 0) && !progress.start(progressSecs, statusFile.c_str()))
+        {
+            std::cerr << "Failed to start the progress reporter thread, so not reporting progress\n";
         }
+        countLines(lineFile, filterList.IsEmpty() ? NULL : &regions, minAC,
+                   numThreads, textOut, binOut, progress);
+        progress.stop();
+        ifclose(lineFile);
+        return(closeOutput(textOut, outputFile, binOut, binOutFile));
+    }
 
-        ++numReadRecords;
+    // Open the input file.
+    ProgressVcfFileReader inFile;
+    VcfHeader header;
+    VcfRecord record;
 
-        // Loop through the number of possible alternates.
-        unsigned int numAlts = record.getNumAlts();
-        int minAlleleCount = -1;
-        int curAlleleCount = 0;
-        int totalAlleleCount = 0;
-        for(unsigned int i = 0; i <= numAlts; i++)
+    // Open the file
+    if(sampleSubset.IsEmpty())
+    {
+        inFile.open(inputVcf, header);        
+    }
+    else
+    {
+        inFile.open(inputVcf, header, sampleSubset, NULL, NULL);
+    }
+
+    // Sections to read if only reading the regions.
+    std::vector<RegionFilter::Section> sections;
+    if(useIndex)
+    {
+        if(!inFile.readVcfIndex())
         {
-            curAlleleCount = record.getAlleleCount(i);
-            if((minAlleleCount == -1) ||
-               (curAlleleCount < minAlleleCount))
-            {
-                minAlleleCount = curAlleleCount;
-            }
-            totalAlleleCount += curAlleleCount;
+            std::cerr << "Failed to read the index for " << inputVcf << "\n";
+            ifclose(textOut);
+            return(-1);
         }
-        if(totalAlleleCount != 0)
+        regions.getSections(SECTION_GAP, sections);
+    }
+
+    // Batches are only used when counting on multiple threads.
+    int batchSize = (numThreads > 1) ? (BATCH_RECORDS_PER_THREAD * numThreads) : 0;
+    VcfBatchReader reader(inFile, batchSize, (numThreads > 1) ? NUM_BATCHES : 0);
+    reader.setRegions(filterList.IsEmpty() ? NULL : &regions,
+                      useIndex ? &sections : NULL);
+
+    if((progressSecs > 0) && !progress.start(progressSecs, statusFile.c_str()))
+    {
+        std::cerr << "Failed to start the progress reporter thread, so not reporting progress\n";
+    }
+    reader.setProgress(&progress, inFile.getInputFile());
+
+    if(numThreads > 1)
+    {
+        countThreaded(reader, batchSize, minAC, numThreads, textOut, binOut,
+                      progress);
+        progress.stop();
+        inFile.close();
+        return(closeOutput(textOut, outputFile, binOut, binOutFile));
+    }
+
+    int numReadRecords = 0;
+
+    // Counts all of the alleles of a record with 1 pass over its GTs.
+    AlleleCounter alleleCounter;
+    MacResult result;
+
+    while(reader.readRecord(record))
+    {
+        progress.update(record);
+        countMac(record, alleleCounter, minAC, binOut == NULL, result);
+        if(result.keep)
         {
-            double maf = (double)minAlleleCount/totalAlleleCount;
-            std::cout << record.getIDStr()
-                      << "\t" << minAlleleCount
-                      << "\t" << maf << "\n";
+            ++numReadRecords;
+            writeMac(result, textOut, binOut);
         }
     }
+    progress.stop();
     
     inFile.close();
 
     //    std::cerr << "\n\t# Records: " << numReadRecords << "\n";
 
-    // return success.
-    return(0);
+    return(closeOutput(textOut, outputFile, binOut, binOutFile));
 }
 
+
@@ -0,0 +1,399 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <string.h>
+
+#include "VcfMergeReader.h"
+#include "Profiler.h"
+
+VcfMergeReader::VcfMergeReader()
+    : myInputs(),
+      myHeap(),
+      myLastGroup(),
+      myContigIds(),
+      myContigNames(),
+      myStarted(false),
+      myFirstInputDriven(false),
+      mySeekGap(0)
+{
+}
+
+
+VcfMergeReader::~VcfMergeReader()
+{
+    close();
+}
+
+
+int VcfMergeReader::open(const char* filename)
+{
+    MergeInput* input = new MergeInput();
+    input->fileName = filename;
+    input->record = new VcfRecord();
+    input->subset = NULL;
+    input->contigId = -1;
+    input->key = 0;
+    input->eof = false;
+    input->indexed = false;
+    input->seekContigId = -1;
+    input->bySection = false;
+    input->sectionRank = -1;
+    input->reportedOrder = false;
+
+    if(!input->reader.open(filename, input->header))
+    {
+        delete input->record;
+        delete input;
+        return(-1);
+    }
+    addHeaderContigs(*input);
+    myInputs.push_back(input);
+    return(myInputs.size() - 1);
+}
+
+
+void VcfMergeReader::setSampleSubset(int inputIndex, VcfSubsetSamples* subset)
+{
+    myInputs[inputIndex]->subset = subset;
+}
+
+
+bool VcfMergeReader::readIndex(int inputIndex)
+{
+    MergeInput& input = *(myInputs[inputIndex]);
+    input.indexed = input.reader.readVcfIndex();
+    return(input.indexed);
+}
+
+
+void VcfMergeReader::setFirstInputDriven(int seekGap)
+{
+    myFirstInputDriven = true;
+    mySeekGap = seekGap;
+}
+
+
+bool VcfMergeReader::readMergedRecords(std::vector<bool>& present)
+{
+    if(!myStarted)
+    {
+        for(unsigned int i = 0; i < myInputs.size(); i++)
+        {
+            // Check if the input's chromosomes are in rank order.
+            MergeInput& input = *(myInputs[i]);
+            for(unsigned int c = 1; c < input.headerRanks.size(); c++)
+            {
+                if(input.headerRanks[c] < input.headerRanks[c - 1])
+                {
+                    if(input.indexed)
+                    {
+                        input.bySection = true;
+                    }
+                    else
+                    {
+                        std::cerr << "The ##contig lines of " << input.fileName
+                                  << " are in a different order than " << myInputs[0]->fileName
+                                  << ", so positions may be skipped unless it is indexed\n";
+                        input.reportedOrder = true;
+                    }
+                    break;
+                }
+            }
+            // Read the first record from each input.
+            if(input.bySection && !nextSection(input))
+            {
+                input.eof = true;
+            }
+            advance(i);
+        }
+        myStarted = true;
+    }
+    else
+    {
+        // Move past the records that were returned by the previous call.
+        for(unsigned int i = 0; i < myLastGroup.size(); i++)
+        {
+            advance(myLastGroup[i]);
+        }
+    }
+    myLastGroup.clear();
+
+    present.assign(myInputs.size(), false);
+    if(myFirstInputDriven && (mySeekGap >= 0))
+    {
+        seekToFirstInput();
+    }
+    if(myFirstInputDriven && myInputs[0]->eof)
+    {
+        // Only positions in the first input are needed.
+        return(false);
+    }
+    if(myHeap.empty())
+    {
+        // All inputs have been read.
+        return(false);
+    }
+
+    // Pop every input that is at the smallest chromosome/position.
+    uint64_t key = myHeap.front().key;
+    while(!myHeap.empty() && (myHeap.front().key == key))
+    {
+        int inputIndex = myHeap.front().inputIndex;
+        std::pop_heap(myHeap.begin(), myHeap.end(), HeapEntryGreater());
+        myHeap.pop_back();
+        present[inputIndex] = true;
+        myLastGroup.push_back(inputIndex);
+    }
+    return(true);
+}
+
+
+const char* VcfMergeReader::getChromStr()
+{
+    if(myLastGroup.empty())
+    {
+        return(NULL);
+    }
+    return(myInputs[myLastGroup[0]]->chrom.c_str());
+}
+
+
+int VcfMergeReader::get1BasedPosition()
+{
+    if(myLastGroup.empty())
+    {
+        return(-1);
+    }
+    // The position is the lower bits of the key.
+    return((int)(myInputs[myLastGroup[0]]->key & 0xFFFFFFFF));
+}
+
+
+const char* VcfMergeReader::getFileName(int inputIndex)
+{
+    return(myInputs[inputIndex]->fileName.c_str());
+}
+
+
+VcfHeader& VcfMergeReader::getHeader(int inputIndex)
+{
+    return(myInputs[inputIndex]->header);
+}
+
+
+VcfRecord& VcfMergeReader::getRecord(int inputIndex)
+{
+    return(*(myInputs[inputIndex]->record));
+}
+
+
+VcfRecord* VcfMergeReader::swapRecord(int inputIndex, VcfRecord* record)
+{
+    VcfRecord* prevRecord = myInputs[inputIndex]->record;
+    myInputs[inputIndex]->record = record;
+    return(prevRecord);
+}
+
+
+void VcfMergeReader::close()
+{
+    for(unsigned int i = 0; i < myInputs.size(); i++)
+    {
+        myInputs[i]->reader.close();
+        delete myInputs[i]->record;
+        delete myInputs[i];
+    }
+    myInputs.clear();
+    myHeap.clear();
+    myLastGroup.clear();
+    myContigIds.clear();
+    myContigNames.clear();
+    myStarted = false;
+    myFirstInputDriven = false;
+    mySeekGap = 0;
+}
+
+
+void VcfMergeReader::advance(int inputIndex)
+{
+    MergeInput& input = *(myInputs[inputIndex]);
+    if(input.eof)
+    {
+        return;
+    }
+    while(!PROFILE_CALL(PROFILE_READ,
+                        input.reader.readRecord(*(input.record), input.subset)))
+    {
+        if(!input.bySection || !nextSection(input))
+        {
+            // No more records in this input.
+            input.eof = true;
+            return;
+        }
+    }
+
+    // Only look up the chromosome rank when the chromosome changes.
+    const char* chrom = input.record->getChromStr();
+    if((input.contigId == -1) || (input.chrom != chrom))
+    {
+        input.chrom = chrom;
+        input.contigId = getContigId(chrom);
+    }
+    uint64_t prevKey = input.key;
+    input.key = makeKey(input.contigId, input.record->get1BasedPosition());
+    if((input.key < prevKey) && !input.reportedOrder)
+    {
+        std::cerr << "Found " << chrom << ":" << input.record->get1BasedPosition()
+                  << " out of order in " << input.fileName
+                  << ", so positions may be skipped\n";
+        input.reportedOrder = true;
+    }
+
+    HeapEntry entry;
+    entry.key = input.key;
+    entry.inputIndex = inputIndex;
+    myHeap.push_back(entry);
+    std::push_heap(myHeap.begin(), myHeap.end(), HeapEntryGreater());
+}
+
+
+void VcfMergeReader::seekToFirstInput()
+{
+    MergeInput& first = *(myInputs[0]);
+    int firstPos = (int)(first.key & 0xFFFFFFFF);
+    for(unsigned int i = 1; i < myInputs.size(); i++)
+    {
+        MergeInput& input = *(myInputs[i]);
+        if(!input.indexed)
+        {
+            continue;
+        }
+        if(input.eof)
+        {
+            // The end of the file or of the last section was reached, so
+            // only try again once the first input is on a new chromosome.
+            if(input.seekContigId == first.contigId)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            if(input.key >= first.key)
+            {
+                // Not behind the first input.
+                continue;
+            }
+            if((input.contigId == first.contigId) &&
+               ((firstPos - (int)(input.key & 0xFFFFFFFF)) <= mySeekGap))
+            {
+                // Close enough to just read the records in between.
+                continue;
+            }
+            removeFromHeap(i);
+        }
+
+        // Jump to the first input's position.
+        input.seekContigId = first.contigId;
+        input.sectionRank = first.contigId;
+        input.eof = false;
+        if(!input.reader.set1BasedReadSection(first.chrom.c_str(), firstPos, -1))
+        {
+            // The chromosome is not in this input.
+            input.eof = true;
+            continue;
+        }
+        advance(i);
+    }
+}
+
+
+void VcfMergeReader::removeFromHeap(int inputIndex)
+{
+    for(unsigned int i = 0; i < myHeap.size(); i++)
+    {
+        if(myHeap[i].inputIndex == inputIndex)
+        {
+            myHeap.erase(myHeap.begin() + i);
+            std::make_heap(myHeap.begin(), myHeap.end(), HeapEntryGreater());
+            return;
+        }
+    }
+}
+
+
+bool VcfMergeReader::nextSection(MergeInput& input)
+{
+    while(++input.sectionRank < (int)myContigNames.size())
+    {
+        if(input.reader.setReadSection(myContigNames[input.sectionRank].c_str()))
+        {
+            return(true);
+        }
+    }
+    return(false);
+}
+
+
+void VcfMergeReader::addHeaderContigs(MergeInput& input)
+{
+    static const char* CONTIG_PREFIX = "##contig=<";
+    static const int CONTIG_PREFIX_LEN = strlen(CONTIG_PREFIX);
+
+    for(int i = 0; i < input.header.getNumMetaLines(); i++)
+    {
+        const char* line = input.header.getMetaLine(i);
+        if((line == NULL) || (strncmp(line, CONTIG_PREFIX, CONTIG_PREFIX_LEN) != 0))
+        {
+            continue;
+        }
+        // Find the ID field.
+        const char* id = line + CONTIG_PREFIX_LEN;
+        while((*id != '\0') && (strncmp(id, "ID=", 3) != 0))
+        {
+            id = strchr(id, ',');
+            if(id == NULL)
+            {
+                break;
+            }
+            ++id;
+        }
+        if((id == NULL) || (*id == '\0'))
+        {
+            continue;
+        }
+        id += 3;
+        int idLen = strcspn(id, ",>");
+        input.headerRanks.push_back(getContigId(std::string(id, idLen).c_str()));
+    }
+}
+
+
+int VcfMergeReader::getContigId(const char* chrom)
+{
+    std::map<std::string, int>::iterator iter = myContigIds.find(chrom);
+    if(iter != myContigIds.end())
+    {
+        return(iter->second);
+    }
+    // New chromosome, so rank it after all the others.
+    int contigId = myContigNames.size();
+    myContigIds[chrom] = contigId;
+    myContigNames.push_back(chrom);
+    return(contigId);
+}
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __VCF_MERGE_READER_H__
+#define __VCF_MERGE_READER_H__
+
+#include <vector>
+#include <map>
+#include <string>
+#include <stdint.h>
+
+#include "VcfFileReader.h"
+
+/// Reads any number of position sorted VCF files in lock step, grouping
+/// the records found at the same chromosome/position in each file.
+/// The inputs are merged through a min-heap keyed on an integer
+/// chromosome rank and the position, so no strings are compared to
+/// determine which input is behind.
+/// Chromosome ranks come from the ##contig header lines, in the order of
+/// the first input followed by any new chromosomes of later inputs.
+/// Chromosomes without a ##contig line are ranked after those with one,
+/// in the order they are first read.
+/// An input with a tabix index whose ##contig lines are in a different
+/// order is read a chromosome at a time in rank order.  Inputs without
+/// an index must have their chromosomes in rank order or positions will
+/// be skipped (a warning is printed if they are found out of order).
+/// When only the positions of the first input are needed, inputs with
+/// a tabix index can jump ahead to the first input's position rather
+/// than reading every record in between.
+class VcfMergeReader
+{
+public:
+    VcfMergeReader();
+    ~VcfMergeReader();
+
+    /// Open the specified VCF as the next input and read its header.
+    /// Returns the index of the new input (the first file opened is 0)
+    /// or -1 if the file could not be opened.
+    int open(const char* filename);
+
+    /// Only keep the specified samples when reading records from
+    /// the specified input.  Must be called before the first call to
+    /// readMergedRecords.
+    void setSampleSubset(int inputIndex, VcfSubsetSamples* subset);
+
+    /// Read the tabix index of the specified input so it can seek.
+    /// Must be called before the first call to readMergedRecords.
+    /// Returns false if the index could not be read.
+    bool readIndex(int inputIndex);
+
+    /// Only the positions in the first input are needed: stop once the
+    /// first input has been read, and have any indexed input that is on
+    /// another chromosome or more than seekGap bases behind the first
+    /// input seek to the first input's position.  Positions that are
+    /// not in the first input may no longer be returned.  Must be called
+    /// before the first call to readMergedRecords.
+    void setFirstInputDriven(int seekGap);
+
+    /// Read the records at the next chromosome/position found in
+    /// any of the inputs.
+    /// present is resized to the number of inputs and set to true
+    /// for each input that has a record at this position.
+    /// Returns false once all records from all inputs have been read.
+    bool readMergedRecords(std::vector<bool>& present);
+
+    /// Get the chromosome of the last merged position.
+    const char* getChromStr();
+    /// Get the 1-based position of the last merged position.
+    int get1BasedPosition();
+
+    int getNumInputs() { return(myInputs.size()); }
+    const char* getFileName(int inputIndex);
+    VcfHeader& getHeader(int inputIndex);
+    /// Get the last record read from the specified input.  Only valid if
+    /// the input was marked as present by the last readMergedRecords.
+    VcfRecord& getRecord(int inputIndex);
+
+    /// Replace the last record read from the specified input with the
+    /// passed in record, returning the record that was read.  Lets the
+    /// caller keep the records while the next position is read.
+    /// Only valid if the input was marked as present by the last
+    /// readMergedRecords.
+    VcfRecord* swapRecord(int inputIndex, VcfRecord* record);
+
+    /// Close all of the inputs.
+    void close();
+
+private:
+    struct MergeInput
+    {
+        std::string fileName;
+        VcfFileReader reader;
+        VcfHeader header;
+        VcfRecord* record;
+        VcfSubsetSamples* subset;
+        std::string chrom;
+        // Rank of the chromosome of the current record.
+        int contigId;
+        uint64_t key;
+        bool eof;
+        bool indexed;
+        // Chromosome of the first input at the last seek, -1 if none.
+        int seekContigId;
+        // Read a chromosome at a time in rank order, currently sectionRank.
+        bool bySection;
+        int sectionRank;
+        // Ranks of the chromosomes in this input's ##contig lines.
+        std::vector<int> headerRanks;
+        bool reportedOrder;
+    };
+
+    // Entry in the merge heap, ordered by key then input index.
+    struct HeapEntry
+    {
+        uint64_t key;
+        int inputIndex;
+    };
+    struct HeapEntryGreater
+    {
+        bool operator()(const HeapEntry& a, const HeapEntry& b) const
+        {
+            if(a.key == b.key)
+            {
+                return(a.inputIndex > b.inputIndex);
+            }
+            return(a.key > b.key);
+        }
+    };
+
+    // Read the next record from the specified input and add it to the heap.
+    void advance(int inputIndex);
+    // Seek indexed inputs that are far behind the first input.
+    void seekToFirstInput();
+    void removeFromHeap(int inputIndex);
+    // Start reading the next chromosome of an input read by section.
+    // Returns false if there are no more chromosomes.
+    bool nextSection(MergeInput& input);
+    // Add the ##contig chromosomes of the header to the rank table.
+    void addHeaderContigs(MergeInput& input);
+    int getContigId(const char* chrom);
+
+    static inline uint64_t makeKey(int contigId, int pos)
+    {
+        return((((uint64_t)contigId) << 32) | (uint32_t)pos);
+    }
+
+    std::vector<MergeInput*> myInputs;
+    std::vector<HeapEntry> myHeap;
+    std::vector<int> myLastGroup;
+    std::map<std::string, int> myContigIds;
+    std::vector<std::string> myContigNames;
+    bool myStarted;
+    bool myFirstInputDriven;
+    int mySeekGap;
+};
+
+#endif
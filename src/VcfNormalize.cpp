@@ -0,0 +1,630 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+#include "VcfNormalize.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Parameters.h"
+#include "BgzfFileType.h"
+#include "GenomeSequence.h"
+#include "ReferenceManager.h"
+#include "ContigCache.h"
+#include "WorkerPool.h"
+#include "Profiler.h"
+
+// Records are normalized in blocks of this many lines, with this many
+// blocks per thread read at a time.
+static const int LINES_PER_BLOCK = 64;
+static const int BLOCKS_PER_THREAD = 4;
+
+// Outcome of normalizing 1 record.
+enum NormalizeStatus
+{
+    NORM_UNCHANGED = 0,
+    NORM_CHANGED,
+    // Symbolic, missing, or malformed alleles/columns.
+    NORM_SKIPPED,
+    NORM_NO_CONTIG,
+    NORM_REF_MISMATCH,
+    NUM_NORM_STATUS
+};
+
+
+// A record line and its position before and after normalization.
+struct NormalizeRecord
+{
+    // Line including the '\n', replaced by the normalized line.
+    std::string line;
+    int chromLen;
+    unsigned long inputPos;
+    unsigned long pos;
+    NormalizeStatus status;
+};
+
+
+static bool sameBase(char base1, char base2)
+{
+    return(toupper((unsigned char)base1) == toupper((unsigned char)base2));
+}
+
+
+static bool isBases(const char* allele, int len)
+{
+    for(int i = 0; i < len; i++)
+    {
+        switch(allele[i])
+        {
+            case 'A': case 'C': case 'G': case 'T': case 'N':
+            case 'a': case 'c': case 'g': case 't': case 'n':
+                break;
+            default:
+                return(false);
+        }
+    }
+    return(len != 0);
+}
+
+
+// Left align and trim the alleles (REF first), updating pos.  Alleles are
+// shifted left at most window bases from their original position.
+static void normalizeAlleles(const ContigCache& contig, unsigned long window,
+                             unsigned long& pos,
+                             std::vector<std::string>& alleles)
+{
+    unsigned long origPos = pos;
+    unsigned int numAlleles = alleles.size();
+    while(true)
+    {
+        // Trim a common last base, extending the alleles left if that
+        // empties one of them.
+        bool allLong = true;
+        bool sameLast = true;
+        char last = alleles[0][alleles[0].size() - 1];
+        for(unsigned int a = 0; a < numAlleles; a++)
+        {
+            allLong &= (alleles[a].size() > 1);
+            sameLast &= sameBase(alleles[a][alleles[a].size() - 1], last);
+        }
+        bool canExtend = (pos > 1) && ((origPos - pos) < window);
+        if(!sameLast || (!allLong && !canExtend))
+        {
+            break;
+        }
+        for(unsigned int a = 0; a < numAlleles; a++)
+        {
+            alleles[a].resize(alleles[a].size() - 1);
+        }
+        if(!allLong)
+        {
+            --pos;
+            char base = contig.getBase(pos);
+            for(unsigned int a = 0; a < numAlleles; a++)
+            {
+                alleles[a].insert(alleles[a].begin(), base);
+            }
+        }
+    }
+
+    // Trim common first bases, leaving at least 1 base in each allele.
+    unsigned int trim = 0;
+    bool trimmable = true;
+    while(trimmable)
+    {
+        for(unsigned int a = 0; a < numAlleles; a++)
+        {
+            if((alleles[a].size() < trim + 2) ||
+               !sameBase(alleles[a][trim], alleles[0][trim]))
+            {
+                trimmable = false;
+                break;
+            }
+        }
+        if(trimmable)
+        {
+            ++trim;
+        }
+    }
+    if(trim != 0)
+    {
+        for(unsigned int a = 0; a < numAlleles; a++)
+        {
+            alleles[a].erase(0, trim);
+        }
+        pos += trim;
+    }
+}
+
+
+// Normalizes the records of a chunk of lines, LINES_PER_BLOCK per block.
+class NormalizeTask : public WorkerTask
+{
+public:
+    NormalizeTask(const GenomeSequence& reference, int numThreads,
+                  unsigned long window)
+        : myThreads(numThreads, ThreadState(reference)),
+          myWindow(window),
+          myRecords(NULL),
+          myNumRecords(0)
+    {
+    }
+
+    void setChunk(std::vector<NormalizeRecord>& records, int numRecords)
+    {
+        myRecords = &records;
+        myNumRecords = numRecords;
+    }
+
+    virtual void runBlock(int blockIndex, int threadIndex)
+    {
+        int end = (blockIndex + 1) * LINES_PER_BLOCK;
+        if(end > myNumRecords)
+        {
+            end = myNumRecords;
+        }
+        PROFILE_ITEMS(PROFILE_TOKENIZE, end - blockIndex * LINES_PER_BLOCK);
+        PROFILE_ITEMS(PROFILE_REFERENCE, end - blockIndex * LINES_PER_BLOCK);
+        for(int r = blockIndex * LINES_PER_BLOCK; r < end; r++)
+        {
+            normalize((*myRecords)[r], myThreads[threadIndex]);
+        }
+    }
+
+private:
+    // Per thread contig lookups & scratch space.
+    struct ThreadState
+    {
+        ThreadState(const GenomeSequence& reference)
+            : contig(reference), alleles(), newLine()
+        {
+        }
+        ContigCache contig;
+        std::vector<std::string> alleles;
+        std::string newLine;
+    };
+
+    void normalize(NormalizeRecord& record, ThreadState& state);
+
+    std::vector<ThreadState> myThreads;
+    unsigned long myWindow;
+    std::vector<NormalizeRecord>* myRecords;
+    int myNumRecords;
+};
+
+
+void NormalizeTask::normalize(NormalizeRecord& record, ThreadState& state)
+{
+    record.status = NORM_SKIPPED;
+    record.chromLen = 0;
+    record.inputPos = 0;
+    record.pos = 0;
+
+    // Find the columns through ALT, leaving the rest untokenized.
+    const char* line = record.line.c_str();
+    const char* lineEnd = line + record.line.size();
+    const char* colEnd[5];
+    const char* colStart = line;
+    {
+        PROFILE_SCOPE(PROFILE_TOKENIZE);
+        for(int c = 0; c < 5; c++)
+        {
+            colEnd[c] = (const char*)memchr(colStart, '\t', lineEnd - colStart);
+            if(colEnd[c] == NULL)
+            {
+                return;
+            }
+            colStart = colEnd[c] + 1;
+        }
+    }
+
+    PROFILE_SCOPE(PROFILE_REFERENCE);
+    record.chromLen = colEnd[0] - line;
+    char* numEnd = NULL;
+    record.inputPos = strtoul(colEnd[0] + 1, &numEnd, 10);
+    record.pos = record.inputPos;
+    if((numEnd != colEnd[1]) || (record.inputPos < 1))
+    {
+        return;
+    }
+
+    const char* ref = colEnd[2] + 1;
+    const char* alt = colEnd[3] + 1;
+    int refLen = colEnd[3] - ref;
+    int altLen = colEnd[4] - alt;
+    if((refLen == 1) && (altLen == 1))
+    {
+        // SNVs are already normalized.
+        record.status = (isBases(ref, 1) && isBases(alt, 1)) ?
+            NORM_UNCHANGED : NORM_SKIPPED;
+        return;
+    }
+
+    // Split the alleles, skipping symbolic, missing, & repeated alleles.
+    std::vector<std::string>& alleles = state.alleles;
+    alleles.resize(1);
+    if(!isBases(ref, refLen))
+    {
+        return;
+    }
+    alleles[0].assign(ref, refLen);
+    const char* altStart = alt;
+    while(altStart <= colEnd[4])
+    {
+        const char* comma = (const char*)memchr(altStart, ',', colEnd[4] - altStart);
+        if(comma == NULL)
+        {
+            comma = colEnd[4];
+        }
+        if(!isBases(altStart, comma - altStart))
+        {
+            return;
+        }
+        alleles.push_back(std::string(altStart, comma - altStart));
+        if(alleles.back().size() == alleles[0].size())
+        {
+            bool same = true;
+            for(unsigned int i = 0; same && (i < alleles[0].size()); i++)
+            {
+                same = sameBase(alleles.back()[i], alleles[0][i]);
+            }
+            if(same)
+            {
+                return;
+            }
+        }
+        altStart = comma + 1;
+    }
+
+    // The REF must match the reference before it can be shifted.
+    ContigCache& contig = state.contig;
+    if(!contig.setContig(line, record.chromLen))
+    {
+        record.status = NORM_NO_CONTIG;
+        return;
+    }
+    if(!contig.contains(record.inputPos, refLen))
+    {
+        record.status = NORM_REF_MISMATCH;
+        return;
+    }
+    for(int i = 0; i < refLen; i++)
+    {
+        if(!sameBase(ref[i], contig.getBase(record.inputPos + i)))
+        {
+            record.status = NORM_REF_MISMATCH;
+            return;
+        }
+    }
+
+    normalizeAlleles(contig, myWindow, record.pos, alleles);
+
+    // Any trimming or shifting changes the position or REF length.
+    if((record.pos == record.inputPos) &&
+       (alleles[0].size() == (unsigned int)refLen))
+    {
+        record.status = NORM_UNCHANGED;
+        return;
+    }
+
+    // Splice the new POS, REF, & ALT between the unchanged columns.
+    std::string& newLine = state.newLine;
+    char posStr[32];
+    snprintf(posStr, sizeof(posStr), "%lu", record.pos);
+    newLine.assign(line, colEnd[0] + 1 - line);
+    newLine += posStr;
+    newLine.append(colEnd[1], ref - colEnd[1]);
+    newLine += alleles[0];
+    newLine += '\t';
+    for(unsigned int a = 1; a < alleles.size(); a++)
+    {
+        if(a != 1)
+        {
+            newLine += ',';
+        }
+        newLine += alleles[a];
+    }
+    newLine.append(colEnd[4], lineEnd - colEnd[4]);
+    record.line.swap(newLine);
+    record.status = NORM_CHANGED;
+}
+
+
+// Holds the normalized records of a contig until no later record can be
+// shifted before them, restoring the sort order of sorted input.
+// Only records within the shift window of the last input position are
+// held, so the buffer is bounded by the window rather than the contig.
+class ReorderBuffer
+{
+public:
+    ReorderBuffer(IFILE outFile, unsigned long window)
+        : myOutFile(outFile),
+          myWindow(window),
+          myRecords(),
+          myChrom(),
+          myLastInputPos(0),
+          myNumAdded(0),
+          myNumUnsorted(0)
+    {
+    }
+
+    /// Add the record, taking its line.
+    void add(NormalizeRecord& record)
+    {
+        if((myChrom.size() != (unsigned int)record.chromLen) ||
+           (myChrom.compare(0, record.chromLen, record.line, 0,
+                            record.chromLen) != 0))
+        {
+            flush();
+            myChrom.assign(record.line, 0, record.chromLen);
+            myLastInputPos = 0;
+        }
+        if(record.inputPos < myLastInputPos)
+        {
+            ++myNumUnsorted;
+        }
+        else
+        {
+            myLastInputPos = record.inputPos;
+        }
+        myRecords[RecordKey(record.pos, myNumAdded++)].swap(record.line);
+
+        // Later records start at or after myLastInputPos - myWindow.
+        if(myLastInputPos > myWindow)
+        {
+            writeThrough(myLastInputPos - myWindow);
+        }
+    }
+
+    /// Write all of the held records.
+    void flush()
+    {
+        writeThrough((unsigned long)-1);
+    }
+
+    /// Number of records that were before the previous record.
+    uint64_t getNumUnsorted() { return(myNumUnsorted); }
+
+private:
+    // Sorted by position then input order.
+    typedef std::pair<unsigned long, uint64_t> RecordKey;
+    typedef std::map<RecordKey, std::string> RecordMap;
+
+    // Write the records at or before the position.
+    void writeThrough(unsigned long pos)
+    {
+        RecordMap::iterator iter = myRecords.begin();
+        while((iter != myRecords.end()) && (iter->first.first <= pos))
+        {
+            ifwrite(myOutFile, iter->second.data(), iter->second.size());
+            myRecords.erase(iter++);
+        }
+    }
+
+    IFILE myOutFile;
+    unsigned long myWindow;
+    RecordMap myRecords;
+    std::string myChrom;
+    unsigned long myLastInputPos;
+    uint64_t myNumAdded;
+    uint64_t myNumUnsorted;
+};
+
+
+void VcfNormalize::vcfNormalizeDescription()
+{
+    std::cerr << " normalize - Left align & trim the alleles against the reference" << std::endl;
+}
+
+
+void VcfNormalize::description()
+{
+    vcfNormalizeDescription();
+}
+
+
+void VcfNormalize::usage()
+{
+    VcfExecutable::usage();
+    std::cerr << "\t./vcf normalize --refFile <referenceFilename> --in <input VCF File> --out <output VCF File> [--threads <num>] [--window <bases>] [--uncompress] [--params]"<< std::endl;
+    std::cerr << "\tRequired Parameters:\n"
+              << "\t\t--refFile : the reference file\n"
+              << "\t\t--in      : sorted VCF file to normalize\n"
+              << "\t\t--out     : new VCF file with left aligned & trimmed alleles\n"
+              << "\tOptional Parameters:\n"
+              << "\t\t--threads    : number of threads for normalizing (default 1)\n"
+              << "\t\t--window     : max number of bases a record is shifted left, which\n"
+              << "\t\t               is also how far back records are held to restore the\n"
+              << "\t\t               sort order (default 1000)\n"
+              << "\t\t--uncompress : write an uncompressed VCF output file\n"
+              << "\t\t--params     : print the parameter settings\n"
+              << "\tRecords with symbolic or missing alleles, or whose REF does not\n"
+              << "\tmatch the reference, are written unchanged.\n"
+              << std::endl;
+}
+
+
+int VcfNormalize::execute(int argc, char **argv)
+{
+    String refFile = "";
+    String inputVcf = "";
+    String outputVcf = "";
+    int numThreads = 1;
+    int window = 1000;
+    bool uncompress = false;
+    bool params = false;
+
+    // Read in the parameters.
+    ParameterList inputParameters;
+    BEGIN_LONG_PARAMETERS(longParameterList)
+        LONG_STRINGPARAMETER("refFile", &refFile)
+        LONG_STRINGPARAMETER("in", &inputVcf)
+        LONG_STRINGPARAMETER("out", &outputVcf)
+        LONG_INTPARAMETER("threads", &numThreads)
+        LONG_INTPARAMETER("window", &window)
+        LONG_PARAMETER("uncompress", &uncompress)
+        LONG_PARAMETER("params", &params)
+        LONG_PHONEHOME(VERSION)
+        END_LONG_PARAMETERS();
+
+    inputParameters.Add(new LongParameters ("Input Parameters",
+                                            longParameterList));
+
+    inputParameters.Read(argc-1, &(argv[1]));
+
+    // Check that all files were specified.
+    if(refFile == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--refFile\", a required parameter.\n\n";
+        return(-1);
+    }
+    if(inputVcf == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--in\", a required parameter.\n\n";
+        return(-1);
+    }
+    if(outputVcf == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--out\", a required parameter.\n\n";
+        return(-1);
+    }
+    if(numThreads < 1)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--threads must be at least 1.\n\n";
+        return(-1);
+    }
+    if(window < 1)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--window must be at least 1.\n\n";
+        return(-1);
+    }
+
+    if(params)
+    {
+        inputParameters.Status();
+    }
+
+    // Open the reference, shared with other processes using it.
+    const GenomeSequence& reference = ReferenceManager::getReference(refFile);
+
+    IFILE inFile = ifopen(inputVcf, "r");
+    if(inFile == NULL)
+    {
+        std::cerr << "Failed to open " << inputVcf << "\n";
+        return(-1);
+    }
+    IFILE outFile = NULL;
+    if(uncompress)
+    {
+        outFile = ifopen(outputVcf, "w", InputFile::DEFAULT);
+    }
+    else
+    {
+        outFile = ifopen(outputVcf, "w", InputFile::BGZF);
+    }
+    if(outFile == NULL)
+    {
+        std::cerr << "Failed to open " << outputVcf << "\n";
+        ifclose(inFile);
+        return(-1);
+    }
+
+    // Chunks of lines are read on this thread, normalized by the workers,
+    // then passed in read order through the reorder buffer.
+    WorkerPool workers(numThreads);
+    NormalizeTask normalizeTask(reference, numThreads, window);
+    ReorderBuffer reorder(outFile, window);
+    std::vector<NormalizeRecord> chunk(numThreads * BLOCKS_PER_THREAD *
+                                       LINES_PER_BLOCK);
+
+    uint64_t statusCounts[NUM_NORM_STATUS] = {0};
+    String line = "";
+    bool moreLines = true;
+    while(moreLines)
+    {
+        int numRecords = 0;
+        while((numRecords < (int)chunk.size()) && !ifeof(inFile))
+        {
+            line.Clear();
+            if(PROFILE_CALL(PROFILE_READ, line.ReadLine(inFile)) < 0)
+            {
+                // Error/end of file, exit loop.
+                break;
+            }
+            if(line.IsEmpty())
+            {
+                continue;
+            }
+            if(line[0] == '#')
+            {
+                // Headers precede the records, so are written as read.
+                line += '\n';
+                ifwrite(outFile, line.c_str(), line.Length());
+                continue;
+            }
+            std::string& recordLine = chunk[numRecords++].line;
+            recordLine.assign(line.c_str(), line.Length());
+            recordLine += '\n';
+        }
+        moreLines = (numRecords == (int)chunk.size());
+
+        normalizeTask.setChunk(chunk, numRecords);
+        workers.run(normalizeTask,
+                    (numRecords + LINES_PER_BLOCK - 1) / LINES_PER_BLOCK);
+        PROFILE_SCOPE(PROFILE_WRITE);
+        for(int r = 0; r < numRecords; r++)
+        {
+            ++statusCounts[chunk[r].status];
+            reorder.add(chunk[r]);
+        }
+    }
+    reorder.flush();
+
+    ifclose(inFile);
+    ifclose(outFile);
+
+    std::cerr << "Records normalized: " << statusCounts[NORM_CHANGED]
+              << ", unchanged: " << statusCounts[NORM_UNCHANGED]
+              << ", skipped: " << statusCounts[NORM_SKIPPED]
+              << ", contig not in reference: " << statusCounts[NORM_NO_CONTIG]
+              << ", REF mismatch: " << statusCounts[NORM_REF_MISMATCH]
+              << "\n";
+    if(reorder.getNumUnsorted() != 0)
+    {
+        std::cerr << "WARNING: " << reorder.getNumUnsorted()
+                  << " records were before the previous record, so the input"
+                  << " and output are not sorted\n";
+    }
+    return(0);
+}
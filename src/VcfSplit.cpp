@@ -22,6 +22,8 @@
 #include "BgzfFileType.h"
 #include "VcfFileReader.h"
 #include "VcfFileWriter.h"
+#include "Profiler.h"
+#include "ProgressReporter.h"
 
 void VcfSplit::vcfSplitDescription()
 {
@@ -48,6 +50,9 @@ void VcfSplit::usage()
               << "\t\t--refName    : the reference (chromosome) name to read\n"
               << "\t\t               Defaults to all references.\n"
               << "\t\t--noeof      : do not expect an EOF block on a BGZF file\n"
+              << "\t\t--progress   : report the progress every this many seconds\n"
+              << "\t\t--statusFile : also write each progress report to this file as JSON,\n"
+              << "\t\t               reporting every 10 seconds if --progress is not set\n"
               << "\t\t--params     : print the parameter settings\n"
               << std::endl;
 }
@@ -63,6 +68,8 @@ int VcfSplit::execute(int argc, char **argv)
     bool uncompress = false;
     bool params = false;
     bool noeof = false;
+    int progressSecs = 0;
+    String statusFile = "";
     
     // Read in the parameters.    
     ParameterList inputParameters;
@@ -74,6 +81,8 @@ int VcfSplit::execute(int argc, char **argv)
         LONG_PARAMETER("uncompress", &uncompress)
         LONG_STRINGPARAMETER("refName", &refName)
         LONG_PARAMETER("noeof", &noeof)
+        LONG_INTPARAMETER("progress", &progressSecs)
+        LONG_STRINGPARAMETER("statusFile", &statusFile)
         LONG_PARAMETER("params", &params)
         LONG_PHONEHOME(VERSION)
         END_LONG_PARAMETERS();
@@ -100,6 +109,18 @@ int VcfSplit::execute(int argc, char **argv)
     }
     outputVcfBase += ".";
 
+    if(progressSecs < 0)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--progress must not be negative.\n\n";
+        return(-1);
+    }
+    if((progressSecs == 0) && !statusFile.IsEmpty())
+    {
+        progressSecs = ProgressReporter::DEFAULT_INTERVAL_SECS;
+    }
+
     if(params)
     {
         inputParameters.Status();
@@ -113,7 +134,7 @@ int VcfSplit::execute(int argc, char **argv)
         BgzfFileType::setRequireEofBlock(false);
     }
 
-    VcfFileReader inFile;
+    ProgressVcfFileReader inFile;
     std::map<std::string, VcfFileWriter*> outFiles;
     VcfHeader header;
     
@@ -128,13 +149,21 @@ int VcfSplit::execute(int argc, char **argv)
     VcfRecord record;
     int numRecords = 0;
 
+    ProgressReporter progress("split", inputVcf);
+    if((progressSecs > 0) && !progress.start(progressSecs, statusFile.c_str()))
+    {
+        std::cerr << "Failed to start the progress reporter thread, so not reporting progress\n";
+    }
+
     std::string prevChr = "";
     std::string chr = "";
     VcfFileWriter* outFilePtr = 0;
     std::string outName = "";
-    while(inFile.readRecord(record))
+    while(PROFILE_CALL(PROFILE_READ, inFile.readRecord(record)))
     {
         ++numRecords;
+        progress.update(record);
+        progress.updateOffset(inFile.getInputFile());
 
         chr = record.getChromStr();
 
@@ -163,8 +192,9 @@ int VcfSplit::execute(int argc, char **argv)
                 }
             }
         }
-        outFilePtr->writeRecord(record);
+        PROFILE_CALL(PROFILE_WRITE, outFilePtr->writeRecord(record));
     }
+    progress.stop();
  
     inFile.close();   
 
@@ -0,0 +1,994 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+#include "VcfStats.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdexcept>
+#include <set>
+
+#include "Parameters.h"
+#include "BgzfFileType.h"
+#include "VcfFileReader.h"
+#include "Tabix.h"
+#include "VcfBatchReader.h"
+#include "PackedGenotype.h"
+#include "WorkerPool.h"
+#include "RegionFilter.h"
+#include "Profiler.h"
+
+// With --threads, records are read in batches of this many records per
+// thread, and this many batches are in use at once.
+static const int BATCH_RECORDS_PER_THREAD = 4;
+static const int NUM_BATCHES = 3;
+
+// Regions closer together than this are read as 1 section.
+static const int SECTION_GAP = 10000;
+
+// 1 past the largest position a tabix index can hold, the end of the last
+// shard of a chromosome.
+static const int INDEX_END = (1 << 29) + 1;
+
+static const char* SITE_HEADER = "#CHROM\tPOS\tID\tREF\tALT\tN_CALLED\tN_MISSING\tMISSING_FRAC\tN_HOM_REF\tN_HET\tN_HOM_ALT\tN_PHASED\tAC\tAN\n";
+
+// Substitution type of a REF/ALT pair.
+enum SnpType {NOT_SNP = 0, TRANSITION, TRANSVERSION};
+
+static SnpType getSnpType(const char* ref, const char* alt)
+{
+    if((ref == NULL) || (alt == NULL) ||
+       (strlen(ref) != 1) || (strlen(alt) != 1))
+    {
+        return(NOT_SNP);
+    }
+    // Purines are A/G, pyrimidines are C/T.
+    static const char* PURINES = "AGag";
+    static const char* PYRIMIDINES = "CTct";
+    bool refPurine = (strchr(PURINES, ref[0]) != NULL);
+    bool altPurine = (strchr(PURINES, alt[0]) != NULL);
+    if((!refPurine && (strchr(PYRIMIDINES, ref[0]) == NULL)) ||
+       (!altPurine && (strchr(PYRIMIDINES, alt[0]) == NULL)) ||
+       (toupper(ref[0]) == toupper(alt[0])))
+    {
+        return(NOT_SNP);
+    }
+    return((refPurine == altPurine) ? TRANSITION : TRANSVERSION);
+}
+
+
+// Genotype counts of 1 sample.
+struct SampleStats
+{
+    uint32_t numMissing;
+    uint32_t numHomRef;
+    uint32_t numHet;
+    uint32_t numHomAlt;
+    uint32_t numPhased;
+    uint32_t numTransitions;
+    uint32_t numTransversions;
+    uint32_t numSingletons;
+
+    void add(const SampleStats& other)
+    {
+        numMissing += other.numMissing;
+        numHomRef += other.numHomRef;
+        numHet += other.numHet;
+        numHomAlt += other.numHomAlt;
+        numPhased += other.numPhased;
+        numTransitions += other.numTransitions;
+        numTransversions += other.numTransversions;
+        numSingletons += other.numSingletons;
+    }
+};
+
+
+// Counts kept by 1 thread, summed once all records are processed.
+struct StatsAccumulator
+{
+    std::vector<SampleStats> samples;
+    uint64_t numSites;
+    uint64_t numSnpAlleles;
+    uint64_t numTransitions;
+    uint64_t numTransversions;
+    uint64_t numSingletons;
+
+    // Per record scratch space.
+    std::vector<uint32_t> packedGTs;
+    std::vector<int> alleleCounts;
+    std::vector<SnpType> snpTypes;
+
+    void init(int numSamples)
+    {
+        SampleStats zero;
+        memset(&zero, 0, sizeof(zero));
+        samples.assign(numSamples, zero);
+        numSites = 0;
+        numSnpAlleles = 0;
+        numTransitions = 0;
+        numTransversions = 0;
+        numSingletons = 0;
+    }
+
+    void add(const StatsAccumulator& other)
+    {
+        for(unsigned int i = 0; i < samples.size(); i++)
+        {
+            samples[i].add(other.samples[i]);
+        }
+        numSites += other.numSites;
+        numSnpAlleles += other.numSnpAlleles;
+        numTransitions += other.numTransitions;
+        numTransversions += other.numTransversions;
+        numSingletons += other.numSingletons;
+    }
+
+    // Add the record's counts, and format its site line.
+    void addRecord(VcfRecord& record, std::string& siteLine);
+};
+
+
+// Count the sample's substitution types for the alt alleles of its GT.
+static inline void addSnpTypes(SampleStats& stats, const std::vector<SnpType>& snpTypes,
+                               int allele1, int allele2)
+{
+    for(int a = 0; a < 2; a++)
+    {
+        int allele = (a == 0) ? allele1 : allele2;
+        if((a == 1) && (allele2 == allele1))
+        {
+            // Count a homozygous alt once.
+            break;
+        }
+        if((allele > 0) && (allele < (int)snpTypes.size()))
+        {
+            stats.numTransitions += (snpTypes[allele] == TRANSITION);
+            stats.numTransversions += (snpTypes[allele] == TRANSVERSION);
+        }
+    }
+}
+
+
+void StatsAccumulator::addRecord(VcfRecord& record, std::string& siteLine)
+{
+    static const std::string GT_FIELD = "GT";
+    PROFILE_SCOPE(PROFILE_PARSE_SAMPLES);
+
+    ++numSites;
+    int numAlleles = record.getNumAlts() + 1;
+    alleleCounts.assign(numAlleles, 0);
+    snpTypes.assign(numAlleles, NOT_SNP);
+    const char* ref = record.getAlleles(0);
+    for(int a = 1; a < numAlleles; a++)
+    {
+        snpTypes[a] = getSnpType(ref, record.getAlleles(a));
+    }
+
+    // Decode all of the GTs once.
+    VcfRecordGenotype& genotypes = record.getGenotypeInfo();
+    int numSamples = record.getNumSamples();
+    if(numSamples > (int)samples.size())
+    {
+        numSamples = samples.size();
+    }
+    packedGTs.resize(numSamples);
+    for(int i = 0; i < numSamples; i++)
+    {
+        packedGTs[i] = PackedGenotype::pack(genotypes.getString(GT_FIELD, i));
+    }
+
+    int numMissing = 0;
+    int numHomRef = 0;
+    int numHet = 0;
+    int numHomAlt = 0;
+    int numPhased = 0;
+    for(int i = 0; i < numSamples; i++)
+    {
+        uint32_t gt = packedGTs[i];
+        SampleStats& stats = samples[i];
+        if(gt == PackedGenotype::NO_GT)
+        {
+            ++stats.numMissing;
+            ++numMissing;
+            continue;
+        }
+        if((gt & PackedGenotype::UNPACKABLE) != 0)
+        {
+            // Not haploid or diploid, so not classified.
+            continue;
+        }
+        int allele1 = PackedGenotype::getAllele1(gt);
+        int allele2 = PackedGenotype::getAllele2(gt);
+        if(allele1 < 0)
+        {
+            // At least 1 allele is missing.
+            ++stats.numMissing;
+            ++numMissing;
+            continue;
+        }
+        if(allele2 >= numAlleles)
+        {
+            // Allele not in ALT, so add it.
+            numAlleles = allele2 + 1;
+            alleleCounts.resize(numAlleles, 0);
+        }
+        ++alleleCounts[allele1];
+        if((gt & PackedGenotype::HAPLOID) == 0)
+        {
+            ++alleleCounts[allele2];
+        }
+
+        if(allele1 != allele2)
+        {
+            ++stats.numHet;
+            ++numHet;
+        }
+        else if(allele1 == 0)
+        {
+            ++stats.numHomRef;
+            ++numHomRef;
+        }
+        else
+        {
+            ++stats.numHomAlt;
+            ++numHomAlt;
+        }
+        if((gt & PackedGenotype::PHASED) != 0)
+        {
+            ++stats.numPhased;
+            ++numPhased;
+        }
+        addSnpTypes(stats, snpTypes, allele1, allele2);
+    }
+
+    // Site counts of the ALT alleles that are present.
+    int an = 0;
+    bool haveSingleton = false;
+    for(int a = 0; a < numAlleles; a++)
+    {
+        an += alleleCounts[a];
+        if((a > 0) && (alleleCounts[a] > 0) && (a < (int)snpTypes.size()) &&
+           (snpTypes[a] != NOT_SNP))
+        {
+            ++numSnpAlleles;
+            numTransitions += (snpTypes[a] == TRANSITION);
+            numTransversions += (snpTypes[a] == TRANSVERSION);
+        }
+        if((a > 0) && (alleleCounts[a] == 1))
+        {
+            haveSingleton = true;
+            ++numSingletons;
+        }
+    }
+
+    // Credit the singletons to the samples that carry them.
+    if(haveSingleton)
+    {
+        for(int i = 0; i < numSamples; i++)
+        {
+            uint32_t gt = packedGTs[i];
+            if((gt == PackedGenotype::NO_GT) || ((gt & PackedGenotype::UNPACKABLE) != 0))
+            {
+                continue;
+            }
+            int allele1 = PackedGenotype::getAllele1(gt);
+            int allele2 = PackedGenotype::getAllele2(gt);
+            if(((allele1 > 0) && (alleleCounts[allele1] == 1)) ||
+               ((allele2 > 0) && (allele2 != allele1) && (alleleCounts[allele2] == 1)))
+            {
+                ++samples[i].numSingletons;
+            }
+        }
+    }
+
+    // Format the site line.
+    char counts[256];
+    int numCalled = numHomRef + numHet + numHomAlt;
+    siteLine = record.getChromStr();
+    snprintf(counts, sizeof(counts), "\t%d\t", record.get1BasedPosition());
+    siteLine += counts;
+    siteLine += record.getIDStr();
+    siteLine += '\t';
+    siteLine += record.getRefStr();
+    siteLine += '\t';
+    siteLine += record.getAltStr();
+    snprintf(counts, sizeof(counts), "\t%d\t%d\t%g\t%d\t%d\t%d\t%d\t",
+             numCalled, numMissing,
+             (numSamples == 0) ? 0 : (double)numMissing/numSamples,
+             numHomRef, numHet, numHomAlt, numPhased);
+    siteLine += counts;
+    for(int a = 1; a < numAlleles; a++)
+    {
+        snprintf(counts, sizeof(counts), (a == 1) ? "%d" : ",%d", alleleCounts[a]);
+        siteLine += counts;
+    }
+    if(numAlleles == 1)
+    {
+        siteLine += '0';
+    }
+    snprintf(counts, sizeof(counts), "\t%d\n", an);
+    siteLine += counts;
+}
+
+
+// Processes the records of a batch, 1 record per block, adding to the
+// accumulator of the thread processing it.
+class StatsTask : public WorkerTask
+{
+public:
+    StatsTask(int numThreads, int batchSize, int numSamples)
+        : accumulators(numThreads),
+          siteLines(batchSize),
+          myBatch(NULL)
+    {
+        for(int t = 0; t < numThreads; t++)
+        {
+            accumulators[t].init(numSamples);
+        }
+    }
+
+    void setBatch(VcfRecordBatch* batch) { myBatch = batch; }
+
+    virtual void runBlock(int blockIndex, int threadIndex)
+    {
+        accumulators[threadIndex].addRecord(*(myBatch->records[blockIndex]),
+                                            siteLines[blockIndex]);
+    }
+
+    std::vector<StatsAccumulator> accumulators;
+    // Site line of each record of the batch.
+    std::vector<std::string> siteLines;
+
+private:
+    VcfRecordBatch* myBatch;
+};
+
+
+// Print the ratio or NA if the denominator is 0.
+static void printRatio(IFILE outFile, uint64_t numerator, uint64_t denominator)
+{
+    if(denominator == 0)
+    {
+        ifprintf(outFile, "\tNA");
+    }
+    else
+    {
+        ifprintf(outFile, "\t%g", (double)numerator/denominator);
+    }
+}
+
+
+// Processes whole shards (sections of an indexed file), 1 shard per
+// block.  Each thread opens its own reader of the file and adds to its own
+// counts, writing the site lines of each shard to a temporary file so the
+// shards can be joined in order once they are all done.
+class StatsShardTask : public WorkerTask
+{
+public:
+    StatsShardTask(const String& inputVcf, const String& sampleSubset,
+                   const String& filterList,
+                   const std::vector<RegionFilter::Section>& shards,
+                   const String& outPrefix, int numThreads, int numSamples)
+        : accumulators(numThreads),
+          error(),
+          myInputVcf(inputVcf),
+          mySampleSubset(sampleSubset),
+          myFilterList(filterList),
+          myShards(shards),
+          myOutPrefix(outPrefix),
+          myReaders(numThreads, (ShardReader*)NULL)
+    {
+        pthread_mutex_init(&myErrorLock, NULL);
+        for(int t = 0; t < numThreads; t++)
+        {
+            accumulators[t].init(numSamples);
+        }
+    }
+
+    ~StatsShardTask()
+    {
+        for(unsigned int t = 0; t < myReaders.size(); t++)
+        {
+            if(myReaders[t] != NULL)
+            {
+                myReaders[t]->reader.close();
+                delete myReaders[t];
+            }
+        }
+        pthread_mutex_destroy(&myErrorLock);
+    }
+
+    // Name of the temporary site file of the shard.
+    String getShardFileName(int shardIndex)
+    {
+        String name = myOutPrefix;
+        name += ".sites.shard";
+        name += shardIndex;
+        return(name);
+    }
+
+    virtual void runBlock(int shardIndex, int threadIndex);
+
+    std::vector<StatsAccumulator> accumulators;
+    // Set to the first failure of any shard.
+    std::string error;
+
+private:
+    // Reader of the file for 1 thread.
+    struct ShardReader
+    {
+        VcfFileReader reader;
+        VcfHeader header;
+        VcfRecord record;
+        RegionFilter regions;
+    };
+
+    ShardReader& getReader(int threadIndex);
+
+    const String& myInputVcf;
+    const String& mySampleSubset;
+    const String& myFilterList;
+    const std::vector<RegionFilter::Section>& myShards;
+    const String& myOutPrefix;
+    std::vector<ShardReader*> myReaders;
+    pthread_mutex_t myErrorLock;
+};
+
+
+StatsShardTask::ShardReader& StatsShardTask::getReader(int threadIndex)
+{
+    if(myReaders[threadIndex] != NULL)
+    {
+        return(*(myReaders[threadIndex]));
+    }
+    ShardReader* in = new ShardReader();
+    myReaders[threadIndex] = in;
+    if(mySampleSubset.IsEmpty())
+    {
+        in->reader.open(myInputVcf, in->header);
+    }
+    else
+    {
+        in->reader.open(myInputVcf, in->header, mySampleSubset, NULL, NULL);
+    }
+    if(!in->reader.readVcfIndex())
+    {
+        throw(std::runtime_error("Failed to read the index for " +
+                                 std::string(myInputVcf.c_str())));
+    }
+    if(!myFilterList.IsEmpty() && !in->regions.load(myFilterList))
+    {
+        throw(std::runtime_error("Failed to open " +
+                                 std::string(myFilterList.c_str())));
+    }
+    return(*in);
+}
+
+
+void StatsShardTask::runBlock(int shardIndex, int threadIndex)
+{
+    String shardFileName = getShardFileName(shardIndex);
+    IFILE siteFile = NULL;
+    try
+    {
+        ShardReader& in = getReader(threadIndex);
+        StatsAccumulator& accumulator = accumulators[threadIndex];
+        const RegionFilter::Section& shard = myShards[shardIndex];
+
+        siteFile = ifopen(shardFileName, "w");
+        if(siteFile == NULL)
+        {
+            throw(std::runtime_error("Failed to open " +
+                                     std::string(shardFileName.c_str())));
+        }
+
+        // A shard without an end runs to the end of the chromosome.  The
+        // section fails if the chromosome has no records in the index.
+        bool haveRecords = false;
+        if(shard.end >= 0)
+        {
+            haveRecords =
+                in.reader.set1BasedReadSection(shard.chrom.c_str(), shard.start,
+                                               shard.end + 1);
+        }
+        else if(shard.start <= 1)
+        {
+            haveRecords = in.reader.setReadSection(shard.chrom.c_str());
+        }
+        else
+        {
+            haveRecords =
+                in.reader.set1BasedReadSection(shard.chrom.c_str(), shard.start,
+                                               INDEX_END);
+        }
+        std::string siteLine;
+        while(haveRecords &&
+              PROFILE_CALL(PROFILE_READ, in.reader.readRecord(in.record)))
+        {
+            if(!myFilterList.IsEmpty() &&
+               !PROFILE_CALL(PROFILE_FILTER,
+                             in.regions.contains(in.record.getChromStr(),
+                                                 in.record.get1BasedPosition())))
+            {
+                continue;
+            }
+            accumulator.addRecord(in.record, siteLine);
+            PROFILE_CALL(PROFILE_WRITE,
+                         ifwrite(siteFile, siteLine.data(), siteLine.size()));
+        }
+    }
+    catch(std::exception& e)
+    {
+        // Pass the failure to the main thread.
+        pthread_mutex_lock(&myErrorLock);
+        if(error.empty())
+        {
+            error = e.what();
+        }
+        pthread_mutex_unlock(&myErrorLock);
+    }
+    if(siteFile != NULL)
+    {
+        ifclose(siteFile);
+    }
+}
+
+
+// Get the chromosomes of the ##contig lines as sections from 1 to their
+// length, or with an end of -1 if they have no length.
+static void getHeaderContigs(VcfHeader& header,
+                             std::vector<RegionFilter::Section>& contigs)
+{
+    static const char* CONTIG_PREFIX = "##contig=<";
+    static const int CONTIG_PREFIX_LEN = strlen(CONTIG_PREFIX);
+
+    RegionFilter::Section contig;
+    for(int i = 0; i < header.getNumMetaLines(); i++)
+    {
+        const char* line = header.getMetaLine(i);
+        if((line == NULL) || (strncmp(line, CONTIG_PREFIX, CONTIG_PREFIX_LEN) != 0))
+        {
+            continue;
+        }
+        contig.chrom.clear();
+        contig.start = 1;
+        contig.end = -1;
+        // Read the comma separated key=value fields.
+        const char* field = line + CONTIG_PREFIX_LEN;
+        while((field != NULL) && (*field != '\0'))
+        {
+            const char* fieldEnd = strpbrk(field, ",>");
+            int fieldLen = (fieldEnd == NULL) ? strlen(field) : (fieldEnd - field);
+            if(strncmp(field, "ID=", 3) == 0)
+            {
+                contig.chrom.assign(field + 3, fieldLen - 3);
+            }
+            else if(strncmp(field, "length=", 7) == 0)
+            {
+                contig.end = atoi(field + 7);
+                if(contig.end < 1)
+                {
+                    contig.end = -1;
+                }
+            }
+            field = ((fieldEnd == NULL) || (*fieldEnd == '>')) ? NULL : (fieldEnd + 1);
+        }
+        if(!contig.chrom.empty())
+        {
+            contigs.push_back(contig);
+        }
+    }
+}
+
+
+// Add a whole chromosome section for each chromosome of the index that
+// is not already in the sections, warning that it has no ##contig line.
+static bool addIndexContigs(VcfFileReader& inFile, const String& inputVcf,
+                            std::vector<RegionFilter::Section>& contigs)
+{
+    const Tabix* index = NULL;
+    if(!inFile.readVcfIndex() || ((index = inFile.getVcfIndex()) == NULL))
+    {
+        std::cerr << "Failed to read the index for " << inputVcf << "\n";
+        return(false);
+    }
+    // Without any ##contig lines, the index alone gives the chromosomes.
+    bool warn = !contigs.empty();
+    std::set<std::string> headerContigs;
+    for(unsigned int i = 0; i < contigs.size(); i++)
+    {
+        headerContigs.insert(contigs[i].chrom);
+    }
+    RegionFilter::Section contig;
+    contig.start = 1;
+    contig.end = -1;
+    for(int i = 0; i < index->getNumRefs(); i++)
+    {
+        // getRefName does not change the index, but is not const.
+        contig.chrom = const_cast<Tabix*>(index)->getRefName(i);
+        if(headerContigs.insert(contig.chrom).second)
+        {
+            if(warn)
+            {
+                std::cerr << "WARNING: " << contig.chrom
+                          << " is in the index but has no ##contig line, so it is 1 shard\n";
+            }
+            contigs.push_back(contig);
+        }
+    }
+    return(true);
+}
+
+
+// Split the sections into shards of at most shardSize bases.  With
+// openEnded, the last shard of each section runs to the end of its
+// chromosome, so records past a ##contig length are still read.
+static void makeShards(const std::vector<RegionFilter::Section>& sections,
+                       int shardSize, bool openEnded,
+                       std::vector<RegionFilter::Section>& shards)
+{
+    RegionFilter::Section shard;
+    for(unsigned int i = 0; i < sections.size(); i++)
+    {
+        const RegionFilter::Section& section = sections[i];
+        if(section.end < 0)
+        {
+            // Unknown length, so 1 shard.
+            shards.push_back(section);
+            continue;
+        }
+        shard.chrom = section.chrom;
+        for(int start = section.start; start <= section.end; start += shardSize)
+        {
+            shard.start = start;
+            shard.end = start + shardSize - 1;
+            if((shard.end > section.end) || (shard.end < start))
+            {
+                shard.end = section.end;
+            }
+            if(shard.end == section.end)
+            {
+                if(openEnded)
+                {
+                    shard.end = -1;
+                }
+                shards.push_back(shard);
+                break;
+            }
+            shards.push_back(shard);
+        }
+    }
+}
+
+
+// Append the temporary site file to the output, and remove it.
+static bool appendFile(const char* fileName, IFILE outFile)
+{
+    IFILE inFile = ifopen(fileName, "r");
+    if(inFile == NULL)
+    {
+        return(false);
+    }
+    char buffer[65536];
+    unsigned int numRead;
+    while((numRead = ifread(inFile, buffer, sizeof(buffer))) > 0)
+    {
+        ifwrite(outFile, buffer, numRead);
+    }
+    ifclose(inFile);
+    remove(fileName);
+    return(true);
+}
+
+
+// Write the per sample counts.
+static bool writeSampleStats(const String& sampleFileName, VcfHeader& header,
+                             const StatsAccumulator& total)
+{
+    IFILE sampleFile = ifopen(sampleFileName, "w");
+    if(sampleFile == NULL)
+    {
+        std::cerr << "Failed to open " << sampleFileName << "\n";
+        return(false);
+    }
+    ifprintf(sampleFile, "#SAMPLE\tN_CALLED\tN_MISSING\tMISSING_FRAC\tN_HOM_REF\tN_HET\tN_HOM_ALT\tHET_HOM_ALT_RATIO\tN_TS\tN_TV\tTS_TV\tN_PHASED\tPHASED_FRAC\tN_SINGLETONS\n");
+    for(unsigned int i = 0; i < total.samples.size(); i++)
+    {
+        const SampleStats& stats = total.samples[i];
+        uint64_t numCalled = stats.numHomRef + stats.numHet + stats.numHomAlt;
+        ifprintf(sampleFile, "%s\t%llu\t%u", header.getSampleName(i),
+                 (unsigned long long)numCalled, stats.numMissing);
+        printRatio(sampleFile, stats.numMissing, total.numSites);
+        ifprintf(sampleFile, "\t%u\t%u\t%u", stats.numHomRef, stats.numHet,
+                 stats.numHomAlt);
+        printRatio(sampleFile, stats.numHet, stats.numHomAlt);
+        ifprintf(sampleFile, "\t%u\t%u", stats.numTransitions,
+                 stats.numTransversions);
+        printRatio(sampleFile, stats.numTransitions, stats.numTransversions);
+        ifprintf(sampleFile, "\t%u", stats.numPhased);
+        printRatio(sampleFile, stats.numPhased, numCalled);
+        ifprintf(sampleFile, "\t%u\n", stats.numSingletons);
+    }
+    ifclose(sampleFile);
+    return(true);
+}
+
+
+void VcfStats::vcfStatsDescription()
+{
+    std::cerr << " stats - Print per sample & per site genotype summary statistics" << std::endl;
+}
+
+
+void VcfStats::description()
+{
+    vcfStatsDescription();
+}
+
+
+void VcfStats::usage()
+{
+    VcfExecutable::usage();
+    std::cerr << "\t./vcfUtil stats --in <input VCF File> --out <output prefix> [--threads <num>] [--shards] [--params]"<< std::endl;
+    std::cerr << "\tRequired Parameters:\n"
+              << "\t\t--in      : VCF file to read\n"
+              << "\t\t--out     : prefix of the output files:\n"
+              << "\t\t            <out>.samples: per sample missing, hom ref, het, hom alt,\n"
+              << "\t\t              het/hom alt ratio, Ti/Tv, phased, & singleton counts\n"
+              << "\t\t            <out>.sites: per site missing, hom ref, het, hom alt,\n"
+              << "\t\t              phased, AC, & AN counts\n"
+              << "\tOptional Parameters:\n"
+              << "\t\t--threads      : number of threads for processing records (default 1)\n"
+              << "\t\t--sampleSubset : file with samples IDs to keep; only their GTs are read.\n"
+              << "\t\t--filterList   : filename of file containing regions to include,\n"
+              << "\t\t                 format: start end\n"
+              << "\t\t                 start & end positions should be 1-based inclusive positions,\n"
+              << "\t\t                 and apply to all chromosomes.\n"
+              << "\t\t                 or BED format: chrom start end\n"
+              << "\t\t                 start is 0-based, end is 1-based (exclusive)\n"
+              << "\t\t--shards       : split the file into shards using its tabix index and\n"
+              << "\t\t                 process each shard on its own, --threads at a time.\n"
+              << "\t\t                 Shards are the --filterList regions (BED required) or\n"
+              << "\t\t                 the ##contig lines, split into --shardSize bases.\n"
+              << "\t\t                 Chromosomes in the index without a ##contig line\n"
+              << "\t\t                 are 1 shard each.\n"
+              << "\t\t--shardSize    : max bases per shard (default 10000000)\n"
+              << "\t\t--params       : print the parameter settings\n"
+              << "\tGTs that are neither haploid nor diploid are not counted.\n"
+              << std::endl;
+}
+
+
+int VcfStats::execute(int argc, char **argv)
+{
+    String inputVcf = "";
+    String outPrefix = "";
+    int numThreads = 1;
+    String sampleSubset = "";
+    String filterList = "";
+    bool shards = false;
+    int shardSize = 10000000;
+    bool params = false;
+
+    // Read in the parameters.
+    ParameterList inputParameters;
+    BEGIN_LONG_PARAMETERS(longParameterList)
+        LONG_PARAMETER_GROUP("Required Parameters")
+        LONG_STRINGPARAMETER("in", &inputVcf)
+        LONG_STRINGPARAMETER("out", &outPrefix)
+        LONG_PARAMETER_GROUP("Optional Parameters")
+        LONG_INTPARAMETER("threads", &numThreads)
+        LONG_STRINGPARAMETER("sampleSubset", &sampleSubset)
+        LONG_STRINGPARAMETER("filterList", &filterList)
+        LONG_PARAMETER("shards", &shards)
+        LONG_INTPARAMETER("shardSize", &shardSize)
+        LONG_PARAMETER("params", &params)
+        LONG_PHONEHOME(VERSION)
+        END_LONG_PARAMETERS();
+
+    inputParameters.Add(new LongParameters ("Input Parameters",
+                                            longParameterList));
+
+    inputParameters.Read(argc-1, &(argv[1]));
+
+    // Check that all files were specified.
+    if(inputVcf == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--in\", a required parameter.\n\n";
+        return(-1);
+    }
+    if(outPrefix == "")
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "Missing \"--out\", a required parameter.\n\n";
+        return(-1);
+    }
+    if(numThreads < 1)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--threads must be at least 1.\n\n";
+        return(-1);
+    }
+    if(shardSize < 1)
+    {
+        usage();
+        inputParameters.Status();
+        std::cerr << "--shardSize must be at least 1.\n\n";
+        return(-1);
+    }
+
+    if(params)
+    {
+        inputParameters.Status();
+    }
+
+    VcfFileReader inFile;
+    VcfHeader header;
+
+    // Open the file
+    if(sampleSubset.IsEmpty())
+    {
+        inFile.open(inputVcf, header);
+    }
+    else
+    {
+        inFile.open(inputVcf, header, sampleSubset, NULL, NULL);
+    }
+
+    RegionFilter regions;
+    if(!filterList.IsEmpty() && !regions.load(filterList))
+    {
+        std::cerr << "Failed to open " << filterList
+                  << ", so keeping all positions\n";
+        filterList.Clear();
+    }
+
+    String sampleFileName = outPrefix + ".samples";
+    String siteFileName = outPrefix + ".sites";
+    IFILE siteFile = ifopen(siteFileName, "w");
+    if(siteFile == NULL)
+    {
+        std::cerr << "Failed to open " << siteFileName << "\n";
+        return(-1);
+    }
+    ifprintf(siteFile, "%s", SITE_HEADER);
+
+    int numSamples = header.getNumSamples();
+    WorkerPool workers(numThreads);
+    // Counts of each thread.
+    std::vector<StatsAccumulator> accumulators;
+
+    if(shards)
+    {
+        // Find the sections of the file to split into shards.
+        std::vector<RegionFilter::Section> sections;
+        if(filterList.IsEmpty())
+        {
+            // The ##contig lines give the lengths, and the index any
+            // chromosomes without one.
+            getHeaderContigs(header, sections);
+            if(!addIndexContigs(inFile, inputVcf, sections))
+            {
+                ifclose(siteFile);
+                return(-1);
+            }
+        }
+        else
+        {
+            if(regions.hasAllChromRegions())
+            {
+                std::cerr << "--shards requires a chromosome column in every --filterList line\n";
+                ifclose(siteFile);
+                return(-1);
+            }
+            regions.getSections(SECTION_GAP, sections);
+        }
+        inFile.close();
+
+        std::vector<RegionFilter::Section> shardList;
+        makeShards(sections, shardSize, filterList.IsEmpty(), shardList);
+
+        // Each shard is processed independently, so the slowest shard
+        // rather than the whole file bounds the time once the shards
+        // outnumber the threads.
+        StatsShardTask shardTask(inputVcf, sampleSubset, filterList,
+                                 shardList, outPrefix, numThreads, numSamples);
+        workers.run(shardTask, shardList.size());
+
+        // Join the shard site files in order.
+        for(unsigned int i = 0; i < shardList.size(); i++)
+        {
+            String shardFileName = shardTask.getShardFileName(i);
+            if(!appendFile(shardFileName, siteFile) && shardTask.error.empty())
+            {
+                shardTask.error = "Failed to read ";
+                shardTask.error += shardFileName.c_str();
+            }
+        }
+        ifclose(siteFile);
+        if(!shardTask.error.empty())
+        {
+            throw(std::runtime_error(shardTask.error));
+        }
+        accumulators.swap(shardTask.accumulators);
+    }
+    else
+    {
+        // Records are processed in batches by the workers, each adding to
+        // its own counts, while the next batch is read on another thread.
+        int batchSize = BATCH_RECORDS_PER_THREAD * numThreads;
+        StatsTask statsTask(numThreads, batchSize, numSamples);
+        VcfBatchReader reader(inFile, batchSize, NUM_BATCHES);
+        reader.setRegions(filterList.IsEmpty() ? NULL : &regions, NULL);
+        if((numThreads > 1) && !reader.start())
+        {
+            std::cerr << "Failed to create the reader thread, so reading on the main thread\n";
+        }
+
+        VcfRecordBatch* batch = NULL;
+        while((batch = reader.next()) != NULL)
+        {
+            statsTask.setBatch(batch);
+            workers.run(statsTask, batch->numRecords);
+            PROFILE_SCOPE(PROFILE_WRITE);
+            for(int r = 0; r < batch->numRecords; r++)
+            {
+                ifwrite(siteFile, statsTask.siteLines[r].data(),
+                        statsTask.siteLines[r].size());
+            }
+            reader.release(batch);
+        }
+        inFile.close();
+        ifclose(siteFile);
+        accumulators.swap(statsTask.accumulators);
+    }
+
+    // Sum the counts from each thread.
+    StatsAccumulator& total = accumulators[0];
+    for(int t = 1; t < numThreads; t++)
+    {
+        total.add(accumulators[t]);
+    }
+
+    if(!writeSampleStats(sampleFileName, header, total))
+    {
+        return(-1);
+    }
+
+    std::cerr << "NumRecords: " << total.numSites
+              << "; Num Samples: " << numSamples
+              << "; SNP Alleles: " << total.numSnpAlleles
+              << "; Ti/Tv: ";
+    if(total.numTransversions == 0)
+    {
+        std::cerr << "NA";
+    }
+    else
+    {
+        std::cerr << (double)total.numTransitions/total.numTransversions;
+    }
+    std::cerr << "; Singletons: " << total.numSingletons << "\n";
+    return(0);
+}
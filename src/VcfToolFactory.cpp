@@ -0,0 +1,108 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+#include "VcfToolFactory.h"
+
+#include "ReplaceReference.h"
+//#include "VcfCooker.h"
+#include "VcfCleaner.h"
+#include "VcfExample.h"
+#include "VcfConvert.h"
+#include "VcfSplit.h"
+#include "VcfMac.h"
+#include "VcfConsensus.h"
+#include "VcfStats.h"
+#include "VcfBench.h"
+#include "VcfFixRef.h"
+#include "VcfNormalize.h"
+#include "VcfBatch.h"
+
+void VcfToolFactory::toolDescriptions()
+{
+    ReplaceReference::replaceReferenceDescription();
+    VcfCleaner::vcfCleanerDescription();
+    VcfConvert:: vcfConvertDescription();
+    VcfSplit:: vcfSplitDescription();
+    VcfMac:: vcfMacDescription();
+    VcfConsensus:: vcfConsensusDescription();
+    VcfStats:: vcfStatsDescription();
+    VcfBench:: vcfBenchDescription();
+    VcfFixRef:: vcfFixRefDescription();
+    VcfNormalize:: vcfNormalizeDescription();
+    VcfBatch:: vcfBatchDescription();
+}
+
+
+VcfExecutable* VcfToolFactory::create(const char* toolName)
+{
+    String cmd = toolName;
+
+    if(cmd.SlowCompare("replaceReference") == 0)
+    {
+        return(new ReplaceReference());
+    }
+    else if(cmd.SlowCompare("cleaner") == 0)
+    {
+        return(new VcfCleaner());
+    }
+//     if(cmd.SlowCompare("vcfCooker") == 0)
+//     {
+//         return(new VcfCooker());
+//     }
+    else if(cmd.SlowCompare("vcfExample") == 0)
+    {
+        return(new VcfExample());
+    }
+    else if(cmd.SlowCompare("convert") == 0)
+    {
+        return(new VcfConvert());
+    }
+    else if(cmd.SlowCompare("split") == 0)
+    {
+        return(new VcfSplit());
+    }
+    else if(cmd.SlowCompare("mac") == 0)
+    {
+        return(new VcfMac());
+    }
+    else if(cmd.SlowCompare("consensus") == 0)
+    {
+        return(new VcfConsensus());
+    }
+    else if(cmd.SlowCompare("stats") == 0)
+    {
+        return(new VcfStats());
+    }
+    else if(cmd.SlowCompare("bench") == 0)
+    {
+        return(new VcfBench());
+    }
+    else if(cmd.SlowCompare("fixref") == 0)
+    {
+        return(new VcfFixRef());
+    }
+    else if(cmd.SlowCompare("normalize") == 0)
+    {
+        return(new VcfNormalize());
+    }
+    else if(cmd.SlowCompare("batch") == 0)
+    {
+        return(new VcfBatch());
+    }
+    return(NULL);
+}
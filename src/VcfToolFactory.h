@@ -0,0 +1,40 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+#ifndef __VCF_TOOL_FACTORY_H__
+#define __VCF_TOOL_FACTORY_H__
+
+#include "VcfExecutable.h"
+
+/// Creates the vcfUtil tools by name, so the command line and the batch
+/// tool dispatch the same set of tools.
+class VcfToolFactory
+{
+public:
+    /// Print the description of every tool.
+    static void toolDescriptions();
+
+    /// Returns a new instance of the named tool, which the caller must
+    /// delete, or NULL if there is no tool with that name.
+    static VcfExecutable* create(const char* toolName);
+
+private:
+    VcfToolFactory();
+};
+
+#endif
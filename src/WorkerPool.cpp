@@ -0,0 +1,155 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int numThreads)
+    : myThreads(),
+      myWorkerInfo(),
+      myTask(NULL),
+      myNumBlocks(0),
+      myNextBlock(0),
+      myNumRunning(0),
+      myGeneration(0),
+      myShutdown(false)
+{
+    pthread_mutex_init(&myLock, NULL);
+    pthread_cond_init(&myStartCond, NULL);
+    pthread_cond_init(&myDoneCond, NULL);
+
+    if(numThreads < 1)
+    {
+        numThreads = 1;
+    }
+    // The calling thread is thread 0, so start 1 less thread.
+    myThreads.resize(numThreads - 1);
+    myWorkerInfo.resize(numThreads - 1);
+    for(unsigned int i = 0; i < myThreads.size(); i++)
+    {
+        myWorkerInfo[i].pool = this;
+        myWorkerInfo[i].threadIndex = i + 1;
+        if(pthread_create(&(myThreads[i]), NULL, workerMain, &(myWorkerInfo[i])) != 0)
+        {
+            throw(std::runtime_error("WorkerPool: failed to create a thread"));
+        }
+    }
+}
+
+
+WorkerPool::~WorkerPool()
+{
+    pthread_mutex_lock(&myLock);
+    myShutdown = true;
+    pthread_cond_broadcast(&myStartCond);
+    pthread_mutex_unlock(&myLock);
+
+    for(unsigned int i = 0; i < myThreads.size(); i++)
+    {
+        pthread_join(myThreads[i], NULL);
+    }
+
+    pthread_cond_destroy(&myDoneCond);
+    pthread_cond_destroy(&myStartCond);
+    pthread_mutex_destroy(&myLock);
+}
+
+
+void WorkerPool::run(WorkerTask& task, int numBlocks)
+{
+    if(myThreads.empty())
+    {
+        // No other threads, so just run all the blocks.
+        for(int i = 0; i < numBlocks; i++)
+        {
+            task.runBlock(i, 0);
+        }
+        return;
+    }
+
+    // Wake up the workers.
+    pthread_mutex_lock(&myLock);
+    myTask = &task;
+    myNumBlocks = numBlocks;
+    myNextBlock = 0;
+    myNumRunning = myThreads.size();
+    ++myGeneration;
+    pthread_cond_broadcast(&myStartCond);
+    pthread_mutex_unlock(&myLock);
+
+    // Process blocks on this thread too.
+    processBlocks(0);
+
+    // Wait for the workers to finish.
+    pthread_mutex_lock(&myLock);
+    while(myNumRunning > 0)
+    {
+        pthread_cond_wait(&myDoneCond, &myLock);
+    }
+    myTask = NULL;
+    pthread_mutex_unlock(&myLock);
+}
+
+
+void* WorkerPool::workerMain(void* arg)
+{
+    WorkerInfo* info = (WorkerInfo*)arg;
+    WorkerPool* pool = info->pool;
+    unsigned int generation = 0;
+
+    pthread_mutex_lock(&(pool->myLock));
+    while(true)
+    {
+        // Wait for a new task or shutdown.
+        while(!pool->myShutdown && (pool->myGeneration == generation))
+        {
+            pthread_cond_wait(&(pool->myStartCond), &(pool->myLock));
+        }
+        if(pool->myShutdown)
+        {
+            break;
+        }
+        generation = pool->myGeneration;
+        pthread_mutex_unlock(&(pool->myLock));
+
+        pool->processBlocks(info->threadIndex);
+
+        pthread_mutex_lock(&(pool->myLock));
+        if(--(pool->myNumRunning) == 0)
+        {
+            pthread_cond_signal(&(pool->myDoneCond));
+        }
+    }
+    pthread_mutex_unlock(&(pool->myLock));
+    return(NULL);
+}
+
+
+void WorkerPool::processBlocks(int threadIndex)
+{
+    while(true)
+    {
+        // Claim the next block.
+        int block = __sync_fetch_and_add(&myNextBlock, 1);
+        if(block >= myNumBlocks)
+        {
+            break;
+        }
+        myTask->runBlock(block, threadIndex);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <pthread.h>
+#include <vector>
+
+/// Work that can be split into independent blocks for a WorkerPool.
+class WorkerTask
+{
+public:
+    virtual ~WorkerTask() {}
+
+    /// Process the specified block.  threadIndex identifies the thread
+    /// running the block (0 to WorkerPool::getNumThreads() - 1), so
+    /// per thread results can be kept without locking.
+    virtual void runBlock(int blockIndex, int threadIndex) = 0;
+};
+
+
+/// Fixed set of threads that run the blocks of a WorkerTask in parallel.
+/// The thread calling run() also processes blocks, so a pool of 1 thread
+/// runs everything on the calling thread without starting any threads.
+class WorkerPool
+{
+public:
+    /// Create a pool that runs tasks on the specified number of threads
+    /// (including the calling thread).
+    WorkerPool(int numThreads);
+    ~WorkerPool();
+
+    int getNumThreads() { return(myThreads.size() + 1); }
+
+    /// Run blocks 0 to numBlocks-1 of the task, returning once all
+    /// blocks have completed.
+    void run(WorkerTask& task, int numBlocks);
+
+private:
+    WorkerPool();
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+
+    struct WorkerInfo
+    {
+        WorkerPool* pool;
+        int threadIndex;
+    };
+
+    static void* workerMain(void* arg);
+    void processBlocks(int threadIndex);
+
+    pthread_mutex_t myLock;
+    pthread_cond_t myStartCond;
+    pthread_cond_t myDoneCond;
+    std::vector<pthread_t> myThreads;
+    std::vector<WorkerInfo> myWorkerInfo;
+
+    WorkerTask* myTask;
+    int myNumBlocks;
+    volatile int myNextBlock;
+    int myNumRunning;
+    unsigned int myGeneration;
+    bool myShutdown;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#!/bin/bash
+
+status=0;
+
+# Replace the job & batch times, which change from run to run.
+removeTimes()
+{
+  sed -e 's/ in [0-9.e+-]* seconds$/ in N seconds/' -e 's/seconds: [0-9.e+-]*$/seconds: N/' $1
+}
+
+../bin/vcfUtil batch --jobs testFiles/batchJobs.txt --noph 2> results/testBatch.log
+let "status |= $?"
+diff results/testBatchMac.txt expected/testMac.txt
+let "status |= $?"
+../bin/vcfUtil mac --binIn results/testBatchMac.bin --noph > results/testBatchMacBinIn.txt 2> results/testBatchMacBinIn.log
+let "status |= $?"
+diff results/testBatchMacBinIn.txt expected/testMac.txt
+let "status |= $?"
+diff results/testBatchMacRegions1.txt expected/testBatchMacRegions.txt
+let "status |= $?"
+diff results/testBatchMacRegions2.txt expected/testBatchMacRegions.txt
+let "status |= $?"
+diff results/testBatchCleaner.vcf expected/testCleaner.vcf
+let "status |= $?"
+diff results/testBatchConsensus.vcf expected/testConsensusDisagree.vcf
+let "status |= $?"
+removeTimes results/testBatch.log > results/testBatchTimes.log
+diff results/testBatchTimes.log expected/testBatch.log
+let "status |= $?"
+
+# The same jobs at the same time, whose messages may be interleaved, so
+# only check their output.
+rm -f results/testBatchMac.txt results/testBatchMac.bin results/testBatchMacRegions?.txt results/testBatchCleaner.vcf results/testBatchConsensus.vcf
+../bin/vcfUtil batch --jobs testFiles/batchJobs.txt --threads 3 --noph 2> results/testBatchThreads.log
+let "status |= $?"
+diff results/testBatchMac.txt expected/testMac.txt
+let "status |= $?"
+../bin/vcfUtil mac --binIn results/testBatchMac.bin --noph > results/testBatchMacBinIn.txt 2> results/testBatchMacBinIn.log
+let "status |= $?"
+diff results/testBatchMacBinIn.txt expected/testMac.txt
+let "status |= $?"
+diff results/testBatchMacRegions1.txt expected/testBatchMacRegions.txt
+let "status |= $?"
+diff results/testBatchMacRegions2.txt expected/testBatchMacRegions.txt
+let "status |= $?"
+diff results/testBatchCleaner.vcf expected/testCleaner.vcf
+let "status |= $?"
+diff results/testBatchConsensus.vcf expected/testConsensusDisagree.vcf
+let "status |= $?"
+
+# Failed jobs, including 1 that throws, fail the batch.
+../bin/vcfUtil batch --jobs testFiles/batchFailJobs.txt --noph 2> results/testBatchFail.log
+if [ $? == 0 ]
+then
+  status=1
+fi
+diff results/testBatchFailMac.txt expected/testMac.txt
+let "status |= $?"
+removeTimes results/testBatchFail.log > results/testBatchFailTimes.log
+diff results/testBatchFailTimes.log expected/testBatchFail.log
+let "status |= $?"
+
+../bin/vcfUtil batch --jobs testFiles/batchFailJobs.txt --stopOnError --noph 2> results/testBatchStop.log
+if [ $? == 0 ]
+then
+  status=1
+fi
+removeTimes results/testBatchStop.log > results/testBatchStopTimes.log
+diff results/testBatchStopTimes.log expected/testBatchStop.log
+let "status |= $?"
+
+# Jobs that can not run in a batch are rejected before any job runs.
+../bin/vcfUtil batch --jobs testFiles/batchInvalidJobs.txt --noph 2> results/testBatchInvalid.log
+if [ $? == 0 ]
+then
+  status=1
+fi
+diff results/testBatchInvalid.log expected/testBatchInvalid.log
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testBatch.sh
+  exit 1
+fi
+
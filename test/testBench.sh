@@ -0,0 +1,54 @@
+#!/bin/bash
+
+status=0;
+
+# Replace the timing & memory results, which change from run to run.
+removeTimes()
+{
+  sed -E -e 's/"version": "[^"]*"/"version": "V"/' \
+         -e 's/"trialSeconds": \[[^]]*\]/"trialSeconds": [N]/' \
+         -e 's/"(bestSeconds|medianSeconds|recordsPerSec|mbPerSec|nsPerRecord|peakRssKB)": [0-9.e+-]+/"\1": N/g' \
+         -e 's/ records, median .*/ records/' $1
+}
+
+../bin/vcfUtil bench --synthetic --numRecords 50 --numSamples 4 --trials 2 --out results/testBenchSynthetic --json results/testBenchSynthetic.json --noph 2> results/testBenchSynthetic.log
+let "status |= $?"
+diff results/testBenchSynthetic.synthetic.vcf expected/testBenchSynthetic.vcf
+let "status |= $?"
+# Copying the lines & writing with VcfFileWriter reproduce the input.
+diff results/testBenchSynthetic.ifile.vcf expected/testBenchSynthetic.vcf
+let "status |= $?"
+diff results/testBenchSynthetic.lib.vcf expected/testBenchSynthetic.vcf
+let "status |= $?"
+removeTimes results/testBenchSynthetic.json > results/testBenchSyntheticTimes.json
+diff results/testBenchSyntheticTimes.json expected/testBenchSynthetic.json
+let "status |= $?"
+removeTimes results/testBenchSynthetic.log > results/testBenchSyntheticTimes.log
+diff results/testBenchSyntheticTimes.log expected/testBenchSynthetic.log
+let "status |= $?"
+
+../bin/vcfUtil bench --in testFiles/testTabix.vcf --backends lib,ifile --trials 1 --out results/testBench --json results/testBench.json --noph 2> results/testBench.log
+let "status |= $?"
+diff results/testBench.ifile.vcf testFiles/testTabix.vcf
+let "status |= $?"
+diff results/testBench.lib.vcf testFiles/testTabix.vcf
+let "status |= $?"
+removeTimes results/testBench.json > results/testBenchTimes.json
+diff results/testBenchTimes.json expected/testBench.json
+let "status |= $?"
+removeTimes results/testBench.log > results/testBenchTimes.log
+diff results/testBenchTimes.log expected/testBench.log
+let "status |= $?"
+
+../bin/vcfUtil bench --in testFiles/testTabix.vcf --readOnly --trials 1 --json results/testBenchReadOnly.json --noph 2> results/testBenchReadOnly.log
+let "status |= $?"
+removeTimes results/testBenchReadOnly.json > results/testBenchReadOnlyTimes.json
+diff results/testBenchReadOnlyTimes.json expected/testBenchReadOnly.json
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testBench.sh
+  exit 1
+fi
+
@@ -0,0 +1,40 @@
+#!/bin/bash
+
+status=0;
+
+../bin/vcfUtil cleaner --in testFiles/cleaner.vcf --out results/testCleaner.vcf --noph --uncompress 2> results/testCleaner.log
+let "status |= $?"
+diff results/testCleaner.vcf expected/testCleaner.vcf
+let "status |= $?"
+diff results/testCleaner.log expected/testCleaner.log
+let "status |= $?"
+
+# The records are cleaned in blocks on the worker threads.
+../bin/vcfUtil cleaner --in testFiles/cleaner.vcf --out results/testCleanerThreads.vcf --threads 3 --noph --uncompress 2> results/testCleanerThreads.log
+let "status |= $?"
+diff results/testCleanerThreads.vcf expected/testCleaner.vcf
+let "status |= $?"
+diff results/testCleanerThreads.log expected/testCleaner.log
+let "status |= $?"
+
+# CRLF lines are cleaned as LF lines.
+../bin/vcfUtil cleaner --in testFiles/cleanerCRLF.vcf --out results/testCleanerCRLF.vcf --noph --uncompress 2> results/testCleanerCRLF.log
+let "status |= $?"
+diff results/testCleanerCRLF.vcf expected/testCleaner.vcf
+let "status |= $?"
+diff results/testCleanerCRLF.log expected/testCleaner.log
+let "status |= $?"
+
+../bin/vcfUtil cleaner --in testFiles/cleanerCRLF.vcf --out results/testCleanerCRLFThreads.vcf --threads 3 --noph --uncompress 2> results/testCleanerCRLFThreads.log
+let "status |= $?"
+diff results/testCleanerCRLFThreads.vcf expected/testCleaner.vcf
+let "status |= $?"
+diff results/testCleanerCRLFThreads.log expected/testCleaner.log
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testCleaner.sh
+  exit 1
+fi
+
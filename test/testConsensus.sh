@@ -53,6 +53,80 @@ let "status |= $?"
 diff results/testConsensus6.log expected/testConsensus6.log
 let "status |= $?"
 
+../bin/vcfUtil consensus --inList testFiles/consensusList4.txt --noph --uncompress --out results/testConsensusList4.vcf 2> results/testConsensusList4.log
+let "status |= $?"
+diff results/testConsensusList4.vcf testFiles/testTabix2.vcf
+let "status |= $?"
+diff results/testConsensusList4.log expected/testConsensusList4.log
+let "status |= $?"
+
+# Files that disagree, so each genotype is voted on.
+../bin/vcfUtil consensus --in1 testFiles/consensusA.vcf --in2 testFiles/consensusB.vcf --in3 testFiles/consensusC.vcf --noph --uncompress --out results/testConsensusDisagree.vcf 2> results/testConsensusDisagree.log
+let "status |= $?"
+diff results/testConsensusDisagree.vcf expected/testConsensusDisagree.vcf
+let "status |= $?"
+diff results/testConsensusDisagree.log expected/testConsensusDisagree.log
+let "status |= $?"
+
+# The same vote with the samples split across threads.
+../bin/vcfUtil consensus --in1 testFiles/consensusA.vcf --in2 testFiles/consensusB.vcf --in3 testFiles/consensusC.vcf --threads 3 --noph --uncompress --out results/testConsensusThreads.vcf 2> results/testConsensusThreads.log
+let "status |= $?"
+diff results/testConsensusThreads.vcf expected/testConsensusDisagree.vcf
+let "status |= $?"
+diff results/testConsensusThreads.log expected/testConsensusDisagree.log
+let "status |= $?"
+
+# Indexed files with extra records to seek over & a different contig order.
+../bin/vcfUtil consensus --in1 testFiles/consensusA.vcf --in2 testFiles/consensusSeekB.vcf.gz --in3 testFiles/consensusOrderC.vcf.gz --seekGap 0 --noph --uncompress --out results/testConsensusSeek.vcf 2> results/testConsensusSeek.log
+let "status |= $?"
+diff results/testConsensusSeek.vcf expected/testConsensusDisagree.vcf
+let "status |= $?"
+diff results/testConsensusSeek.log expected/testConsensusSeek.log
+let "status |= $?"
+
+../bin/vcfUtil consensus --in1 testFiles/consensusA.vcf --in2 testFiles/consensusSeekB.vcf.gz --in3 testFiles/consensusOrderC.vcf.gz --noph --uncompress --out results/testConsensusRead.vcf 2> results/testConsensusRead.log
+let "status |= $?"
+diff results/testConsensusRead.vcf expected/testConsensusDisagree.vcf
+let "status |= $?"
+diff results/testConsensusRead.log expected/testConsensusSeek.log
+let "status |= $?"
+
+# Phased genotypes match the same unphased genotypes.
+../bin/vcfUtil consensus --in1 testFiles/consensusPhasedA.vcf --in2 testFiles/consensusB.vcf --in3 testFiles/consensusC.vcf --noph --uncompress --out results/testConsensusPhased.vcf 2> results/testConsensusPhased.log
+let "status |= $?"
+diff results/testConsensusPhased.vcf expected/testConsensusPhased.vcf
+let "status |= $?"
+diff results/testConsensusPhased.log expected/testConsensusPhased.log
+let "status |= $?"
+
+# 4 files, so ties are written as missing.
+../bin/vcfUtil consensus --inList testFiles/consensusList.txt --noph --uncompress --out results/testConsensusTies.vcf 2> results/testConsensusTies.log
+let "status |= $?"
+diff results/testConsensusTies.vcf expected/testConsensusTies.vcf
+let "status |= $?"
+diff results/testConsensusTies.log expected/testConsensusTies.log
+let "status |= $?"
+
+# The same 4 files weighted to break the ties.
+../bin/vcfUtil consensus --inList testFiles/consensusWeights.txt --noph --uncompress --out results/testConsensusWeights.vcf 2> results/testConsensusWeights.log
+let "status |= $?"
+diff results/testConsensusWeights.vcf expected/testConsensusWeights.vcf
+let "status |= $?"
+diff results/testConsensusWeights.log expected/testConsensusWeights.log
+let "status |= $?"
+
+# Enough samples to be split into several blocks per thread.
+../bin/vcfUtil consensus --in1 testFiles/consensusWideA.vcf.gz --in2 testFiles/consensusWideB.vcf.gz --in3 testFiles/consensusWideC.vcf.gz --noph --uncompress --out results/testConsensusWide1.vcf 2> results/testConsensusWide1.log
+let "status |= $?"
+diff results/testConsensusWide1.log expected/testConsensusWide.log
+let "status |= $?"
+../bin/vcfUtil consensus --in1 testFiles/consensusWideA.vcf.gz --in2 testFiles/consensusWideB.vcf.gz --in3 testFiles/consensusWideC.vcf.gz --threads 3 --noph --uncompress --out results/testConsensusWide3.vcf 2> results/testConsensusWide3.log
+let "status |= $?"
+diff results/testConsensusWide3.vcf results/testConsensusWide1.vcf
+let "status |= $?"
+diff results/testConsensusWide3.log expected/testConsensusWide.log
+let "status |= $?"
+
 if [ $status != 0 ]
 then
   echo failed testConsensus.sh
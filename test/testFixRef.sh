@@ -0,0 +1,30 @@
+#!/bin/bash
+
+status=0;
+
+# Build the packed reference from a fresh copy so the log always reports
+# building it.
+rm -f results/fixref.fa*
+cp testFiles/fixref.fa results/fixref.fa
+
+../bin/vcfUtil fixref --refFile results/fixref.fa --in testFiles/fixref.vcf --out results/testFixRef.vcf --uncompress --noph 2> results/testFixRef.log
+let "status |= $?"
+diff results/testFixRef.vcf expected/testFixRef.vcf
+let "status |= $?"
+diff results/testFixRef.log expected/testFixRef.log
+let "status |= $?"
+
+# The packed reference is reused once built.
+../bin/vcfUtil fixref --refFile results/fixref.fa --in testFiles/fixref.vcf --out results/testFixRefBuilt.vcf --uncompress --noph 2> results/testFixRefBuilt.log
+let "status |= $?"
+diff results/testFixRefBuilt.vcf expected/testFixRef.vcf
+let "status |= $?"
+diff results/testFixRefBuilt.log expected/testFixRefBuilt.log
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testFixRef.sh
+  exit 1
+fi
+
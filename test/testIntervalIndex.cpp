@@ -0,0 +1,393 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the IntervalIndex & Cursor queries against a brute force search
+// of the same intervals.  Prints one line per check & returns non-zero if
+// any query differs.
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "IntervalIndex.h"
+
+// Intervals & queries are generated with a fixed seed so the output is
+// the same everywhere.
+static unsigned int ourSeed = 1;
+
+static int nextRandom(int range)
+{
+    ourSeed = ourSeed * 1103515245 + 12345;
+    return((ourSeed >> 16) % range);
+}
+
+
+// The intervals stored in an index, value i being interval i.
+class Intervals
+{
+public:
+    std::vector<int> starts;
+    std::vector<int> ends;
+    std::vector<int> values;
+
+    void add(int start, int end)
+    {
+        values.push_back(starts.size());
+        starts.push_back(start);
+        ends.push_back(end);
+    }
+
+    // Random intervals up to maxLength long starting in [0, range), some
+    // repeated & some empty (ending before they start).
+    void addRandom(int num, int range, int maxLength)
+    {
+        for(int i = 0; i < num; i++)
+        {
+            int choice = nextRandom(20);
+            if(!starts.empty() && (choice < 2))
+            {
+                int copy = nextRandom(starts.size());
+                add(starts[copy], ends[copy]);
+            }
+            else if(choice == 2)
+            {
+                int start = nextRandom(range);
+                add(start, start - 1);
+            }
+            else
+            {
+                int start = nextRandom(range);
+                add(start, start + nextRandom(maxLength + 1));
+            }
+        }
+    }
+
+    // Values of the intervals intersecting [start, end] (both inclusive).
+    void getIntersecting(int start, int end, std::vector<int>& result)
+    {
+        result.clear();
+        for(unsigned int i = 0; i < starts.size(); i++)
+        {
+            if((starts[i] <= end) && (ends[i] >= start))
+            {
+                result.push_back(values[i]);
+            }
+        }
+    }
+};
+
+
+// Compare the values found by a query, in any order, to the expected ones.
+static bool sameValues(std::vector<int> found, std::vector<int> expected)
+{
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    return(found == expected);
+}
+
+
+// Print the result of a check, returning whether it passed.
+static bool report(const char* name, int numFailed, int numChecked)
+{
+    if(numFailed == 0)
+    {
+        printf("%s: %d ok\n", name, numChecked);
+        return(true);
+    }
+    printf("%s: %d of %d failed\n", name, numFailed, numChecked);
+    return(false);
+}
+
+
+// Add the intervals to the index & build it.
+static void buildIndex(IntervalIndex<int>& index, Intervals& intervals)
+{
+    for(unsigned int i = 0; i < intervals.starts.size(); i++)
+    {
+        index.add(intervals.starts[i], intervals.ends[i], intervals.values[i]);
+    }
+    index.build();
+}
+
+
+// Check the index holds the intervals sorted by start & that positions &
+// ranges across [-2, range + 2) find the same values as a brute force
+// search.  Returns the number of failed checks.
+static int checkIndex(const char* name, IntervalIndex<int>& index,
+                      Intervals& intervals, int range, int& numChecked)
+{
+    int numFailed = 0;
+    std::vector<int> found;
+    std::vector<int> expected;
+
+    ++numChecked;
+    if(index.size() != (int)intervals.values.size())
+    {
+        fprintf(stderr, "%s: index has %d intervals, expected %d\n",
+                name, index.size(), (int)intervals.values.size());
+        return(++numFailed);
+    }
+    for(int i = 0; i < index.size(); i++)
+    {
+        int value = index.getValue(i);
+        ++numChecked;
+        if(((i > 0) && (index.getStart(i) < index.getStart(i - 1))) ||
+           (value < 0) || (value >= (int)intervals.values.size()) ||
+           (index.getStart(i) != intervals.starts[value]) ||
+           (index.getEnd(i) != intervals.ends[value]))
+        {
+            fprintf(stderr, "%s: interval %d is %d-%d with value %d\n", name,
+                    i, index.getStart(i), index.getEnd(i), value);
+            ++numFailed;
+        }
+    }
+
+    for(int pos = -2; pos < range + 2; pos++)
+    {
+        // Values are appended after anything already in the result.
+        found.assign(1, -1);
+        index.getIntersecting(pos, found);
+        found.erase(found.begin());
+        intervals.getIntersecting(pos, pos, expected);
+        ++numChecked;
+        if(!sameValues(found, expected) ||
+           (index.overlaps(pos) != !expected.empty()))
+        {
+            fprintf(stderr, "%s: position %d found %d values, expected %d\n",
+                    name, pos, (int)found.size(), (int)expected.size());
+            ++numFailed;
+        }
+    }
+
+    for(int i = 0; i < range; i++)
+    {
+        int start = nextRandom(range + 4) - 2;
+        int end = start + nextRandom(range / 10 + 1);
+        found.clear();
+        index.getIntersecting(start, end, found);
+        intervals.getIntersecting(start, end, expected);
+        ++numChecked;
+        if(!sameValues(found, expected))
+        {
+            fprintf(stderr, "%s: range %d-%d found %d values, expected %d\n",
+                    name, start, end, (int)found.size(), (int)expected.size());
+            ++numFailed;
+        }
+    }
+    return(numFailed);
+}
+
+
+// Check a cursor finds the same values as a brute force search for each
+// of the positions, in the order given.  Returns the number of failed
+// checks.
+static int checkCursor(const char* name, IntervalIndex<int>::Cursor& cursor,
+                       Intervals& intervals, const std::vector<int>& positions,
+                       int& numChecked)
+{
+    int numFailed = 0;
+    std::vector<int> found;
+    std::vector<int> expected;
+    for(unsigned int i = 0; i < positions.size(); i++)
+    {
+        int pos = positions[i];
+        intervals.getIntersecting(pos, pos, expected);
+        ++numChecked;
+        // Alternate the two queries, as a filter only needing to know
+        // whether a record overlaps would.
+        if((i % 3) == 0)
+        {
+            if(cursor.overlaps(pos) != !expected.empty())
+            {
+                fprintf(stderr, "%s: position %d overlaps is wrong, expected %d values\n",
+                        name, pos, (int)expected.size());
+                ++numFailed;
+            }
+            continue;
+        }
+        found.assign(1, -1);
+        cursor.getIntersecting(pos, found);
+        found.erase(found.begin());
+        if(!sameValues(found, expected))
+        {
+            fprintf(stderr, "%s: position %d found %d values, expected %d\n",
+                    name, pos, (int)found.size(), (int)expected.size());
+            ++numFailed;
+        }
+    }
+    return(numFailed);
+}
+
+
+// Indexes of sizes around the levels of the implicit tree match the brute
+// force search, as do rebuilt & cleared indexes.
+static bool testIndex()
+{
+    bool passed = true;
+    int range = 1000;
+
+    IntervalIndex<int> empty;
+    Intervals none;
+    empty.build();
+    int numChecked = 0;
+    int numFailed = checkIndex("empty", empty, none, 10, numChecked);
+    passed &= report("empty", numFailed, numChecked);
+
+    // Partial & full trees, both smaller & larger than the scanned subtrees.
+    static const int SIZES[] = {1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 33, 100, 2000};
+    numFailed = 0;
+    numChecked = 0;
+    for(unsigned int s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++)
+    {
+        IntervalIndex<int> index;
+        Intervals intervals;
+        intervals.addRandom(SIZES[s], range, 50);
+        buildIndex(index, intervals);
+        numFailed += checkIndex("sizes", index, intervals, range, numChecked);
+    }
+    passed &= report("sizes", numFailed, numChecked);
+
+    // Long intervals containing many shorter ones.
+    IntervalIndex<int> nested;
+    Intervals nestedIntervals;
+    nestedIntervals.addRandom(500, range, 10);
+    for(int i = 0; i < 20; i++)
+    {
+        int start = nextRandom(range);
+        nestedIntervals.add(start, start + nextRandom(range));
+    }
+    buildIndex(nested, nestedIntervals);
+    numChecked = 0;
+    numFailed = checkIndex("nested", nested, nestedIntervals,
+                           range, numChecked);
+    passed &= report("nested", numFailed, numChecked);
+
+    // Adding more intervals & building again keeps the earlier ones.
+    for(int i = 0; i < 200; i++)
+    {
+        int start = nextRandom(range);
+        int end = start + nextRandom(100);
+        nestedIntervals.add(start, end);
+        nested.add(start, end, nestedIntervals.values.back());
+    }
+    nested.build();
+    numChecked = 0;
+    numFailed = checkIndex("rebuilt", nested, nestedIntervals,
+                           range, numChecked);
+    passed &= report("rebuilt", numFailed, numChecked);
+
+    // A cleared index is empty, & can be used again.
+    nested.clear();
+    numChecked = 0;
+    numFailed = checkIndex("cleared", nested, none, range, numChecked);
+    passed &= report("cleared", numFailed, numChecked);
+    Intervals reused;
+    reused.addRandom(300, range, 30);
+    buildIndex(nested, reused);
+    numChecked = 0;
+    numFailed = checkIndex("reused", nested, reused, range, numChecked);
+    passed &= report("reused", numFailed, numChecked);
+    return(passed);
+}
+
+
+// A cursor matches the brute force search for increasing positions,
+// whether dense, repeated, or skipping over intervals, and falls back to
+// searching when a position is smaller than the previous one.
+static bool testCursor()
+{
+    bool passed = true;
+    int range = 1000;
+
+    IntervalIndex<int> index;
+    Intervals intervals;
+    intervals.addRandom(2000, range, 50);
+    for(int i = 0; i < 20; i++)
+    {
+        int start = nextRandom(range);
+        intervals.add(start, start + nextRandom(range / 2));
+    }
+    buildIndex(index, intervals);
+
+    // Every position, some repeated.
+    std::vector<int> positions;
+    for(int pos = -2; pos < range + 60; pos++)
+    {
+        positions.push_back(pos);
+        if(nextRandom(5) == 0)
+        {
+            positions.push_back(pos);
+        }
+    }
+    IntervalIndex<int>::Cursor cursor(index);
+    int numChecked = 0;
+    int numFailed = checkCursor("cursor positions", cursor, intervals,
+                                positions, numChecked);
+    passed &= report("cursor positions", numFailed, numChecked);
+
+    // Positions that skip past many intervals, starting over once the end
+    // is reached as a new contig of a VCF would.
+    std::vector<int> sparse;
+    for(int pass = 0; pass < 3; pass++)
+    {
+        for(int pos = nextRandom(100); pos < range + 60; pos += 1 + nextRandom(60))
+        {
+            sparse.push_back(pos);
+        }
+    }
+    numChecked = 0;
+    numFailed = checkCursor("cursor sparse", cursor, intervals,
+                            sparse, numChecked);
+    passed &= report("cursor sparse", numFailed, numChecked);
+
+    // Positions in random order.
+    std::vector<int> unsorted;
+    for(int i = 0; i < range; i++)
+    {
+        unsorted.push_back(nextRandom(range + 4) - 2);
+    }
+    numChecked = 0;
+    numFailed = checkCursor("cursor unsorted", cursor, intervals,
+                            unsorted, numChecked);
+    passed &= report("cursor unsorted", numFailed, numChecked);
+
+    // After a reset, the cursor starts over from the first position.
+    cursor.reset();
+    numChecked = 0;
+    numFailed = checkCursor("cursor reset", cursor, intervals,
+                            sparse, numChecked);
+    passed &= report("cursor reset", numFailed, numChecked);
+
+    // A cursor over an empty index finds nothing.
+    IntervalIndex<int> empty;
+    Intervals none;
+    empty.build();
+    IntervalIndex<int>::Cursor emptyCursor(empty);
+    numChecked = 0;
+    numFailed = checkCursor("cursor empty", emptyCursor, none,
+                            positions, numChecked);
+    passed &= report("cursor empty", numFailed, numChecked);
+    return(passed);
+}
+
+
+int main(int argc, char** argv)
+{
+    bool passed = testIndex();
+    passed &= testCursor();
+    return(passed ? 0 : 1);
+}
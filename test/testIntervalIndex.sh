@@ -0,0 +1,21 @@
+#!/bin/bash
+
+status=0;
+
+# The index & cursor queries are checked by a small driver built against
+# the tree's sources.
+${CXX:-g++} -O2 -I../src -o results/testIntervalIndex testIntervalIndex.cpp ../src/IntervalIndex.cpp
+let "status |= $?"
+./results/testIntervalIndex > results/testIntervalIndex.txt 2> results/testIntervalIndex.log
+let "status |= $?"
+diff results/testIntervalIndex.txt expected/testIntervalIndex.txt
+let "status |= $?"
+diff results/testIntervalIndex.log /dev/null
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testIntervalIndex.sh
+  exit 1
+fi
+
@@ -0,0 +1,533 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the IntervalTree queries against a brute force search of the
+// same intervals.  Prints one line per check & returns non-zero if any
+// query differs.
+
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "IntervalTree.h"
+#include "FrozenIntervalTree.h"
+
+// Intervals & queries are generated with a fixed seed so the output is
+// the same everywhere.
+static unsigned int ourSeed = 1;
+
+static int nextRandom(int range)
+{
+    ourSeed = ourSeed * 1103515245 + 12345;
+    return((ourSeed >> 16) % range);
+}
+
+
+// The intervals stored in a tree, value i being interval i.
+class Intervals
+{
+public:
+    std::vector<int> starts;
+    std::vector<int> ends;
+    std::vector<int> values;
+
+    void add(int start, int end)
+    {
+        values.push_back(starts.size());
+        starts.push_back(start);
+        ends.push_back(end);
+    }
+
+    // Random intervals up to maxLength long starting in [0, range), some
+    // repeated so nodes hold more than one value.
+    void addRandom(int num, int range, int maxLength)
+    {
+        for(int i = 0; i < num; i++)
+        {
+            if(!starts.empty() && (nextRandom(10) == 0))
+            {
+                int copy = nextRandom(starts.size());
+                add(starts[copy], ends[copy]);
+            }
+            else
+            {
+                int start = nextRandom(range);
+                add(start, start + nextRandom(maxLength + 1));
+            }
+        }
+    }
+
+    // Values of the intervals intersecting [start, end] (both inclusive).
+    void getIntersecting(int start, int end, std::vector<int>& result)
+    {
+        result.clear();
+        for(unsigned int i = 0; i < starts.size(); i++)
+        {
+            if((starts[i] <= end) && (ends[i] >= start))
+            {
+                result.push_back(values[i]);
+            }
+        }
+    }
+
+    int getNumDistinct()
+    {
+        std::vector<std::pair<int, int> > distinct;
+        for(unsigned int i = 0; i < starts.size(); i++)
+        {
+            distinct.push_back(std::make_pair(starts[i], ends[i]));
+        }
+        std::sort(distinct.begin(), distinct.end());
+        return(std::unique(distinct.begin(), distinct.end()) - distinct.begin());
+    }
+};
+
+
+// Compare the values found by a query, in any order, to the expected ones.
+static bool sameValues(std::vector<int> found, std::vector<int> expected)
+{
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    return(found == expected);
+}
+
+
+// Print the result of a check, returning whether it passed.
+static bool report(const char* name, int numFailed, int numChecked)
+{
+    if(numFailed == 0)
+    {
+        printf("%s: %d ok\n", name, numChecked);
+        return(true);
+    }
+    printf("%s: %d of %d failed\n", name, numFailed, numChecked);
+    return(false);
+}
+
+
+// Check the tree holds the intervals & that positions & ranges across
+// [-2, range + 2) find the same values as a brute force search.
+static bool checkTree(const char* name, IntervalTree<int>& tree,
+                      Intervals& intervals, int range)
+{
+    int numFailed = 0;
+    int numChecked = 0;
+    std::vector<int> found;
+    std::vector<int> expected;
+
+    ++numChecked;
+    if((tree.get_values_count() != (int)intervals.values.size()) ||
+       (tree.get_intervals_count() != intervals.getNumDistinct()))
+    {
+        fprintf(stderr, "%s: tree has %d values in %d intervals, expected %d in %d\n",
+                name, tree.get_values_count(), tree.get_intervals_count(),
+                (int)intervals.values.size(), intervals.getNumDistinct());
+        ++numFailed;
+    }
+
+    for(int pos = -2; pos < range + 2; pos++)
+    {
+        found.clear();
+        tree.get_intersecting_intervals(pos, found);
+        intervals.getIntersecting(pos, pos, expected);
+        ++numChecked;
+        if(!sameValues(found, expected))
+        {
+            fprintf(stderr, "%s: position %d found %d values, expected %d\n",
+                    name, pos, (int)found.size(), (int)expected.size());
+            ++numFailed;
+        }
+    }
+
+    for(int i = 0; i < range; i++)
+    {
+        int start = nextRandom(range + 4) - 2;
+        int end = start + nextRandom(range / 10 + 1);
+        found.clear();
+        tree.get_intersecting_intervals(start, end, found);
+        intervals.getIntersecting(start, end, expected);
+        ++numChecked;
+        if(!sameValues(found, expected))
+        {
+            fprintf(stderr, "%s: range %d-%d found %d values, expected %d\n",
+                    name, start, end, (int)found.size(), (int)expected.size());
+            ++numFailed;
+        }
+    }
+    return(report(name, numFailed, numChecked));
+}
+
+
+// Bulk loading matches the brute force search whether or not the input
+// is sorted, and intervals can be added to a bulk loaded tree.
+static bool testBuild()
+{
+    bool passed = true;
+    int range = 1000;
+
+    IntervalTree<int> tree;
+    Intervals intervals;
+    tree.build(intervals.starts, intervals.ends, intervals.values);
+    passed &= checkTree("build empty", tree, intervals, 10);
+
+    intervals.addRandom(2000, range, 50);
+    tree.build(intervals.starts, intervals.ends, intervals.values);
+    passed &= checkTree("build unsorted", tree, intervals, range);
+
+    // The bulk loaded tree is balanced.
+    int maxHeight = 0;
+    while((1 << maxHeight) <= tree.get_intervals_count())
+    {
+        ++maxHeight;
+    }
+    if(tree.get_height() > maxHeight)
+    {
+        printf("build height: %d, expected at most %d\n", tree.get_height(), maxHeight);
+        passed = false;
+    }
+    else
+    {
+        printf("build height: ok\n");
+    }
+
+    // Adding to a bulk loaded tree keeps both its own & the added values.
+    for(int i = 0; i < 500; i++)
+    {
+        int start = nextRandom(range);
+        int end = start + nextRandom(51);
+        intervals.add(start, end);
+        tree.add(start, end, intervals.values.back());
+    }
+    passed &= checkTree("build then add", tree, intervals, range);
+
+    // Building again replaces the tree.
+    Intervals sorted;
+    sorted.addRandom(1000, range, 20);
+    std::vector<std::pair<int, int> > order;
+    for(unsigned int i = 0; i < sorted.starts.size(); i++)
+    {
+        order.push_back(std::make_pair(sorted.starts[i], sorted.ends[i]));
+    }
+    std::sort(order.begin(), order.end());
+    for(unsigned int i = 0; i < order.size(); i++)
+    {
+        sorted.starts[i] = order[i].first;
+        sorted.ends[i] = order[i].second;
+    }
+    tree.build(sorted.starts, sorted.ends, sorted.values);
+    passed &= checkTree("build sorted", tree, sorted, range);
+
+    // Added one at a time, the tree matches too.
+    IntervalTree<int> added;
+    for(unsigned int i = 0; i < sorted.starts.size(); i++)
+    {
+        added.add(sorted.starts[i], sorted.ends[i], sorted.values[i]);
+    }
+    passed &= checkTree("add", added, sorted, range);
+    return(passed);
+}
+
+
+// Check batched queries of [starts[i], ends[i]] return the same values as
+// a brute force search of each, both as values & as counts.
+static bool checkBatch(const char* name, IntervalTree<int>& tree,
+                       Intervals& intervals, std::vector<int>& starts,
+                       std::vector<int>& ends, bool positions)
+{
+    int numFailed = 0;
+    int numChecked = 0;
+    std::vector<int> expected;
+
+    // Values are appended after anything already in the result.
+    std::vector<int> result(3, -1);
+    std::vector<int> offsets;
+    std::vector<int> counts;
+    if(positions)
+    {
+        tree.get_intersecting_intervals(starts, result, offsets);
+        tree.count_intersecting_intervals(starts, counts);
+    }
+    else
+    {
+        tree.get_intersecting_intervals(starts, ends, result, offsets);
+        tree.count_intersecting_intervals(starts, ends, counts);
+    }
+
+    ++numChecked;
+    if((offsets.size() != starts.size() + 1) || (counts.size() != starts.size()) ||
+       (offsets[0] != 3) || (offsets.back() != (int)result.size()))
+    {
+        fprintf(stderr, "%s: %d offsets & %d counts for %d queries\n", name,
+                (int)offsets.size(), (int)counts.size(), (int)starts.size());
+        return(report(name, 1, numChecked));
+    }
+
+    for(unsigned int i = 0; i < starts.size(); i++)
+    {
+        intervals.getIntersecting(starts[i], ends[i], expected);
+        std::vector<int> found(result.begin() + offsets[i],
+                               result.begin() + offsets[i + 1]);
+        ++numChecked;
+        if(!sameValues(found, expected) || (counts[i] != (int)expected.size()))
+        {
+            fprintf(stderr, "%s: query %d-%d found %d values & counted %d, expected %d\n",
+                    name, starts[i], ends[i], (int)found.size(), counts[i],
+                    (int)expected.size());
+            ++numFailed;
+        }
+    }
+    return(report(name, numFailed, numChecked));
+}
+
+
+// The sorted sweep & the count only queries match the brute force search,
+// as does the fallback for unsorted queries.
+static bool testBatch()
+{
+    bool passed = true;
+    int range = 1000;
+
+    // Both bulk loaded & added intervals.
+    IntervalTree<int> tree;
+    Intervals intervals;
+    intervals.addRandom(2000, range, 50);
+    tree.build(intervals.starts, intervals.ends, intervals.values);
+    for(int i = 0; i < 200; i++)
+    {
+        int start = nextRandom(range);
+        int end = start + nextRandom(200);
+        intervals.add(start, end);
+        tree.add(start, end, intervals.values.back());
+    }
+
+    // Every position, some repeated.
+    std::vector<int> positions;
+    for(int pos = -2; pos < range + 60; pos++)
+    {
+        positions.push_back(pos);
+        if(nextRandom(5) == 0)
+        {
+            positions.push_back(pos);
+        }
+    }
+    passed &= checkBatch("sorted positions", tree, intervals, positions, positions, true);
+
+    // Ranges in order of start points, some nested in the previous one.
+    std::vector<int> starts;
+    std::vector<int> ends;
+    for(int start = -10; start < range + 60; start += nextRandom(4))
+    {
+        starts.push_back(start);
+        ends.push_back(start + nextRandom(100));
+    }
+    passed &= checkBatch("sorted ranges", tree, intervals, starts, ends, false);
+
+    // Queries that start past most intervals & skip over gaps.
+    std::vector<int> sparse;
+    for(int pos = range / 2; pos < range + 60; pos += 1 + nextRandom(20))
+    {
+        sparse.push_back(pos);
+    }
+    passed &= checkBatch("sparse positions", tree, intervals, sparse, sparse, true);
+
+    // Intervals added after a sweep, including values for an interval
+    // already in the tree, are found by the next sweep.
+    for(int i = 0; i < 50; i++)
+    {
+        int start = nextRandom(range);
+        int end = start + nextRandom(300);
+        intervals.add(start, end);
+        tree.add(start, end, intervals.values.back());
+    }
+    intervals.add(intervals.starts[0], intervals.ends[0]);
+    tree.add(intervals.starts[0], intervals.ends[0], intervals.values.back());
+    passed &= checkBatch("added positions", tree, intervals, positions, positions, true);
+    passed &= checkBatch("added sparse positions", tree, intervals, sparse, sparse, true);
+
+    std::reverse(positions.begin(), positions.end());
+    passed &= checkBatch("unsorted positions", tree, intervals, positions, positions, true);
+    std::reverse(starts.begin(), starts.end());
+    std::reverse(ends.begin(), ends.end());
+    passed &= checkBatch("unsorted ranges", tree, intervals, starts, ends, false);
+
+    // An empty tree & no queries.
+    IntervalTree<int> empty;
+    Intervals none;
+    passed &= checkBatch("empty tree", empty, none, starts, ends, false);
+    starts.clear();
+    ends.clear();
+    passed &= checkBatch("no queries", tree, intervals, starts, ends, false);
+    return(passed);
+}
+
+
+// Check the values the marks group by deviation are the ones expected,
+// freeing the groups.
+static bool checkMarked(const char* name, FrozenIntervalTree<int>& frozen,
+                        FrozenIntervalTree<int>::Marks& marks,
+                        std::map<int, std::vector<int> >& expected)
+{
+    std::map<int, std::vector<int>* > marked;
+    frozen.get_marked_values(marks, marked);
+
+    int numFailed = 0;
+    if(marked.size() != expected.size())
+    {
+        fprintf(stderr, "%s: %d deviations, expected %d\n", name,
+                (int)marked.size(), (int)expected.size());
+        ++numFailed;
+    }
+    std::map<int, std::vector<int>* >::iterator iter;
+    for(iter = marked.begin(); iter != marked.end(); iter++)
+    {
+        if(!sameValues(*(iter->second), expected[iter->first]))
+        {
+            fprintf(stderr, "%s: deviation %d has %d values, expected %d\n",
+                    name, iter->first, (int)iter->second->size(),
+                    (int)expected[iter->first].size());
+            ++numFailed;
+        }
+        delete iter->second;
+    }
+    return(report(name, numFailed, marked.size() + 1));
+}
+
+
+// The snapshot answers the same as the brute force search & marks the
+// same intervals, keeping its marks apart from other marks & the tree.
+static bool testFrozen()
+{
+    bool passed = true;
+    int range = 1000;
+
+    // Bulk loaded intervals have deviation 0, the added ones beyond them 7.
+    IntervalTree<int> tree;
+    Intervals intervals;
+    intervals.addRandom(2000, range, 50);
+    tree.build(intervals.starts, intervals.ends, intervals.values);
+    std::vector<int> deviations(intervals.values.size(), 0);
+    for(int i = 0; i < 200; i++)
+    {
+        int start = range + nextRandom(range);
+        int end = start + nextRandom(51);
+        intervals.add(start, end);
+        tree.add(start, end, intervals.values.back(), 7);
+        deviations.push_back(7);
+    }
+    range *= 2;
+
+    FrozenIntervalTree<int> frozen(tree);
+    int numIntervals = tree.get_intervals_count();
+    tree.clear();
+
+    // Position & range queries.
+    int numFailed = 0;
+    int numChecked = 1;
+    std::vector<int> found;
+    std::vector<int> expected;
+    if((frozen.get_values_count() != (int)intervals.values.size()) ||
+       (frozen.get_intervals_count() != numIntervals))
+    {
+        fprintf(stderr, "frozen: %d values in %d intervals, expected %d in %d\n",
+                frozen.get_values_count(), frozen.get_intervals_count(),
+                (int)intervals.values.size(), numIntervals);
+        ++numFailed;
+    }
+    for(int pos = -2; pos < range + 60; pos++)
+    {
+        found.clear();
+        frozen.get_intersecting_intervals(pos, found);
+        intervals.getIntersecting(pos, pos, expected);
+        ++numChecked;
+        if(!sameValues(found, expected))
+        {
+            fprintf(stderr, "frozen: position %d found %d values, expected %d\n",
+                    pos, (int)found.size(), (int)expected.size());
+            ++numFailed;
+        }
+    }
+    for(int i = 0; i < range; i++)
+    {
+        int start = nextRandom(range + 4) - 2;
+        int end = start + nextRandom(range / 10 + 1);
+        found.clear();
+        frozen.get_intersecting_intervals(start, end, found);
+        intervals.getIntersecting(start, end, expected);
+        ++numChecked;
+        if(!sameValues(found, expected))
+        {
+            fprintf(stderr, "frozen: range %d-%d found %d values, expected %d\n",
+                    start, end, (int)found.size(), (int)expected.size());
+            ++numFailed;
+        }
+    }
+    passed &= report("frozen", numFailed, numChecked);
+
+    // Unmarked, the intervals keep the deviations they had in the tree.
+    std::map<int, std::vector<int> > unmarked;
+    for(unsigned int i = 0; i < intervals.values.size(); i++)
+    {
+        unmarked[deviations[i]].push_back(intervals.values[i]);
+    }
+    FrozenIntervalTree<int>::Marks marks(frozen);
+    FrozenIntervalTree<int>::Marks otherMarks(frozen);
+    passed &= checkMarked("frozen unmarked", frozen, marks, unmarked);
+
+    // Later marks replace earlier ones.
+    std::vector<int> markedDeviations = deviations;
+    for(int i = 0; i < 100; i++)
+    {
+        int start = nextRandom(range);
+        int end = start + nextRandom(20);
+        int deviation = 10 + nextRandom(5);
+        if(nextRandom(2) == 0)
+        {
+            end = start;
+            frozen.mark_intersecting_intervals(start, deviation, marks);
+        }
+        else
+        {
+            frozen.mark_intersecting_intervals(start, end, deviation, marks);
+        }
+        intervals.getIntersecting(start, end, expected);
+        for(unsigned int j = 0; j < expected.size(); j++)
+        {
+            markedDeviations[expected[j]] = deviation;
+        }
+    }
+    std::map<int, std::vector<int> > marked;
+    for(unsigned int i = 0; i < intervals.values.size(); i++)
+    {
+        marked[markedDeviations[i]].push_back(intervals.values[i]);
+    }
+    passed &= checkMarked("frozen marked", frozen, marks, marked);
+    passed &= checkMarked("frozen other marks", frozen, otherMarks, unmarked);
+
+    marks.reset(frozen);
+    passed &= checkMarked("frozen reset", frozen, marks, unmarked);
+    return(passed);
+}
+
+
+int main(int argc, char** argv)
+{
+    bool passed = testBuild();
+    passed &= testBatch();
+    passed &= testFrozen();
+    return(passed ? 0 : 1);
+}
@@ -0,0 +1,20 @@
+#!/bin/bash
+
+status=0;
+
+# The queries are checked by a small driver built against the tree's sources.
+${CXX:-g++} -O2 -I../src -o results/testIntervalTree testIntervalTree.cpp ../src/Interval.cpp ../src/IntervalTree.cpp ../src/FrozenIntervalTree.cpp ../src/IntervalIndex.cpp
+let "status |= $?"
+./results/testIntervalTree > results/testIntervalTree.txt 2> results/testIntervalTree.log
+let "status |= $?"
+diff results/testIntervalTree.txt expected/testIntervalTree.txt
+let "status |= $?"
+diff results/testIntervalTree.log /dev/null
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testIntervalTree.sh
+  exit 1
+fi
+
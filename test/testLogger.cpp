@@ -0,0 +1,266 @@
+/*
+ *  Copyright (C) 2015  Regents of the University of Michigan
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the asynchronous Logger: messages from several threads, long
+// messages, the rate limit summary & error().  Prints one line per check
+// & returns non-zero if any fails.  Warnings & errors also go to stderr,
+// which the script compares to the expected output.
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Logger.h"
+
+static const int NUM_THREADS = 4;
+// Many times the size of the ring, so producers wait on the writer.
+static const int NUM_MESSAGES = 5000;
+
+static std::string ourDir;
+
+
+// Read the lines of a log.
+static std::vector<std::string> readLines(const std::string& fileName)
+{
+    std::vector<std::string> lines;
+    std::ifstream file(fileName.c_str());
+    std::string line;
+    while(std::getline(file, line))
+    {
+        lines.push_back(line);
+    }
+    return(lines);
+}
+
+
+// Print the result of a check, returning whether it passed.
+static bool report(const char* name, int numFailed, int numChecked)
+{
+    if(numFailed == 0)
+    {
+        printf("%s: %d ok\n", name, numChecked);
+        return(true);
+    }
+    printf("%s: %d of %d failed\n", name, numFailed, numChecked);
+    return(false);
+}
+
+
+struct Producer
+{
+    Logger* logger;
+    int id;
+};
+
+
+static void* produce(void* arg)
+{
+    Producer* producer = (Producer*)arg;
+    for(int i = 0; i < NUM_MESSAGES; i++)
+    {
+        producer->logger->writeLog("thread %d message %d", producer->id, i);
+    }
+    return(NULL);
+}
+
+
+// Every message from several threads is written once, in the order each
+// thread logged them, and messages longer than a ring slot are whole.
+static bool testThreads()
+{
+    std::string fileName = ourDir + "/testLoggerThreads.log";
+    Logger* logger = new Logger(fileName.c_str(), false);
+
+    std::string longMessage(5 * Logger::MAX_MESSAGE, 'x');
+    logger->writeLog("%s", longMessage.c_str());
+
+    pthread_t threads[NUM_THREADS];
+    Producer producers[NUM_THREADS];
+    for(int t = 0; t < NUM_THREADS; t++)
+    {
+        producers[t].logger = logger;
+        producers[t].id = t;
+        pthread_create(&threads[t], NULL, produce, &producers[t]);
+    }
+    for(int t = 0; t < NUM_THREADS; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    logger->writeLog("%s", longMessage.c_str());
+    delete logger;
+
+    std::vector<std::string> lines = readLines(fileName);
+    int numFailed = 0;
+    int numChecked = 0;
+    std::vector<int> next(NUM_THREADS, 0);
+    for(unsigned int i = 0; i < lines.size(); i++)
+    {
+        if((i == 0) || (i + 1 == lines.size()))
+        {
+            ++numChecked;
+            if(lines[i] != longMessage)
+            {
+                fprintf(stderr, "line %d is %d characters, expected the %d character message\n",
+                        i + 1, (int)lines[i].size(), (int)longMessage.size());
+                ++numFailed;
+            }
+            continue;
+        }
+        int id = -1;
+        int message = -1;
+        ++numChecked;
+        if((sscanf(lines[i].c_str(), "thread %d message %d", &id, &message) != 2) ||
+           (id < 0) || (id >= NUM_THREADS) || (message != next[id]))
+        {
+            fprintf(stderr, "line %d is \"%s\"\n", i + 1, lines[i].c_str());
+            ++numFailed;
+            continue;
+        }
+        ++next[id];
+    }
+    ++numChecked;
+    if(lines.size() != NUM_THREADS * NUM_MESSAGES + 2)
+    {
+        fprintf(stderr, "%d lines logged, expected %d\n", (int)lines.size(),
+                NUM_THREADS * NUM_MESSAGES + 2);
+        ++numFailed;
+    }
+    return(report("threads", numFailed, numChecked));
+}
+
+
+// Warnings past the limit are summarized when the logger is destroyed,
+// and other messages are not limited.
+static bool testRepeats()
+{
+    std::string fileName = ourDir + "/testLoggerRepeats.log";
+    Logger* logger = new Logger(fileName.c_str(), false);
+    logger->setMaxRepeats(3);
+    for(int i = 0; i < 10; i++)
+    {
+        logger->warning("repeated warning %d", i);
+        logger->writeLog("info %d", i);
+    }
+    logger->warning("other warning");
+    delete logger;
+
+    std::vector<std::string> expected;
+    for(int i = 0; i < 10; i++)
+    {
+        char line[64];
+        if(i < 3)
+        {
+            sprintf(line, "WARNING: repeated warning %d", i);
+            expected.push_back(line);
+        }
+        sprintf(line, "info %d", i);
+        expected.push_back(line);
+    }
+    expected.push_back("WARNING: other warning");
+    expected.push_back("WARNING: 7 more messages like \"repeated warning %d\" were not logged");
+
+    std::vector<std::string> lines = readLines(fileName);
+    int numFailed = 0;
+    for(unsigned int i = 0; i < expected.size(); i++)
+    {
+        if((i >= lines.size()) || (lines[i] != expected[i]))
+        {
+            fprintf(stderr, "line %d is \"%s\", expected \"%s\"\n", i + 1,
+                    (i < lines.size()) ? lines[i].c_str() : "", expected[i].c_str());
+            ++numFailed;
+        }
+    }
+    if(lines.size() != expected.size())
+    {
+        fprintf(stderr, "%d lines logged, expected %d\n", (int)lines.size(),
+                (int)expected.size());
+        ++numFailed;
+    }
+    return(report("repeats", numFailed, expected.size() + 1));
+}
+
+
+// error() writes everything logged before it, then aborts.
+static bool testError()
+{
+    std::string fileName = ourDir + "/testLoggerError.log";
+    fflush(stdout);
+    fflush(stderr);
+    pid_t child = fork();
+    if(child == 0)
+    {
+        Logger* logger = new Logger(fileName.c_str(), false);
+        for(int i = 0; i < NUM_MESSAGES; i++)
+        {
+            logger->writeLog("message %d", i);
+        }
+        logger->error("failed after %d messages", NUM_MESSAGES);
+        // error() does not return.
+        _exit(0);
+    }
+
+    int numFailed = 0;
+    int status = 0;
+    if((child < 0) || (waitpid(child, &status, 0) != child) ||
+       !WIFSIGNALED(status) || (WTERMSIG(status) != SIGABRT))
+    {
+        fprintf(stderr, "error() did not abort\n");
+        ++numFailed;
+    }
+
+    std::vector<std::string> lines = readLines(fileName);
+    for(int i = 0; i < NUM_MESSAGES; i++)
+    {
+        char expected[64];
+        sprintf(expected, "message %d", i);
+        if((i >= (int)lines.size()) || (lines[i] != expected))
+        {
+            fprintf(stderr, "line %d is not \"%s\"\n", i + 1, expected);
+            ++numFailed;
+            break;
+        }
+    }
+    if((lines.size() != NUM_MESSAGES + 1) ||
+       (lines.back() != "ERROR: failed after 5000 messages"))
+    {
+        fprintf(stderr, "%d lines logged, expected %d ending with the error\n",
+                (int)lines.size(), NUM_MESSAGES + 1);
+        ++numFailed;
+    }
+    return(report("error", numFailed, NUM_MESSAGES + 2));
+}
+
+
+int main(int argc, char** argv)
+{
+    if(argc != 2)
+    {
+        fprintf(stderr, "Usage: testLogger <output directory>\n");
+        return(1);
+    }
+    ourDir = argv[1];
+
+    bool passed = testThreads();
+    passed &= testRepeats();
+    passed &= testError();
+    return(passed ? 0 : 1);
+}
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+status=0;
+
+# The logger is checked by a small driver built against its source and
+# libStatGen (set LIB_PATH_GENERAL as for make, relative to the top level).
+LIB_PATH=${LIB_PATH_VCF_UTIL:-${LIB_PATH_GENERAL:-../libStatGen}}
+if [ "${LIB_PATH:0:1}" != "/" ]
+then
+  LIB_PATH=../$LIB_PATH
+fi
+${CXX:-g++} -O2 -I../src -I$LIB_PATH/include -o results/testLogger testLogger.cpp ../src/Logger.cpp $LIB_PATH/libStatGen.a -lz -lpthread
+let "status |= $?"
+./results/testLogger results > results/testLogger.txt 2> results/testLoggerStderr.log
+let "status |= $?"
+diff results/testLogger.txt expected/testLogger.txt
+let "status |= $?"
+diff results/testLoggerStderr.log expected/testLoggerStderr.log
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testLogger.sh
+  exit 1
+fi
+
@@ -0,0 +1,118 @@
+#!/bin/bash
+
+status=0;
+
+../bin/vcfUtil mac --in testFiles/mac.vcf --noph > results/testMac.txt 2> results/testMac.log
+let "status |= $?"
+diff results/testMac.txt expected/testMac.txt
+let "status |= $?"
+diff results/testMac.log expected/testMac.log
+let "status |= $?"
+
+../bin/vcfUtil mac --in testFiles/mac.vcf --threads 3 --minAC 1 --noph > results/testMacMinAC.txt 2> results/testMacMinAC.log
+let "status |= $?"
+diff results/testMacMinAC.txt expected/testMacMinAC.txt
+let "status |= $?"
+diff results/testMacMinAC.log expected/testMac.log
+let "status |= $?"
+
+# Records are counted on the main thread but read on the reader thread.
+../bin/vcfUtil mac --in testFiles/mac.vcf --threads 3 --minAC 1 --noph --statusFile results/testMacStatus.json > results/testMacStatus.txt 2> results/testMacStatus.log
+let "status |= $?"
+diff results/testMacStatus.txt expected/testMacMinAC.txt
+let "status |= $?"
+sed -e 's/\(PerSec\|Secs\)": [0-9.]*/\1": X/g' results/testMacStatus.json | diff - expected/testMacStatus.json
+let "status |= $?"
+
+# The binary table prints the same as the text output.
+../bin/vcfUtil mac --in testFiles/mac.vcf --binOut results/testMac.bin --noph > results/testMacBinOut.txt 2> results/testMacBinOut.log
+let "status |= $?"
+diff results/testMacBinOut.txt /dev/null
+let "status |= $?"
+diff results/testMacBinOut.log expected/testMac.log
+let "status |= $?"
+../bin/vcfUtil mac --binIn results/testMac.bin --noph > results/testMacBinIn.txt 2> results/testMacBinIn.log
+let "status |= $?"
+diff results/testMacBinIn.txt expected/testMac.txt
+let "status |= $?"
+diff results/testMacBinIn.log expected/testMac.log
+let "status |= $?"
+
+# With threads, records are counted from the line text, as they are read
+# on 1 thread: GT after other subfields, missing GTs, and more alleles.
+../bin/vcfUtil mac --in testFiles/macFormats.vcf --noph > results/testMacFormats.txt 2> results/testMacFormats.log
+let "status |= $?"
+diff results/testMacFormats.txt expected/testMacFormats.txt
+let "status |= $?"
+diff results/testMacFormats.log /dev/null
+let "status |= $?"
+../bin/vcfUtil mac --in testFiles/macFormats.vcf --threads 2 --noph > results/testMacFormatsThreads.txt 2> results/testMacFormatsThreads.log
+let "status |= $?"
+diff results/testMacFormatsThreads.txt expected/testMacFormats.txt
+let "status |= $?"
+diff results/testMacFormatsThreads.log /dev/null
+let "status |= $?"
+../bin/vcfUtil mac --in testFiles/mac.vcf --threads 3 --binOut results/testMacThreads.bin --noph 2> results/testMacThreads.log
+let "status |= $?"
+cmp results/testMacThreads.bin results/testMac.bin
+let "status |= $?"
+diff results/testMacThreads.log /dev/null
+let "status |= $?"
+
+# Only the records in the regions are counted, whether the whole file is
+# read or only the regions' sections are read using the tabix index.
+../bin/vcfUtil mac --in testFiles/mac.vcf --filterList testFiles/macRegions.bed --noph > results/testMacRegions.txt 2> results/testMacRegions.log
+let "status |= $?"
+diff results/testMacRegions.txt expected/testMacRegions.txt
+let "status |= $?"
+diff results/testMacRegions.log /dev/null
+let "status |= $?"
+../bin/vcfUtil mac --in testFiles/mac.vcf.gz --filterList testFiles/macRegions.bed --useIndex --noph > results/testMacRegionsIndex.txt 2> results/testMacRegionsIndex.log
+let "status |= $?"
+diff results/testMacRegionsIndex.txt expected/testMacRegions.txt
+let "status |= $?"
+diff results/testMacRegionsIndex.log /dev/null
+let "status |= $?"
+../bin/vcfUtil mac --in testFiles/mac.vcf.gz --filterList testFiles/macRegions.bed --useIndex --threads 3 --noph > results/testMacRegionsIndexThreads.txt 2> results/testMacRegionsIndexThreads.log
+let "status |= $?"
+diff results/testMacRegionsIndexThreads.txt expected/testMacRegions.txt
+let "status |= $?"
+diff results/testMacRegionsIndexThreads.log /dev/null
+let "status |= $?"
+
+# Truncated & corrupt tables are rejected.
+head -c 100 results/testMac.bin > results/testMacTruncated.bin
+../bin/vcfUtil mac --binIn results/testMacTruncated.bin --noph > results/testMacTruncated.txt 2> results/testMacTruncated.log
+if [ $? == 0 ]
+then
+  status=1
+fi
+diff results/testMacTruncated.log expected/testMacTruncated.log
+let "status |= $?"
+
+cp results/testMac.bin results/testMacNumRecords.bin
+printf '\377\377\377\377\377\377\377\377' | dd of=results/testMacNumRecords.bin bs=1 seek=16 conv=notrunc 2> /dev/null
+../bin/vcfUtil mac --binIn results/testMacNumRecords.bin --noph > results/testMacNumRecords.txt 2> results/testMacNumRecords.log
+if [ $? == 0 ]
+then
+  status=1
+fi
+diff results/testMacNumRecords.log expected/testMacNumRecords.log
+let "status |= $?"
+
+cp results/testMac.bin results/testMacIdOffset.bin
+printf '\377\377\377\377' | dd of=results/testMacIdOffset.bin bs=1 seek=68 conv=notrunc 2> /dev/null
+../bin/vcfUtil mac --binIn results/testMacIdOffset.bin --noph > results/testMacIdOffset.txt 2> results/testMacIdOffset.log
+if [ $? == 0 ]
+then
+  status=1
+fi
+diff results/testMacIdOffset.log expected/testMacIdOffset.log
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testMac.sh
+  exit 1
+fi
+
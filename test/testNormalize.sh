@@ -0,0 +1,37 @@
+#!/bin/bash
+
+status=0;
+
+# Build the packed reference from a fresh copy so the log always reports
+# building it.
+rm -f results/normalize.fa*
+cp testFiles/normalize.fa results/normalize.fa
+
+../bin/vcfUtil normalize --refFile results/normalize.fa --in testFiles/normalize.vcf --out results/testNormalize.vcf --uncompress --noph 2> results/testNormalize.log
+let "status |= $?"
+diff results/testNormalize.vcf expected/testNormalize.vcf
+let "status |= $?"
+diff results/testNormalize.log expected/testNormalize.log
+let "status |= $?"
+
+../bin/vcfUtil normalize --refFile results/normalize.fa --in testFiles/normalize.vcf --out results/testNormalizeThreads.vcf --threads 3 --uncompress --noph 2> results/testNormalizeThreads.log
+let "status |= $?"
+diff results/testNormalizeThreads.vcf expected/testNormalize.vcf
+let "status |= $?"
+diff results/testNormalizeThreads.log expected/testNormalizeBuilt.log
+let "status |= $?"
+
+# Records are shifted at most --window bases.
+../bin/vcfUtil normalize --refFile results/normalize.fa --in testFiles/normalize.vcf --out results/testNormalizeWindow.vcf --window 5 --uncompress --noph 2> results/testNormalizeWindow.log
+let "status |= $?"
+diff results/testNormalizeWindow.vcf expected/testNormalizeWindow.vcf
+let "status |= $?"
+diff results/testNormalizeWindow.log expected/testNormalizeWindow.log
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testNormalize.sh
+  exit 1
+fi
+
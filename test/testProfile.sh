@@ -0,0 +1,38 @@
+#!/bin/bash
+
+status=0;
+
+# --profile is only compiled in with "make PROFILE=1", so build a profiling
+# copy of the tool from the Makefile's sources (unoptimized, since only the
+# reported stages are checked) against libStatGen (set LIB_PATH_GENERAL as
+# for make, relative to the top level).
+LIB_PATH=${LIB_PATH_VCF_UTIL:-${LIB_PATH_GENERAL:-../libStatGen}}
+if [ "${LIB_PATH:0:1}" != "/" ]
+then
+  LIB_PATH=../$LIB_PATH
+fi
+SOURCES="../src/Main.cpp"
+for base in $(sed -n 's/^TOOLBASE *= *//p' ../src/Makefile)
+do
+  SOURCES="$SOURCES ../src/$base.cpp"
+done
+${CXX:-g++} -O0 -DVCF_PROFILE -DVERSION="\"test\"" -DDATE="\"test\"" -DUSER="\"test\"" -I../src -I$LIB_PATH/include -o results/vcfUtilProfile $SOURCES $LIB_PATH/libStatGen.a -lz -lpthread -lrt
+let "status |= $?"
+
+# The stage times vary, but every stage fixref times is reported with
+# its calls.
+rm -f results/fixref.fa*
+cp testFiles/fixref.fa results/fixref.fa
+./results/vcfUtilProfile fixref --refFile results/fixref.fa --in testFiles/fixref.vcf --out results/testProfile.vcf --uncompress --noph --profile results/testProfile.json 2> results/testProfile.log
+let "status |= $?"
+diff results/testProfile.vcf expected/testFixRef.vcf
+let "status |= $?"
+sed -E 's/("wallNs"|"ns"): [0-9]+/\1: X/g' results/testProfile.json > results/testProfileMasked.json
+diff results/testProfileMasked.json expected/testProfile.json
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testProfile.sh
+  exit 1
+fi
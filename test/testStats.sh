@@ -0,0 +1,68 @@
+#!/bin/bash
+
+status=0;
+
+../bin/vcfUtil stats --in testFiles/stats.vcf --out results/testStats --noph 2> results/testStats.log
+let "status |= $?"
+diff results/testStats.samples expected/testStats.samples
+let "status |= $?"
+diff results/testStats.sites expected/testStats.sites
+let "status |= $?"
+diff results/testStats.log expected/testStats.log
+let "status |= $?"
+
+../bin/vcfUtil stats --in testFiles/stats.vcf --out results/testStatsThreads --threads 3 --noph 2> results/testStatsThreads.log
+let "status |= $?"
+diff results/testStatsThreads.samples expected/testStats.samples
+let "status |= $?"
+diff results/testStatsThreads.sites expected/testStats.sites
+let "status |= $?"
+diff results/testStatsThreads.log expected/testStats.log
+let "status |= $?"
+
+# Shards of the ##contig lengths, read using the index.
+../bin/vcfUtil stats --in testFiles/stats.vcf.gz --out results/testStatsShards --shards --shardSize 500 --threads 3 --noph 2> results/testStatsShards.log
+let "status |= $?"
+diff results/testStatsShards.samples expected/testStats.samples
+let "status |= $?"
+diff results/testStatsShards.sites expected/testStats.sites
+let "status |= $?"
+diff results/testStatsShards.log expected/testStats.log
+let "status |= $?"
+
+# Records past a ##contig length, or on a chromosome with no ##contig
+# line, are still in the shards.
+../bin/vcfUtil stats --in testFiles/statsContigs.vcf.gz --out results/testStatsContigs --shards --shardSize 500 --threads 3 --noph 2> results/testStatsContigs.log
+let "status |= $?"
+diff results/testStatsContigs.samples expected/testStats.samples
+let "status |= $?"
+diff results/testStatsContigs.sites expected/testStats.sites
+let "status |= $?"
+diff results/testStatsContigs.log expected/testStatsContigs.log
+let "status |= $?"
+
+../bin/vcfUtil stats --in testFiles/stats.vcf --out results/testStatsSubset --sampleSubset testFiles/statsSubset.txt --filterList testFiles/statsRegions.bed --noph 2> results/testStatsSubset.log
+let "status |= $?"
+diff results/testStatsSubset.samples expected/testStatsSubset.samples
+let "status |= $?"
+diff results/testStatsSubset.sites expected/testStatsSubset.sites
+let "status |= $?"
+diff results/testStatsSubset.log expected/testStatsSubset.log
+let "status |= $?"
+
+# Shards of the --filterList regions.
+../bin/vcfUtil stats --in testFiles/stats.vcf.gz --out results/testStatsSubsetShards --sampleSubset testFiles/statsSubset.txt --filterList testFiles/statsRegions.bed --shards --shardSize 500 --threads 2 --noph 2> results/testStatsSubsetShards.log
+let "status |= $?"
+diff results/testStatsSubsetShards.samples expected/testStatsSubset.samples
+let "status |= $?"
+diff results/testStatsSubsetShards.sites expected/testStatsSubset.sites
+let "status |= $?"
+diff results/testStatsSubsetShards.log expected/testStatsSubset.log
+let "status |= $?"
+
+if [ $status != 0 ]
+then
+  echo failed testStats.sh
+  exit 1
+fi
+